@@ -9,6 +9,9 @@ using stevesch::Histogram;
 void testNumerics();
 void testFloatTiming();
 void testRmsError_rsqrtfApprox();
+void testApproxTiers();
+void testSplines();
+void testStatistics();
 void testRandomNumbers();
 
 void setup()
@@ -20,6 +23,9 @@ void setup()
   testNumerics();
   testFloatTiming();
   testRmsError_rsqrtfApprox();
+  testApproxTiers();
+  testSplines();
+  testStatistics();
   testRandomNumbers();
 
   Serial.println("Setup complete.");
@@ -192,3 +198,238 @@ void testRmsError_rsqrtfApprox()
   double maxPct = 100.0f * maxErrorFactor;
   Serial.printf("rsqrtfApprox RMS error: %8.6f %%  max: %8.6f %%\n", ermsPct, maxPct);
 }
+
+// Error and cost of an approximation f(x, y) of ref(x, y) over x in [a, b),
+// y in [c, d), measured in the same way as testRmsError_rsqrtfApprox.
+// Unary functions ignore y.
+template <typename Approx, typename Ref>
+void reportApprox(const char* name, Approx f, Ref ref, bool relative,
+  float a, float b, float c=0.0f, float d=0.0f)
+{
+  const int testCount = 100000;
+  double sumOfSquares = 0.0;
+  double maxError = 0.0;
+
+  RandGen r(12345);
+  for (int i=0; i<testCount; ++i) {
+    float x = r.getFloatAB(a, b);
+    float y = r.getFloatAB(c, d);
+    double y0 = ref((double)x, (double)y);
+    double e = (double)f(x, y) - y0;
+    if (relative) {
+      e /= y0;
+    }
+    maxError = std::max(maxError, fabs(e));
+    sumOfSquares += e*e;
+  }
+
+  const int timingCount = 1024;
+  const int timingRepeat = 100;
+  static float xs[timingCount];
+  static float ys[timingCount];
+  for (int i=0; i<timingCount; ++i) {
+    xs[i] = r.getFloatAB(a, b);
+    ys[i] = r.getFloatAB(c, d);
+  }
+  long t0 = micros();
+  for (int k=0; k<timingRepeat; ++k) {
+    for (int i=0; i<timingCount; ++i) {
+      volatile float v = f(xs[i], ys[i]);
+      (void)v;
+    }
+  }
+  long t1 = micros();
+  float usecondsPerCall = (float)(t1 - t0) / (float)(timingCount * timingRepeat);
+
+  if (maxError > 0.0) {
+    Serial.printf("%-22s %9.2e  %9.2e  %s  %7.4f us\n", name,
+      sqrt(sumOfSquares / testCount), maxError, relative ? "rel" : "abs", usecondsPerCall);
+  } else {
+    Serial.printf("%-22s %9s  %9s       %7.4f us\n", name, "", "", usecondsPerCall);
+  }
+}
+
+void testApproxTiers()
+{
+  using namespace stevesch;
+  Serial.printf("Approximation tiers:      RMS error  max error       cost\n");
+
+  auto sinRef = [](double x, double) { return sin(x); };
+  reportApprox("sinf", [](float x, float) { return sinf(x); }, sinRef, false, -10.0f, 10.0f);
+  reportApprox("sinApprox", [](float x, float) { return sinApprox(x); }, sinRef, false, -10.0f, 10.0f);
+  reportApprox("sinApprox<3>", [](float x, float) { return sinApprox<3>(x); }, sinRef, false, -10.0f, 10.0f);
+  reportApprox("sinApprox<5>", [](float x, float) { return sinApprox<5>(x); }, sinRef, false, -10.0f, 10.0f);
+  reportApprox("sinApprox<7>", [](float x, float) { return sinApprox<7>(x); }, sinRef, false, -10.0f, 10.0f);
+  reportApprox("sinApprox<9>", [](float x, float) { return sinApprox<9>(x); }, sinRef, false, -10.0f, 10.0f);
+
+  auto cosRef = [](double x, double) { return cos(x); };
+  reportApprox("cosf", [](float x, float) { return cosf(x); }, cosRef, false, -10.0f, 10.0f);
+  reportApprox("cosApprox", [](float x, float) { return cosApprox(x); }, cosRef, false, -10.0f, 10.0f);
+  reportApprox("cosApprox<3>", [](float x, float) { return cosApprox<3>(x); }, cosRef, false, -10.0f, 10.0f);
+  reportApprox("cosApprox<5>", [](float x, float) { return cosApprox<5>(x); }, cosRef, false, -10.0f, 10.0f);
+  reportApprox("cosApprox<7>", [](float x, float) { return cosApprox<7>(x); }, cosRef, false, -10.0f, 10.0f);
+  reportApprox("cosApprox<9>", [](float x, float) { return cosApprox<9>(x); }, cosRef, false, -10.0f, 10.0f);
+
+  // both results of one call, checked separately
+  reportApprox("cosSinf:s", [](float x, float) { float s, c; cosSinf(x, &c, &s); return s; }, sinRef, false, -10.0f, 10.0f);
+  reportApprox("sinCosApprox<3>:s", [](float x, float) { float s, c; sinCosApprox<3>(x, &s, &c); return s; }, sinRef, false, -10.0f, 10.0f);
+  reportApprox("sinCosApprox<3>:c", [](float x, float) { float s, c; sinCosApprox<3>(x, &s, &c); return c; }, cosRef, false, -10.0f, 10.0f);
+  reportApprox("sinCosApprox<5>:s", [](float x, float) { float s, c; sinCosApprox<5>(x, &s, &c); return s; }, sinRef, false, -10.0f, 10.0f);
+  reportApprox("sinCosApprox<5>:c", [](float x, float) { float s, c; sinCosApprox<5>(x, &s, &c); return c; }, cosRef, false, -10.0f, 10.0f);
+  reportApprox("sinCosApprox<7>:s", [](float x, float) { float s, c; sinCosApprox<7>(x, &s, &c); return s; }, sinRef, false, -10.0f, 10.0f);
+  reportApprox("sinCosApprox<7>:c", [](float x, float) { float s, c; sinCosApprox<7>(x, &s, &c); return c; }, cosRef, false, -10.0f, 10.0f);
+
+  // relative error, kept away from the poles at +-pi/2
+  auto tanRef = [](double x, double) { return tan(x); };
+  reportApprox("tanf", [](float x, float) { return tanf(x); }, tanRef, true, -1.5f, 1.5f);
+  reportApprox("tanApprox<3>", [](float x, float) { return tanApprox<3>(x); }, tanRef, true, -1.5f, 1.5f);
+  reportApprox("tanApprox<5>", [](float x, float) { return tanApprox<5>(x); }, tanRef, true, -1.5f, 1.5f);
+  reportApprox("tanApprox<7>", [](float x, float) { return tanApprox<7>(x); }, tanRef, true, -1.5f, 1.5f);
+  reportApprox("tanApprox<9>", [](float x, float) { return tanApprox<9>(x); }, tanRef, true, -1.5f, 1.5f);
+
+  auto atan2Ref = [](double x, double y) { return atan2(y, x); };
+  reportApprox("atan2f", [](float x, float y) { return atan2f(y, x); }, atan2Ref, false, -1.0f, 1.0f, -1.0f, 1.0f);
+  reportApprox("atan2Approx<5>", [](float x, float y) { return atan2Approx<5>(y, x); }, atan2Ref, false, -1.0f, 1.0f, -1.0f, 1.0f);
+  reportApprox("atan2Approx<7>", [](float x, float y) { return atan2Approx<7>(y, x); }, atan2Ref, false, -1.0f, 1.0f, -1.0f, 1.0f);
+  reportApprox("atan2Approx<9>", [](float x, float y) { return atan2Approx<9>(y, x); }, atan2Ref, false, -1.0f, 1.0f, -1.0f, 1.0f);
+  reportApprox("atan2Approx<11>", [](float x, float y) { return atan2Approx<11>(y, x); }, atan2Ref, false, -1.0f, 1.0f, -1.0f, 1.0f);
+  reportApprox("atan2Approx<13>", [](float x, float y) { return atan2Approx<13>(y, x); }, atan2Ref, false, -1.0f, 1.0f, -1.0f, 1.0f);
+
+  auto expRef = [](double x, double) { return exp(x); };
+  reportApprox("expf", [](float x, float) { return expf(x); }, expRef, true, -80.0f, 80.0f);
+  reportApprox("expApprox<3>", [](float x, float) { return expApprox<3>(x); }, expRef, true, -80.0f, 80.0f);
+  reportApprox("expApprox<4>", [](float x, float) { return expApprox<4>(x); }, expRef, true, -80.0f, 80.0f);
+  reportApprox("expApprox<5>", [](float x, float) { return expApprox<5>(x); }, expRef, true, -80.0f, 80.0f);
+  reportApprox("expApprox<6>", [](float x, float) { return expApprox<6>(x); }, expRef, true, -80.0f, 80.0f);
+
+  auto logRef = [](double x, double) { return log(x); };
+  reportApprox("logf", [](float x, float) { return logf(x); }, logRef, false, 1.0e-3f, 1.0e+3f);
+  reportApprox("logApprox<3>", [](float x, float) { return logApprox<3>(x); }, logRef, false, 1.0e-3f, 1.0e+3f);
+  reportApprox("logApprox<5>", [](float x, float) { return logApprox<5>(x); }, logRef, false, 1.0e-3f, 1.0e+3f);
+  reportApprox("logApprox<7>", [](float x, float) { return logApprox<7>(x); }, logRef, false, 1.0e-3f, 1.0e+3f);
+
+  auto powRef = [](double x, double y) { return pow(x, y); };
+  reportApprox("powf", [](float x, float y) { return powf(x, y); }, powRef, true, 0.1f, 10.0f, -4.0f, 4.0f);
+  reportApprox("powApprox<3>", [](float x, float y) { return powApprox<3>(x, y); }, powRef, true, 0.1f, 10.0f, -4.0f, 4.0f);
+  reportApprox("powApprox<4>", [](float x, float y) { return powApprox<4>(x, y); }, powRef, true, 0.1f, 10.0f, -4.0f, 4.0f);
+  reportApprox("powApprox<5>", [](float x, float y) { return powApprox<5>(x, y); }, powRef, true, 0.1f, 10.0f, -4.0f, 4.0f);
+  reportApprox("powApprox<6>", [](float x, float y) { return powApprox<6>(x, y); }, powRef, true, 0.1f, 10.0f, -4.0f, 4.0f);
+
+  auto rsqrtRef = [](double x, double) { return 1.0 / sqrt(x); };
+  reportApprox("rsqrtf", [](float x, float) { return rsqrtf(x); }, rsqrtRef, true, 1.0f, 4.0f);
+  reportApprox("rsqrtfApprox", [](float x, float) { return rsqrtfApprox(x); }, rsqrtRef, true, 1.0f, 4.0f);
+  reportApprox("rsqrtApprox<0>", [](float x, float) { return rsqrtApprox<0>(x); }, rsqrtRef, true, 1.0f, 4.0f);
+  reportApprox("rsqrtApprox<1>", [](float x, float) { return rsqrtApprox<1>(x); }, rsqrtRef, true, 1.0f, 4.0f);
+  reportApprox("rsqrtApprox<2>", [](float x, float) { return rsqrtApprox<2>(x); }, rsqrtRef, true, 1.0f, 4.0f);
+  reportApprox("rsqrtApproxPortable<0>", [](float x, float) { return rsqrtApproxPortable<0>(x); }, rsqrtRef, true, 1.0f, 4.0f);
+  reportApprox("rsqrtApproxPortable<1>", [](float x, float) { return rsqrtApproxPortable<1>(x); }, rsqrtRef, true, 1.0f, 4.0f);
+  reportApprox("rsqrtApproxPortable<2>", [](float x, float) { return rsqrtApproxPortable<2>(x); }, rsqrtRef, true, 1.0f, 4.0f);
+}
+
+
+// Check spline evaluation with VecN<N> control points against the same
+// spline evaluated one component at a time with float points, and against
+// CatmullRomSpline (whose cached coefficients round differently).
+template <int N>
+bool checkSplineN()
+{
+  using namespace stevesch;
+  const int kPoints = 7;
+  VecN<N> points[kPoints];
+  float components[N][kPoints];
+  RandGen r(321);
+  for (int i=0; i<kPoints; ++i) {
+    for (int k=0; k<N; ++k) {
+      points[i][k] = r.getFloatAB(-10.0f, 10.0f);
+      components[k][i] = points[i][k];
+    }
+  }
+  CatmullRomSpline<VecN<N>> spline(points, kPoints);
+
+  float maxComponentError = 0.0f;
+  float maxSplineError = 0.0f;
+  const int kSteps = 1000;
+  for (int j=0; j<kSteps; ++j) {
+    float t = (float)kPoints * (float)j / (float)kSteps;
+    VecN<N> p;
+    VecN<N> tangent;
+    T_GetSplinePoint(points, kPoints, t, &p, &tangent);
+    VecN<N> q = spline.evaluate(t);
+    for (int k=0; k<N; ++k) {
+      float pk;
+      float tk;
+      T_GetSplinePoint(components[k], kPoints, t, &pk, &tk);
+      maxComponentError = std::max(maxComponentError, std::max(fabsf(pk - p[k]), fabsf(tk - tangent[k])));
+      maxSplineError = std::max(maxSplineError, fabsf(q[k] - p[k]));
+    }
+  }
+
+  bool ok = (maxComponentError == 0.0f) && (maxSplineError < 1.0e-4f);
+  Serial.printf("VecN<%d> spline: per-component error %.2e, CatmullRomSpline error %.2e  %s\n",
+    N, maxComponentError, maxSplineError, ok ? "ok" : "FAILED");
+  return ok;
+}
+
+void testSplines()
+{
+  using stevesch::VecN;
+  VecN<3> a(1.0f, 2.0f, 3.0f);
+  VecN<3> b(4.0f, 5.0f, 6.0f);
+  VecN<3> c = a + b * 2.0f - a * 0.5f;
+  bool ok = (c == VecN<3>(8.5f, 11.0f, 13.5f)) && (dot(a, b) == 32.0f) && (length(VecN<2>(3.0f, 4.0f)) == 5.0f);
+  Serial.printf("VecN arithmetic  %s\n", ok ? "ok" : "FAILED");
+
+  checkSplineN<2>();
+  checkSplineN<3>();
+  checkSplineN<4>();
+}
+
+
+// The streaming accumulators fed one value at a time, as one array, and
+// as four partial results merged together should agree.
+void testStatistics()
+{
+  using namespace stevesch;
+  const int kCount = 10000;
+  static float samples[kCount];
+  RandGen r(99);
+  for (int i=0; i<kCount; ++i) {
+    float u = r.getFloat();
+    samples[i] = 1000.0f + u * u;	// skewed, with a large offset
+  }
+
+  Moments single;
+  for (int i=0; i<kCount; ++i) {
+    single.push(samples[i]);
+  }
+  Moments batch;
+  batch.push(samples, kCount);
+  Moments merged;
+  for (int k=0; k<4; ++k) {
+    Moments part;
+    part.push(samples + k * (kCount / 4), kCount / 4);
+    merged.merge(part);
+  }
+  MinMax range;
+  range.push(samples, kCount);
+
+  Serial.printf("Moments of %d samples:   mean       stddev     skewness  kurtosis\n", kCount);
+  const Moments* results[] = { &single, &batch, &merged };
+  const char* names[] = { "push(x)", "push(p, n)", "merge" };
+  for (int k=0; k<3; ++k) {
+    Serial.printf("  %-22s %10.5f %10.7f %9.6f %9.6f\n", names[k],
+      results[k]->mean(), results[k]->stddev(), results[k]->skewness(), results[k]->kurtosis());
+  }
+  Serial.printf("  min %.6f  max %.6f\n", range.getMin(), range.getMax());
+
+  // within 1% of the samples' quantiles, which approach q*q as kCount grows
+  QuantileSketch sketch(0.01f);
+  for (int i=0; i<kCount; ++i) {
+    sketch.add(samples[i] - 1000.0f);
+  }
+  Serial.printf("QuantileSketch of u*u (%u buckets):\n", (unsigned)sketch.binCount());
+  const float quantiles[] = { 0.5f, 0.9f, 0.99f, 0.999f };
+  for (float q : quantiles) {
+    Serial.printf("  q %5.3f  %.6f  (q*q %.6f)\n", q, sketch.quantile(q), q * q);
+  }
+}
@@ -0,0 +1,283 @@
+// Benchmark driver for the host build.
+//
+// mathbase-bench [options]
+//   --filter=TEXT          run only benchmarks whose name contains TEXT
+//   --list                 list benchmark names and exit
+//   --min-time-ms=N        minimum duration of each timed repetition (default 20)
+//   --repeat=N             timed repetitions per benchmark; median is reported (default 5)
+//   --baseline=FILE        compare against ns/op values stored in FILE
+//   --save=FILE            store this run's ns/op values in FILE (baseline format)
+//   --threshold=PCT        slowdown (in percent) flagged as a regression (default 10)
+//   --fail-on-regression   exit with status 1 if any benchmark regressed
+//
+// Baseline files are plain text, one "name,ns_per_op" pair per line; lines
+// starting with '#' are ignored.
+//
+// Benchmarks with a registered accuracy (MATHBASE_ACCURACY) also show the
+// maximum and RMS error of the approximation; '-' otherwise.
+
+#include "bench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace stevesch
+{
+namespace bench
+{
+  std::vector<Benchmark>& registry()
+  {
+    static std::vector<Benchmark> s_registry;
+    return s_registry;
+  }
+
+  std::vector<Accuracy>& accuracyRegistry()
+  {
+    static std::vector<Accuracy> s_registry;
+    return s_registry;
+  }
+
+  namespace
+  {
+    // splitmix32-style hash; independent of the library's random number generators
+    inline uint32_t nextInput(uint32_t& state)
+    {
+      uint32_t z = (state += 0x9e3779b9U);
+      z = (z ^ (z >> 16)) * 0x85ebca6bU;
+      z = (z ^ (z >> 13)) * 0xc2b2ae35U;
+      return z ^ (z >> 16);
+    }
+  } // namespace
+
+  std::vector<float> uniformFloats(size_t count, float a, float b, uint32_t seed)
+  {
+    std::vector<float> values(count);
+    uint32_t state = seed;
+    for (size_t i=0; i<count; ++i) {
+      float t = (float)(nextInput(state) >> 8) * (1.0f / 16777216.0f);
+      values[i] = a + t * (b - a);
+    }
+    return values;
+  }
+
+  std::vector<uint32_t> uniformU32(size_t count, uint32_t seed)
+  {
+    std::vector<uint32_t> values(count);
+    uint32_t state = seed;
+    for (size_t i=0; i<count; ++i) {
+      values[i] = nextInput(state);
+    }
+    return values;
+  }
+
+} // namespace bench
+} // namespace stevesch
+
+namespace
+{
+  using stevesch::bench::Benchmark;
+  using stevesch::bench::Accuracy;
+  using stevesch::bench::AccuracyFn;
+
+  typedef std::chrono::steady_clock clock_type;
+
+  struct Options
+  {
+    std::string filter;
+    std::string baselineFile;
+    std::string saveFile;
+    double minTimeMs = 20.0;
+    int repeat = 5;
+    double thresholdPct = 10.0;
+    bool failOnRegression = false;
+    bool list = false;
+  };
+
+  bool startsWith(const char* s, const char* prefix, const char** rest)
+  {
+    size_t len = strlen(prefix);
+    if (strncmp(s, prefix, len) != 0) {
+      return false;
+    }
+    *rest = s + len;
+    return true;
+  }
+
+  bool parseOptions(int argc, char** argv, Options& opt)
+  {
+    for (int i=1; i<argc; ++i) {
+      const char* arg = argv[i];
+      const char* value = nullptr;
+      if (startsWith(arg, "--filter=", &value)) {
+        opt.filter = value;
+      } else if (startsWith(arg, "--baseline=", &value)) {
+        opt.baselineFile = value;
+      } else if (startsWith(arg, "--save=", &value)) {
+        opt.saveFile = value;
+      } else if (startsWith(arg, "--min-time-ms=", &value)) {
+        opt.minTimeMs = atof(value);
+      } else if (startsWith(arg, "--repeat=", &value)) {
+        opt.repeat = std::max(1, atoi(value));
+      } else if (startsWith(arg, "--threshold=", &value)) {
+        opt.thresholdPct = atof(value);
+      } else if (strcmp(arg, "--fail-on-regression") == 0) {
+        opt.failOnRegression = true;
+      } else if (strcmp(arg, "--list") == 0) {
+        opt.list = true;
+      } else {
+        fprintf(stderr, "unknown option: %s\n", arg);
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::map<std::string, double> loadBaseline(const std::string& path)
+  {
+    std::map<std::string, double> baseline;
+    FILE* f = fopen(path.c_str(), "r");
+    if (!f) {
+      fprintf(stderr, "warning: could not open baseline '%s'\n", path.c_str());
+      return baseline;
+    }
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+      if (line[0] == '#') {
+        continue;
+      }
+      char* comma = strrchr(line, ',');
+      if (!comma) {
+        continue;
+      }
+      *comma = '\0';
+      baseline[line] = atof(comma + 1);
+    }
+    fclose(f);
+    return baseline;
+  }
+
+  double elapsedNs(clock_type::time_point t0, clock_type::time_point t1)
+  {
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+  }
+
+  // returns median ns per operation
+  double measure(const Benchmark& b, const Options& opt)
+  {
+    const double minTimeNs = opt.minTimeMs * 1.0e6;
+
+    // calibrate: grow the iteration count until one run takes at least minTime
+    uint64_t iterations = 1;
+    for (;;) {
+      auto t0 = clock_type::now();
+      b.fn(iterations);
+      double ns = elapsedNs(t0, clock_type::now());
+      if (ns >= minTimeNs) {
+        break;
+      }
+      double scale = (ns > 0.0) ? (1.2 * minTimeNs / ns) : 10.0;
+      scale = std::min(std::max(scale, 2.0), 10.0);
+      iterations = (uint64_t)((double)iterations * scale);
+    }
+
+    std::vector<double> samples;
+    for (int r=0; r<opt.repeat; ++r) {
+      auto t0 = clock_type::now();
+      uint64_t ops = b.fn(iterations);
+      double ns = elapsedNs(t0, clock_type::now());
+      samples.push_back(ns / (double)std::max<uint64_t>(ops, 1));
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+  }
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  Options opt;
+  if (!parseOptions(argc, argv, opt)) {
+    return 2;
+  }
+
+  std::vector<Benchmark> benchmarks = stevesch::bench::registry();
+  std::sort(benchmarks.begin(), benchmarks.end(),
+    [](const Benchmark& a, const Benchmark& b) { return strcmp(a.name, b.name) < 0; });
+
+  if (opt.list) {
+    for (const Benchmark& b : benchmarks) {
+      printf("%s\n", b.name);
+    }
+    return 0;
+  }
+
+  std::map<std::string, double> baseline;
+  if (!opt.baselineFile.empty()) {
+    baseline = loadBaseline(opt.baselineFile);
+  }
+
+  FILE* save = nullptr;
+  if (!opt.saveFile.empty()) {
+    save = fopen(opt.saveFile.c_str(), "w");
+    if (!save) {
+      fprintf(stderr, "error: could not write '%s'\n", opt.saveFile.c_str());
+      return 2;
+    }
+    fprintf(save, "# name,ns_per_op\n");
+  }
+
+  std::map<std::string, AccuracyFn> accuracy;
+  for (const Accuracy& a : stevesch::bench::accuracyRegistry()) {
+    accuracy[a.name] = a.fn;
+  }
+
+  printf("%-48s %10s %12s %9s %9s %10s %9s\n", "benchmark", "ns/op", "Mops/s", "max err", "rms err", "baseline", "delta");
+  int regressions = 0;
+  for (const Benchmark& b : benchmarks) {
+    if (!opt.filter.empty() && !strstr(b.name, opt.filter.c_str())) {
+      continue;
+    }
+
+    double nsPerOp = measure(b, opt);
+    double mops = (nsPerOp > 0.0) ? (1.0e3 / nsPerOp) : 0.0;
+    printf("%-48s %10.3f %12.2f", b.name, nsPerOp, mops);
+
+    auto acc = accuracy.find(b.name);
+    if (acc != accuracy.end()) {
+      stevesch::bench::ErrorStats e = acc->second();
+      printf(" %9.2e %9.2e", e.maxError, e.rmsError);
+    } else {
+      printf(" %9s %9s", "-", "-");
+    }
+
+    auto it = baseline.find(b.name);
+    if (it != baseline.end() && it->second > 0.0) {
+      double deltaPct = 100.0 * (nsPerOp - it->second) / it->second;
+      bool regressed = deltaPct > opt.thresholdPct;
+      regressions += regressed ? 1 : 0;
+      printf(" %10.3f %+8.1f%%%s", it->second, deltaPct, regressed ? "  REGRESSION" : "");
+    } else if (!baseline.empty()) {
+      printf(" %10s %9s", "-", "new");
+    }
+    printf("\n");
+    fflush(stdout);
+
+    if (save) {
+      fprintf(save, "%s,%.4f\n", b.name, nsPerOp);
+    }
+  }
+
+  if (save) {
+    fclose(save);
+  }
+
+  if (!baseline.empty()) {
+    printf("%d regression(s) above %.1f%%\n", regressions, opt.thresholdPct);
+  }
+  return (opt.failOnRegression && regressions > 0) ? 1 : 0;
+}
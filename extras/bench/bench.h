@@ -0,0 +1,163 @@
+#ifndef STEVESCH_MATHBASE_EXTRAS_BENCH_BENCH_H_
+#define STEVESCH_MATHBASE_EXTRAS_BENCH_BENCH_H_
+// Minimal benchmark harness for the host build (see CMakeLists.txt).
+//
+// Each benchmark is a function that performs its operation 'iterations'
+// times and returns the number of operations it performed (normally
+// 'iterations', or iterations * N for batch operations over N items).
+// The harness calibrates the iteration count, repeats the measurement and
+// reports the median ns/op and throughput, optionally comparing against a
+// stored baseline file.
+//
+// Usage (in any bench_*.cpp file):
+//
+//   MATHBASE_BENCHMARK("scalar/rsqrtfApprox", [](uint64_t iterations) -> uint64_t {
+//     const float* in = inputs.data();
+//     for (uint64_t i=0; i<iterations; ++i) {
+//       bench::doNotOptimize(stevesch::rsqrtfApprox(in[i & kInputMask]));
+//     }
+//     return iterations;
+//   });
+//
+// Approximations can also register their accuracy under the same name; it is
+// measured once and printed next to the timing (max and RMS error columns):
+//
+//   MATHBASE_ACCURACY("scalar/rsqrtfApprox", []() -> bench::ErrorStats {
+//     return bench::relativeError(inputs,
+//       [](float x) { return stevesch::rsqrtfApprox(x); },
+//       [](float x) { return 1.0 / sqrt((double)x); });
+//   });
+
+#include <math.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <thread>
+#include <vector>
+
+namespace stevesch
+{
+namespace bench
+{
+  typedef uint64_t (*BenchFn)(uint64_t iterations);
+
+  struct Benchmark
+  {
+    const char* name;
+    BenchFn fn;
+  };
+
+  std::vector<Benchmark>& registry();
+
+  struct Registrar
+  {
+    Registrar(const char* name, BenchFn fn) { registry().push_back(Benchmark{name, fn}); }
+  };
+
+  struct ErrorStats
+  {
+    double maxError;
+    double rmsError;
+  };
+
+  typedef ErrorStats (*AccuracyFn)();
+
+  struct Accuracy
+  {
+    const char* name;
+    AccuracyFn fn;
+  };
+
+  std::vector<Accuracy>& accuracyRegistry();
+
+  struct AccuracyRegistrar
+  {
+    AccuracyRegistrar(const char* name, AccuracyFn fn) { accuracyRegistry().push_back(Accuracy{name, fn}); }
+  };
+
+  // Error of approxAt(i) against exact(inputs[i]) (evaluated in double):
+  // |approx - exact| / |exact| if 'relative', otherwise |approx - exact|.
+  template <typename A, typename G>
+  ErrorStats measureError(const std::vector<float>& inputs, A approxAt, G exact, bool relative)
+  {
+    ErrorStats e = {0.0, 0.0};
+    for (size_t i=0; i<inputs.size(); ++i) {
+      double ref = (double)exact(inputs[i]);
+      double err = fabs((double)approxAt(i) - ref);
+      if (relative) {
+        err /= fabs(ref);
+      }
+      e.maxError = (err > e.maxError) ? err : e.maxError;
+      e.rmsError += err * err;
+    }
+    e.rmsError = inputs.empty() ? 0.0 : sqrt(e.rmsError / (double)inputs.size());
+    return e;
+  }
+
+  template <typename F, typename G>
+  ErrorStats relativeError(const std::vector<float>& inputs, F approx, G exact)
+  {
+    return measureError(inputs, [&](size_t i) { return approx(inputs[i]); }, exact, true);
+  }
+
+  template <typename F, typename G>
+  ErrorStats absoluteError(const std::vector<float>& inputs, F approx, G exact)
+  {
+    return measureError(inputs, [&](size_t i) { return approx(inputs[i]); }, exact, false);
+  }
+
+  // relative error of precomputed results[i] (e.g. from a batch function)
+  template <typename G>
+  ErrorStats relativeErrorOfResults(const std::vector<float>& inputs, const std::vector<float>& results, G exact)
+  {
+    return measureError(inputs, [&](size_t i) { return results[i]; }, exact, true);
+  }
+
+  // Keep the optimizer from discarding 'value' (or the computation producing it).
+  template <typename T>
+  inline void doNotOptimize(const T& value)
+  {
+    asm volatile("" : : "r,m"(value) : "memory");
+  }
+
+  // Force pending stores (e.g. into an output buffer) to be treated as observable.
+  inline void clobberMemory()
+  {
+    asm volatile("" : : : "memory");
+  }
+
+  // Inputs for benchmarks come from a fixed, library-independent generator so
+  // that changes to RandGen do not change what is being measured.
+  constexpr size_t kInputCount = 4096;  // power of two
+  constexpr size_t kInputMask = kInputCount - 1;
+
+  // 'count' uniformly distributed values in [a, b), deterministic for a given seed
+  std::vector<float> uniformFloats(size_t count, float a, float b, uint32_t seed = 1);
+  std::vector<uint32_t> uniformU32(size_t count, uint32_t seed = 1);
+
+  // Split 'iterations' operations over kThreads threads, each running
+  // fn(threadIndex, count).  Returns the total number of operations.
+  template <int kThreads, typename F>
+  uint64_t runThreads(uint64_t iterations, F fn)
+  {
+    std::vector<std::thread> threads;
+    uint64_t perThread = (iterations + kThreads - 1) / kThreads;
+    for (int t=0; t<kThreads; ++t) {
+      threads.push_back(std::thread(fn, t, perThread));
+    }
+    for (std::thread& t : threads) {
+      t.join();
+    }
+    return perThread * kThreads;
+  }
+
+} // namespace bench
+} // namespace stevesch
+
+#define MATHBASE_BENCH_CONCAT_(a, b) a##b
+#define MATHBASE_BENCH_CONCAT(a, b) MATHBASE_BENCH_CONCAT_(a, b)
+#define MATHBASE_BENCHMARK(name, fn) \
+  static ::stevesch::bench::Registrar MATHBASE_BENCH_CONCAT(s_benchRegistrar, __LINE__)(name, fn)
+#define MATHBASE_ACCURACY(name, fn) \
+  static ::stevesch::bench::AccuracyRegistrar MATHBASE_BENCH_CONCAT(s_accuracyRegistrar, __LINE__)(name, fn)
+
+#endif
@@ -0,0 +1,565 @@
+// Benchmarks for histogram.h
+#include "bench.h"
+#include <stevesch-MathBase.h>
+#include <algorithm>
+
+namespace bench = stevesch::bench;
+using stevesch::Histogram;
+
+namespace
+{
+  const std::vector<float>& sampleInputs()
+  {
+    // extends slightly past the histogram range so edge clamping is exercised
+    static const std::vector<float> in = bench::uniformFloats(bench::kInputCount, -5.5f, 5.5f, 31);
+    return in;
+  }
+
+  Histogram& benchHistogram()
+  {
+    static Histogram h(-5.0f, 5.0f, 256);
+    return h;
+  }
+} // namespace
+
+MATHBASE_BENCHMARK("histogram/quantize", [](uint64_t n) -> uint64_t {
+  const float* in = sampleInputs().data();
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(stevesch::quantize(in[i & bench::kInputMask], -5.0f, 5.0f, 256));
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("histogram/quantizationRange", [](uint64_t n) -> uint64_t {
+  for (uint64_t i=0; i<n; ++i) {
+    stevesch::floatRange_t r = stevesch::quantizationRange((int)(i & 255), -5.0f, 5.0f, 256);
+    bench::doNotOptimize(r.first + r.second);
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("histogram/Histogram::getBinNumber", [](uint64_t n) -> uint64_t {
+  const float* in = sampleInputs().data();
+  const Histogram& h = benchHistogram();
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(h.getBinNumber(in[i & bench::kInputMask]));
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("histogram/Histogram::add", [](uint64_t n) -> uint64_t {
+  const float* in = sampleInputs().data();
+  Histogram& h = benchHistogram();
+  for (uint64_t i=0; i<n; ++i) {
+    h.add(in[i & bench::kInputMask]);
+  }
+  bench::clobberMemory();
+  return n;
+});
+
+MATHBASE_BENCHMARK("histogram/Histogram::get", [](uint64_t n) -> uint64_t {
+  const float* in = sampleInputs().data();
+  const Histogram& h = benchHistogram();
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(h.get(in[i & bench::kInputMask]));
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("histogram/Histogram::getRange[256 bins]", [](uint64_t n) -> uint64_t {
+  const Histogram& h = benchHistogram();
+  for (uint64_t i=0; i<n; ++i) {
+    Histogram::countRange_t r = h.getRange();
+    bench::doNotOptimize(r.first + r.second);
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("histogram/Histogram::clear[256 bins]", [](uint64_t n) -> uint64_t {
+  static Histogram h(0.0f, 1.0f, 256);
+  for (uint64_t i=0; i<n; ++i) {
+    h.clear();
+    bench::clobberMemory();
+  }
+  return n;
+});
+
+//////////////////////////////////////////////////////////////////////
+// ConcurrentHistogram scaling (ops == total adds over all threads)
+
+#include <mutex>
+
+namespace
+{
+  using stevesch::ConcurrentHistogram;
+
+  template <ConcurrentHistogram::Mode kMode, int kThreads>
+  uint64_t benchConcurrentAdd(uint64_t n)
+  {
+    static ConcurrentHistogram h(-5.0f, 5.0f, 256, kMode);
+    return bench::runThreads<kThreads>(n, [](int t, uint64_t count) {
+      const float* in = sampleInputs().data();
+      for (uint64_t i=0; i<count; ++i) {
+        h.add(in[(i + (uint64_t)t * 97) & bench::kInputMask]);
+      }
+    });
+  }
+
+  template <int kThreads>
+  uint64_t benchMutexAdd(uint64_t n)
+  {
+    static Histogram h(-5.0f, 5.0f, 256);
+    static std::mutex m;
+    return bench::runThreads<kThreads>(n, [](int t, uint64_t count) {
+      const float* in = sampleInputs().data();
+      for (uint64_t i=0; i<count; ++i) {
+        std::lock_guard<std::mutex> lock(m);
+        h.add(in[(i + (uint64_t)t * 97) & bench::kInputMask]);
+      }
+    });
+  }
+} // namespace
+
+MATHBASE_BENCHMARK("histogram/Histogram::add+mutex[1 thread]", benchMutexAdd<1>);
+MATHBASE_BENCHMARK("histogram/Histogram::add+mutex[2 threads]", benchMutexAdd<2>);
+MATHBASE_BENCHMARK("histogram/Histogram::add+mutex[4 threads]", benchMutexAdd<4>);
+MATHBASE_BENCHMARK("histogram/Histogram::add+mutex[8 threads]", benchMutexAdd<8>);
+MATHBASE_BENCHMARK("histogram/ConcurrentHistogram::add[atomic, 1 thread]", (benchConcurrentAdd<ConcurrentHistogram::kAtomic, 1>));
+MATHBASE_BENCHMARK("histogram/ConcurrentHistogram::add[atomic, 2 threads]", (benchConcurrentAdd<ConcurrentHistogram::kAtomic, 2>));
+MATHBASE_BENCHMARK("histogram/ConcurrentHistogram::add[atomic, 4 threads]", (benchConcurrentAdd<ConcurrentHistogram::kAtomic, 4>));
+MATHBASE_BENCHMARK("histogram/ConcurrentHistogram::add[atomic, 8 threads]", (benchConcurrentAdd<ConcurrentHistogram::kAtomic, 8>));
+MATHBASE_BENCHMARK("histogram/ConcurrentHistogram::add[sharded, 1 thread]", (benchConcurrentAdd<ConcurrentHistogram::kSharded, 1>));
+MATHBASE_BENCHMARK("histogram/ConcurrentHistogram::add[sharded, 2 threads]", (benchConcurrentAdd<ConcurrentHistogram::kSharded, 2>));
+MATHBASE_BENCHMARK("histogram/ConcurrentHistogram::add[sharded, 4 threads]", (benchConcurrentAdd<ConcurrentHistogram::kSharded, 4>));
+MATHBASE_BENCHMARK("histogram/ConcurrentHistogram::add[sharded, 8 threads]", (benchConcurrentAdd<ConcurrentHistogram::kSharded, 8>));
+
+MATHBASE_BENCHMARK("histogram/ConcurrentHistogram::snapshot[256 bins]", [](uint64_t n) -> uint64_t {
+  static ConcurrentHistogram h(-5.0f, 5.0f, 256);
+  static Histogram dst(-5.0f, 5.0f, 256);
+  for (uint64_t i=0; i<n; ++i) {
+    h.snapshot(dst);
+    bench::clobberMemory();
+  }
+  return n;
+});
+
+//////////////////////////////////////////////////////////////////////
+// batch add (ops == values added)
+
+namespace
+{
+  constexpr size_t kBatchSize = 1 << 20;
+
+  const std::vector<float>& batchInputs()
+  {
+    static const std::vector<float> in = bench::uniformFloats(kBatchSize, -5.5f, 5.5f, 32);
+    return in;
+  }
+} // namespace
+
+MATHBASE_BENCHMARK("histogram/Histogram::add[loop 1M]", [](uint64_t n) -> uint64_t {
+  const std::vector<float>& in = batchInputs();
+  Histogram& h = benchHistogram();
+  for (uint64_t i=0; i<n; ++i) {
+    for (float x : in) {
+      h.add(x);
+    }
+    bench::clobberMemory();
+  }
+  return n * kBatchSize;
+});
+
+MATHBASE_BENCHMARK("histogram/Histogram::addBatch[1M]", [](uint64_t n) -> uint64_t {
+  const std::vector<float>& in = batchInputs();
+  Histogram& h = benchHistogram();
+  for (uint64_t i=0; i<n; ++i) {
+    h.addBatch(in.data(), in.size());
+    bench::clobberMemory();
+  }
+  return n * kBatchSize;
+});
+
+// every value in one bin: worst case for a single set of counters
+MATHBASE_BENCHMARK("histogram/Histogram::add[loop 1M, one bin]", [](uint64_t n) -> uint64_t {
+  static const std::vector<float> in(kBatchSize, 1.0f);
+  Histogram& h = benchHistogram();
+  for (uint64_t i=0; i<n; ++i) {
+    for (float x : in) {
+      h.add(x);
+    }
+    bench::clobberMemory();
+  }
+  return n * kBatchSize;
+});
+
+MATHBASE_BENCHMARK("histogram/Histogram::addBatch[1M, one bin]", [](uint64_t n) -> uint64_t {
+  static const std::vector<float> in(kBatchSize, 1.0f);
+  Histogram& h = benchHistogram();
+  for (uint64_t i=0; i<n; ++i) {
+    h.addBatch(in.data(), in.size());
+    bench::clobberMemory();
+  }
+  return n * kBatchSize;
+});
+
+MATHBASE_BENCHMARK("histogram/Histogram::addBatch[weighted 1M]", [](uint64_t n) -> uint64_t {
+  const std::vector<float>& in = batchInputs();
+  static const std::vector<int32_t> amounts(kBatchSize, 3);
+  Histogram& h = benchHistogram();
+  for (uint64_t i=0; i<n; ++i) {
+    h.addBatch(in.data(), amounts.data(), in.size());
+    bench::clobberMemory();
+  }
+  return n * kBatchSize;
+});
+
+MATHBASE_BENCHMARK("histogram/Histogram::addBatch[64]", [](uint64_t n) -> uint64_t {
+  const float* in = sampleInputs().data();
+  Histogram& h = benchHistogram();
+  for (uint64_t i=0; i<n; ++i) {
+    h.addBatch(in + ((i * 64) & bench::kInputMask), 64);
+  }
+  bench::clobberMemory();
+  return n * 64;
+});
+
+// out-of-range handling; inputs run 10% past the initial range each side
+MATHBASE_BENCHMARK("histogram/Histogram::add[count out of range]", [](uint64_t n) -> uint64_t {
+  static Histogram h(-5.0f, 5.0f, 256, Histogram::kCount);
+  const float* in = sampleInputs().data();
+  for (uint64_t i=0; i<n; ++i) {
+    h.add(in[i & bench::kInputMask]);
+  }
+  bench::clobberMemory();
+  return n;
+});
+
+MATHBASE_BENCHMARK("histogram/Histogram::add[auto-range]", [](uint64_t n) -> uint64_t {
+  static Histogram h(-5.0f, 5.0f, 256, Histogram::kAutoRange);
+  const float* in = sampleInputs().data();
+  for (uint64_t i=0; i<n; ++i) {
+    h.add(in[i & bench::kInputMask]);
+  }
+  bench::clobberMemory();
+  return n;
+});
+
+MATHBASE_BENCHMARK("histogram/Histogram::addBatch[1M, auto-range]", [](uint64_t n) -> uint64_t {
+  const std::vector<float>& in = batchInputs();
+  static Histogram h(-5.0f, 5.0f, 256, Histogram::kAutoRange);
+  for (uint64_t i=0; i<n; ++i) {
+    h.addBatch(in.data(), in.size());
+    bench::clobberMemory();
+  }
+  return n * kBatchSize;
+});
+
+// ops == range doublings (each re-buckets all 256 bins): 59 per histogram,
+// half of them upward and half downward
+MATHBASE_BENCHMARK("histogram/Histogram::expandToInclude[256 bins]", [](uint64_t n) -> uint64_t {
+  for (uint64_t i=0; i<n; ++i) {
+    Histogram h(-1.0f, 1.0f, 256, Histogram::kAutoRange);
+    h.expandToInclude(-1.0f, 1e9f);
+    h.expandToInclude(-1e18f, 0.0f);
+    bench::doNotOptimize(h.getBegin());
+  }
+  return n * 59;
+});
+
+//////////////////////////////////////////////////////////////////////
+// LogHistogram over 1 .. 1e7 (e.g. 1 us .. 10 s in us), 7 decades
+//
+// Memory per decade (bins of 4 bytes) by significant digits:
+//   1: 53 bins, 213 B    2: 425 bins, 1.7 KB    3: 3402 bins, 13.6 KB
+// so the 7 decades take 1.5 KB, 12 KB and 95 KB.  A linear Histogram with
+// the 2-digit resolution at 1 us would need 1e9 bins.
+
+namespace
+{
+  using stevesch::LogHistogram;
+
+  const size_t kLatencyCount = 1 << 16;
+  const float kPercentiles[] = { 50.0f, 90.0f, 99.0f, 99.9f };
+
+  // log-uniform over the range
+  const std::vector<float>& latencyInputs()
+  {
+    static std::vector<float> in;
+    if (in.empty()) {
+      in = bench::uniformFloats(kLatencyCount, 0.0f, 16.1f, 33);
+      for (float& x : in) {
+        x = expf(x);
+      }
+    }
+    return in;
+  }
+
+  template <int kDigits>
+  LogHistogram& logHistogram()
+  {
+    static LogHistogram h(1.0f, 1e7f, kDigits);
+    return h;
+  }
+
+  template <int kDigits>
+  uint64_t benchLogAdd(uint64_t n)
+  {
+    const float* in = latencyInputs().data();
+    LogHistogram& h = logHistogram<kDigits>();
+    for (uint64_t i=0; i<n; ++i) {
+      h.add(in[i & (kLatencyCount - 1)]);
+    }
+    bench::clobberMemory();
+    return n;
+  }
+
+  template <int kDigits>
+  uint64_t benchLogAddBatch(uint64_t n)
+  {
+    const std::vector<float>& in = latencyInputs();
+    LogHistogram& h = logHistogram<kDigits>();
+    for (uint64_t i=0; i<n; ++i) {
+      h.addBatch(in.data(), in.size());
+      bench::clobberMemory();
+    }
+    return n * kLatencyCount;
+  }
+
+  // relative error of p50, p90, p99 and p99.9 against the sorted values
+  template <int kDigits>
+  bench::ErrorStats logPercentileError()
+  {
+    std::vector<float> sorted = latencyInputs();
+    std::sort(sorted.begin(), sorted.end());
+    LogHistogram h(1.0f, 1e7f, kDigits);
+    h.addBatch(latencyInputs().data(), kLatencyCount);
+    std::vector<float> percentiles(kPercentiles, kPercentiles + 4);
+    return bench::measureError(percentiles,
+      [&](size_t i) { return h.getValueAtPercentile(percentiles[i]); },
+      [&](float p) { return sorted[(size_t)ceil((double)p * 0.01 * kLatencyCount) - 1]; }, true);
+  }
+} // namespace
+
+MATHBASE_BENCHMARK("histogram/LogHistogram::getBinNumber", [](uint64_t n) -> uint64_t {
+  const float* in = latencyInputs().data();
+  const LogHistogram& h = logHistogram<2>();
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(h.getBinNumber(in[i & (kLatencyCount - 1)]));
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("histogram/LogHistogram::add[1 digit, 213 B/decade]", benchLogAdd<1>);
+MATHBASE_BENCHMARK("histogram/LogHistogram::add[2 digits, 1.7 KB/decade]", benchLogAdd<2>);
+MATHBASE_BENCHMARK("histogram/LogHistogram::add[3 digits, 13.6 KB/decade]", benchLogAdd<3>);
+MATHBASE_BENCHMARK("histogram/LogHistogram::addBatch[64k, 1 digit]", benchLogAddBatch<1>);
+MATHBASE_BENCHMARK("histogram/LogHistogram::addBatch[64k, 2 digits]", benchLogAddBatch<2>);
+MATHBASE_BENCHMARK("histogram/LogHistogram::addBatch[64k, 3 digits]", benchLogAddBatch<3>);
+
+MATHBASE_ACCURACY("histogram/LogHistogram::add[1 digit, 213 B/decade]", logPercentileError<1>);
+MATHBASE_ACCURACY("histogram/LogHistogram::add[2 digits, 1.7 KB/decade]", logPercentileError<2>);
+MATHBASE_ACCURACY("histogram/LogHistogram::add[3 digits, 13.6 KB/decade]", logPercentileError<3>);
+
+// ops == queries (p50, p90, p99, p99.9 in turn); walks up to ~3000 bins
+MATHBASE_BENCHMARK("histogram/LogHistogram::getValueAtPercentile[2 digits]", [](uint64_t n) -> uint64_t {
+  LogHistogram& h = logHistogram<2>();
+  if (h.getTotalCount() == 0) {
+    h.addBatch(latencyInputs().data(), kLatencyCount);
+  }
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(h.getValueAtPercentile(kPercentiles[i & 3]));
+  }
+  return n;
+});
+
+// ops == merges of two 2-digit histograms with the same layout
+MATHBASE_BENCHMARK("histogram/LogHistogram::merge[2 digits]", [](uint64_t n) -> uint64_t {
+  static LogHistogram part(1.0f, 1e7f, 2);
+  if (part.getTotalCount() == 0) {
+    part.addBatch(latencyInputs().data(), kLatencyCount);
+  }
+  LogHistogram total(1.0f, 1e7f, 2);
+  for (uint64_t i=0; i<n; ++i) {
+    total.merge(part);
+  }
+  bench::doNotOptimize(total.getTotalCount());
+  return n;
+});
+
+//////////////////////////////////////////////////////////////////////
+// HistogramND: joint distributions
+
+namespace
+{
+  using stevesch::HistogramND;
+
+  const size_t kPointCount = 1 << 16;
+
+  // a slowly moving stick in [-1, 1]^3 (a random walk), so consecutive
+  // points fall in nearby bins; axes[d][i] is coordinate d of point i
+  struct Walk
+  {
+    std::vector<float> axis[3];
+    Walk()
+    {
+      float p[3] = { 0.0f, 0.0f, 0.0f };
+      for (int d=0; d<3; ++d) {
+        std::vector<float> step = bench::uniformFloats(kPointCount, -0.02f, 0.02f, 34 + d);
+        axis[d].resize(kPointCount);
+        for (size_t i=0; i<kPointCount; ++i) {
+          p[d] += step[i];
+          p[d] = (p[d] < -1.0f) ? -1.0f : ((p[d] > 1.0f) ? 1.0f : p[d]);
+          axis[d][i] = p[d];
+        }
+      }
+    }
+  };
+
+  const Walk& walk()
+  {
+    static const Walk w;
+    return w;
+  }
+
+  // uncorrelated points in [-1, 1)^3
+  const Walk& scatter()
+  {
+    static Walk w;
+    static bool bInitialized = false;
+    if (!bInitialized) {
+      for (int d=0; d<3; ++d) {
+        w.axis[d] = bench::uniformFloats(kPointCount, -1.0f, 1.0f, 37 + d);
+      }
+      bInitialized = true;
+    }
+    return w;
+  }
+
+  // [-1, 1)^D with kBins bins per axis
+  template <int D, int kBins, int kLayout>
+  HistogramND<D>& cubeHistogram()
+  {
+    struct Cube
+    {
+      float a[D];
+      float b[D];
+      uint32_t bins[D];
+      Cube()
+      {
+        for (int d=0; d<D; ++d) {
+          a[d] = -1.0f;
+          b[d] = 1.0f;
+          bins[d] = kBins;
+        }
+      }
+    };
+    static const Cube cube;
+    static HistogramND<D> h(cube.a, cube.b, cube.bins, (typename HistogramND<D>::Layout)kLayout);
+    return h;
+  }
+
+  template <int D, int kBins, int kLayout, bool bScatter>
+  uint64_t benchNDAdd(uint64_t n)
+  {
+    HistogramND<D>& h = cubeHistogram<D, kBins, kLayout>();
+    const Walk& w = bScatter ? scatter() : walk();
+    for (uint64_t i=0; i<n; ++i) {
+      size_t k = i & (kPointCount - 1);
+      float p[D];
+      for (int d=0; d<D; ++d) {
+        p[d] = w.axis[d][k];
+      }
+      h.add(p);
+    }
+    bench::clobberMemory();
+    return n;
+  }
+
+  template <int D, int kBins, int kLayout>
+  uint64_t benchNDAddBatch(uint64_t n)
+  {
+    HistogramND<D>& h = cubeHistogram<D, kBins, kLayout>();
+    const float* axes[D];
+    for (int d=0; d<D; ++d) {
+      axes[d] = walk().axis[d].data();
+    }
+    for (uint64_t i=0; i<n; ++i) {
+      h.addBatch(axes, kPointCount);
+      bench::clobberMemory();
+    }
+    return n * kPointCount;
+  }
+
+  HistogramND<2> makeStickHistogram()
+  {
+    HistogramND<2> h({ -1.0f, -1.0f }, { 1.0f, 1.0f }, { 64, 64 });
+    const float* axes[2] = { walk().axis[0].data(), walk().axis[1].data() };
+    h.addBatch(axes, kPointCount);
+    return h;
+  }
+
+  const HistogramND<2>& stickHistogram()
+  {
+    static const HistogramND<2> h = makeStickHistogram();
+    return h;
+  }
+} // namespace
+
+// what HistogramND replaces: one 1D histogram per axis (and no correlation)
+MATHBASE_BENCHMARK("histogram/Histogram::add[x and y, 64 bins each]", [](uint64_t n) -> uint64_t {
+  static Histogram hx(-1.0f, 1.0f, 64);
+  static Histogram hy(-1.0f, 1.0f, 64);
+  const Walk& w = walk();
+  for (uint64_t i=0; i<n; ++i) {
+    size_t k = i & (kPointCount - 1);
+    hx.add(w.axis[0][k]);
+    hy.add(w.axis[1][k]);
+  }
+  bench::clobberMemory();
+  return n;
+});
+
+MATHBASE_BENCHMARK("histogram/HistogramND<2>::add[64x64]", (benchNDAdd<2, 64, HistogramND<2>::kRowMajor, false>));
+MATHBASE_BENCHMARK("histogram/HistogramND<2>::add[64x64, Morton]", (benchNDAdd<2, 64, HistogramND<2>::kMorton, false>));
+MATHBASE_BENCHMARK("histogram/HistogramND<2>::addBatch[64x64, 64k]", (benchNDAddBatch<2, 64, HistogramND<2>::kRowMajor>));
+MATHBASE_BENCHMARK("histogram/HistogramND<3>::add[128^3, walk]", (benchNDAdd<3, 128, HistogramND<3>::kRowMajor, false>));
+MATHBASE_BENCHMARK("histogram/HistogramND<3>::add[128^3, walk, Morton]", (benchNDAdd<3, 128, HistogramND<3>::kMorton, false>));
+MATHBASE_BENCHMARK("histogram/HistogramND<3>::add[128^3, scatter]", (benchNDAdd<3, 128, HistogramND<3>::kRowMajor, true>));
+MATHBASE_BENCHMARK("histogram/HistogramND<3>::add[128^3, scatter, Morton]", (benchNDAdd<3, 128, HistogramND<3>::kMorton, true>));
+MATHBASE_BENCHMARK("histogram/HistogramND<3>::addBatch[128^3, 64k]", (benchNDAddBatch<3, 128, HistogramND<3>::kRowMajor>));
+MATHBASE_BENCHMARK("histogram/HistogramND<3>::addBatch[128^3, 64k, Morton]", (benchNDAddBatch<3, 128, HistogramND<3>::kMorton>));
+
+// ops == box queries of up to 64x64 bins; the summed-area table is built once
+MATHBASE_BENCHMARK("histogram/HistogramND<2>::rangeSum[64x64]", [](uint64_t n) -> uint64_t {
+  const HistogramND<2>& h = stickHistogram();
+  for (uint64_t i=0; i<n; ++i) {
+    uint32_t lo = (uint32_t)(i & 31);
+    bench::doNotOptimize(h.rangeSum({ lo, lo }, { lo + 32, 63U }));
+  }
+  return n;
+});
+
+// the same boxes summed bin by bin
+MATHBASE_BENCHMARK("histogram/HistogramND<2>::getBinContents[box loop 64x64]", [](uint64_t n) -> uint64_t {
+  const HistogramND<2>& h = stickHistogram();
+  for (uint64_t i=0; i<n; ++i) {
+    uint32_t lo = (uint32_t)(i & 31);
+    int64_t sum = 0;
+    for (uint32_t y=lo; y<=63; ++y) {
+      for (uint32_t x=lo; x<=lo + 32; ++x) {
+        sum += h.getBinContents({ x, y });
+      }
+    }
+    bench::doNotOptimize(sum);
+  }
+  return n;
+});
+
+// ops == marginals of a 64x64 histogram
+MATHBASE_BENCHMARK("histogram/HistogramND<2>::marginal[64x64]", [](uint64_t n) -> uint64_t {
+  const HistogramND<2>& h = stickHistogram();
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(h.marginal((int)(i & 1)).data());
+  }
+  return n;
+});
@@ -0,0 +1,364 @@
+// Benchmarks for intMath.h (bit utilities and RandGen)
+#include "bench.h"
+#include <stevesch-MathBase.h>
+
+namespace bench = stevesch::bench;
+using stevesch::RandGen;
+
+namespace
+{
+  const std::vector<uint32_t>& u32Inputs()
+  {
+    static const std::vector<uint32_t> in = bench::uniformU32(bench::kInputCount, 21);
+    return in;
+  }
+
+  const std::vector<float>& wideInputs()
+  {
+    static const std::vector<float> in = bench::uniformFloats(bench::kInputCount, -1000.0f, 1000.0f, 22);
+    return in;
+  }
+
+  RandGen& benchRandGen()
+  {
+    static RandGen r(12345U);
+    return r;
+  }
+} // namespace
+
+MATHBASE_BENCHMARK("intMath/countBits", [](uint64_t n) -> uint64_t {
+  const uint32_t* in = u32Inputs().data();
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(stevesch::countBits(in[i & bench::kInputMask]));
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("intMath/highestBit", [](uint64_t n) -> uint64_t {
+  const uint32_t* in = u32Inputs().data();
+  for (uint64_t i=0; i<n; ++i) {
+    // shift so that the position of the highest bit varies
+    uint32_t u = in[i & bench::kInputMask];
+    bench::doNotOptimize(stevesch::highestBit(u >> (u & 31)));
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("intMath/clampT<int>", [](uint64_t n) -> uint64_t {
+  const uint32_t* in = u32Inputs().data();
+  for (uint64_t i=0; i<n; ++i) {
+    int x = (int)(in[i & bench::kInputMask] & 0xffff) - 0x8000;
+    bench::doNotOptimize(stevesch::clampT(x, -1000, 1000));
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("intMath/ftoi", [](uint64_t n) -> uint64_t {
+  const float* in = wideInputs().data();
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(stevesch::ftoi(in[i & bench::kInputMask]));
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("intMath/wrapInt", [](uint64_t n) -> uint64_t {
+  const uint32_t* in = u32Inputs().data();
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(stevesch::wrapInt((int)in[i & bench::kInputMask], 360));
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("intMath/RandGen::getU", [](uint64_t n) -> uint64_t {
+  RandGen& r = benchRandGen();
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(r.getU());
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("intMath/RandGen::getInt", [](uint64_t n) -> uint64_t {
+  RandGen& r = benchRandGen();
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(r.getInt(1000));
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("intMath/RandGen::getFloat", [](uint64_t n) -> uint64_t {
+  RandGen& r = benchRandGen();
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(r.getFloat());
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("intMath/RandGen::getFloatAB", [](uint64_t n) -> uint64_t {
+  RandGen& r = benchRandGen();
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(r.getFloatAB(-3.0f, 5.0f));
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("intMath/RandGen::setSeed", [](uint64_t n) -> uint64_t {
+  RandGen& r = benchRandGen();
+  for (uint64_t i=0; i<n; ++i) {
+    r.setSeed((uint32_t)i);
+    bench::clobberMemory();
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("intMath/SRandU", [](uint64_t n) -> uint64_t {
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(stevesch::SRandU());
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("intMath/SRandInt", [](uint64_t n) -> uint64_t {
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(stevesch::SRandInt(1000));
+  }
+  return n;
+});
+
+//////////////////////////////////////////////////////////////////////
+// RandGen engines
+
+namespace
+{
+  template <typename Engine>
+  stevesch::TRandGen<Engine>& engineRandGen()
+  {
+    static stevesch::TRandGen<Engine> r(12345U);
+    return r;
+  }
+
+  template <typename Engine>
+  uint64_t benchEngineGetU(uint64_t n)
+  {
+    stevesch::TRandGen<Engine>& r = engineRandGen<Engine>();
+    for (uint64_t i=0; i<n; ++i) {
+      bench::doNotOptimize(r.getU());
+    }
+    return n;
+  }
+
+  template <typename Engine>
+  uint64_t benchEngineGetInt(uint64_t n)
+  {
+    stevesch::TRandGen<Engine>& r = engineRandGen<Engine>();
+    for (uint64_t i=0; i<n; ++i) {
+      bench::doNotOptimize(r.getInt(1000));
+    }
+    return n;
+  }
+
+  template <typename Engine>
+  uint64_t benchEngineGetFloat(uint64_t n)
+  {
+    stevesch::TRandGen<Engine>& r = engineRandGen<Engine>();
+    for (uint64_t i=0; i<n; ++i) {
+      bench::doNotOptimize(r.getFloat());
+    }
+    return n;
+  }
+
+  typedef stevesch::StdRandEngine<std::default_random_engine> StdDefaultEngine;
+} // namespace
+
+MATHBASE_BENCHMARK("intMath/TRandGen<std::default_random_engine>::getU", benchEngineGetU<StdDefaultEngine>);
+MATHBASE_BENCHMARK("intMath/TRandGen<std::default_random_engine>::getInt", benchEngineGetInt<StdDefaultEngine>);
+MATHBASE_BENCHMARK("intMath/TRandGen<std::default_random_engine>::getFloat", benchEngineGetFloat<StdDefaultEngine>);
+MATHBASE_BENCHMARK("intMath/TRandGen<Xoshiro128Plus>::getU", benchEngineGetU<stevesch::Xoshiro128Plus>);
+MATHBASE_BENCHMARK("intMath/TRandGen<Xoshiro128Plus>::getInt", benchEngineGetInt<stevesch::Xoshiro128Plus>);
+MATHBASE_BENCHMARK("intMath/TRandGen<Xoshiro128Plus>::getFloat", benchEngineGetFloat<stevesch::Xoshiro128Plus>);
+MATHBASE_BENCHMARK("intMath/TRandGen<Xoshiro128StarStar>::getU", benchEngineGetU<stevesch::Xoshiro128StarStar>);
+MATHBASE_BENCHMARK("intMath/TRandGen<Xoshiro128StarStar>::getInt", benchEngineGetInt<stevesch::Xoshiro128StarStar>);
+MATHBASE_BENCHMARK("intMath/TRandGen<Xoshiro128StarStar>::getFloat", benchEngineGetFloat<stevesch::Xoshiro128StarStar>);
+MATHBASE_BENCHMARK("intMath/TRandGen<Pcg32>::getU", benchEngineGetU<stevesch::Pcg32>);
+MATHBASE_BENCHMARK("intMath/TRandGen<Pcg32>::getInt", benchEngineGetInt<stevesch::Pcg32>);
+MATHBASE_BENCHMARK("intMath/TRandGen<Pcg32>::getFloat", benchEngineGetFloat<stevesch::Pcg32>);
+MATHBASE_BENCHMARK("intMath/TRandGen<SplitMix64>::getU", benchEngineGetU<stevesch::SplitMix64>);
+MATHBASE_BENCHMARK("intMath/TRandGen<SplitMix64>::getInt", benchEngineGetInt<stevesch::SplitMix64>);
+MATHBASE_BENCHMARK("intMath/TRandGen<SplitMix64>::getFloat", benchEngineGetFloat<stevesch::SplitMix64>);
+
+//////////////////////////////////////////////////////////////////////
+// bulk fill vs. per-call generation (ops == values generated)
+
+namespace
+{
+  template <typename Engine, size_t kCount>
+  uint64_t benchLoopFloat(uint64_t n)
+  {
+    static std::vector<float> out(kCount);
+    stevesch::TRandGen<Engine>& r = engineRandGen<Engine>();
+    for (uint64_t i=0; i<n; ++i) {
+      for (size_t k=0; k<kCount; ++k) {
+        out[k] = r.getFloat();
+      }
+      bench::clobberMemory();
+    }
+    return n * kCount;
+  }
+
+  template <typename Engine, size_t kCount>
+  uint64_t benchFillFloat(uint64_t n)
+  {
+    static std::vector<float> out(kCount);
+    stevesch::TRandGen<Engine>& r = engineRandGen<Engine>();
+    for (uint64_t i=0; i<n; ++i) {
+      r.fillFloat(out.data(), kCount);
+      bench::clobberMemory();
+    }
+    return n * kCount;
+  }
+
+  template <typename Engine, size_t kCount>
+  uint64_t benchFillU32(uint64_t n)
+  {
+    static std::vector<uint32_t> out(kCount);
+    stevesch::TRandGen<Engine>& r = engineRandGen<Engine>();
+    for (uint64_t i=0; i<n; ++i) {
+      r.fillU32(out.data(), kCount);
+      bench::clobberMemory();
+    }
+    return n * kCount;
+  }
+
+  template <size_t kCount>
+  uint64_t benchFillFloatAB(uint64_t n)
+  {
+    static std::vector<float> out(kCount);
+    RandGen& r = benchRandGen();
+    for (uint64_t i=0; i<n; ++i) {
+      r.fillFloatAB(out.data(), kCount, -3.0f, 5.0f);
+      bench::clobberMemory();
+    }
+    return n * kCount;
+  }
+} // namespace
+
+MATHBASE_BENCHMARK("intMath/RandGen::getFloat[loop 4096]", (benchLoopFloat<stevesch::Xoshiro128StarStar, 4096>));
+MATHBASE_BENCHMARK("intMath/RandGen::fillFloat[4096]", (benchFillFloat<stevesch::Xoshiro128StarStar, 4096>));
+MATHBASE_BENCHMARK("intMath/RandGen::fillFloat[256]", (benchFillFloat<stevesch::Xoshiro128StarStar, 256>));
+MATHBASE_BENCHMARK("intMath/RandGen::fillFloat[32]", (benchFillFloat<stevesch::Xoshiro128StarStar, 32>));
+MATHBASE_BENCHMARK("intMath/RandGen::fillU32[4096]", (benchFillU32<stevesch::Xoshiro128StarStar, 4096>));
+MATHBASE_BENCHMARK("intMath/RandGen::fillFloatAB[4096]", benchFillFloatAB<4096>);
+MATHBASE_BENCHMARK("intMath/TRandGen<Xoshiro128Plus>::getFloat[loop 4096]", (benchLoopFloat<stevesch::Xoshiro128Plus, 4096>));
+MATHBASE_BENCHMARK("intMath/TRandGen<Xoshiro128Plus>::fillFloat[4096]", (benchFillFloat<stevesch::Xoshiro128Plus, 4096>));
+MATHBASE_BENCHMARK("intMath/TRandGen<Pcg32>::fillFloat[4096]", (benchFillFloat<stevesch::Pcg32, 4096>));
+
+//////////////////////////////////////////////////////////////////////
+// shared vs. per-thread generators (ops == values over all threads)
+
+#include <mutex>
+
+namespace
+{
+  template <int kThreads>
+  uint64_t benchSharedLocked(uint64_t n)
+  {
+    static std::mutex m;
+    return bench::runThreads<kThreads>(n, [](int, uint64_t count) {
+      float sum = 0.0f;
+      for (uint64_t i=0; i<count; ++i) {
+        std::lock_guard<std::mutex> lock(m);
+        sum += stevesch::S_RandGen.getFloat();
+      }
+      bench::doNotOptimize(sum);
+    });
+  }
+
+  template <int kThreads>
+  uint64_t benchThreadRandGen(uint64_t n)
+  {
+    return bench::runThreads<kThreads>(n, [](int, uint64_t count) {
+      float sum = 0.0f;
+      for (uint64_t i=0; i<count; ++i) {
+        sum += stevesch::threadRandGen().getFloat();
+      }
+      bench::doNotOptimize(sum);
+    });
+  }
+} // namespace
+
+MATHBASE_BENCHMARK("intMath/threadRandGen().getFloat", [](uint64_t n) -> uint64_t {
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(stevesch::threadRandGen().getFloat());
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("intMath/S_RandGen.getFloat+mutex[1 thread]", benchSharedLocked<1>);
+MATHBASE_BENCHMARK("intMath/S_RandGen.getFloat+mutex[4 threads]", benchSharedLocked<4>);
+MATHBASE_BENCHMARK("intMath/threadRandGen().getFloat[1 thread]", benchThreadRandGen<1>);
+MATHBASE_BENCHMARK("intMath/threadRandGen().getFloat[4 threads]", benchThreadRandGen<4>);
+
+//////////////////////////////////////////////////////////////////////
+// counter-based generation (ops == values generated)
+
+namespace
+{
+  const stevesch::CounterRandGen& counterRandGen()
+  {
+    static const stevesch::CounterRandGen g(0x9e3779b97f4a7c15ULL);
+    return g;
+  }
+
+  template <size_t kCount>
+  uint64_t benchCounterFillFloat(uint64_t n)
+  {
+    static std::vector<float> out(kCount);
+    const stevesch::CounterRandGen& g = counterRandGen();
+    for (uint64_t i=0; i<n; ++i) {
+      g.fillFloat(i * kCount, out.data(), kCount);
+      bench::clobberMemory();
+    }
+    return n * kCount;
+  }
+} // namespace
+
+MATHBASE_BENCHMARK("intMath/CounterRandGen::getU", [](uint64_t n) -> uint64_t {
+  const stevesch::CounterRandGen& g = counterRandGen();
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(g.getU(i));
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("intMath/CounterRandGen::getFloat", [](uint64_t n) -> uint64_t {
+  const stevesch::CounterRandGen& g = counterRandGen();
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(g.getFloat(i));
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("intMath/CounterRandGen::fillU32[4096]", [](uint64_t n) -> uint64_t {
+  static std::vector<uint32_t> out(4096);
+  const stevesch::CounterRandGen& g = counterRandGen();
+  for (uint64_t i=0; i<n; ++i) {
+    g.fillU32(i * 4096, out.data(), out.size());
+    bench::clobberMemory();
+  }
+  return n * 4096;
+});
+
+MATHBASE_BENCHMARK("intMath/CounterRandGen::fillFloat[4096]", benchCounterFillFloat<4096>);
+MATHBASE_BENCHMARK("intMath/CounterRandGen::fillFloat[64]", benchCounterFillFloat<64>);
+
+// the same 1M values split over 4 threads
+MATHBASE_BENCHMARK("intMath/CounterRandGen::fillFloat[1M, 4 threads]", [](uint64_t n) -> uint64_t {
+  static std::vector<float> out(1 << 20);
+  const size_t perThread = out.size() / 4;
+  for (uint64_t i=0; i<n; ++i) {
+    bench::runThreads<4>(4, [perThread](int t, uint64_t) {
+      counterRandGen().fillFloat((uint64_t)t * perThread, out.data() + t * perThread, perThread);
+    });
+    bench::clobberMemory();
+  }
+  return n * out.size();
+});
@@ -0,0 +1,250 @@
+// Benchmarks for pid.h
+#include "bench.h"
+#include <stevesch-MathBase.h>
+
+namespace bench = stevesch::bench;
+using stevesch::Pid;
+
+namespace
+{
+  constexpr size_t kPidCount = 256;  // power of two
+  constexpr size_t kPidMask = kPidCount - 1;
+
+  // A set of controllers with scattered equilibrium points.  Every time the
+  // whole set has been advanced once, the targets are moved so that the
+  // controllers do not all settle (which would only measure the sticky path).
+  struct PidSet
+  {
+    std::vector<Pid> pids;
+    std::vector<float> targets;
+    size_t round = 0;
+
+    PidSet() : pids(kPidCount, Pid(0.08f, 0.4f, 0.00001f)),
+      targets(bench::uniformFloats(kPidCount * 8, -3.0f, 3.0f, 41))
+    {
+      retarget();
+    }
+
+    void retarget()
+    {
+      for (size_t k=0; k<kPidCount; ++k) {
+        pids[k].setEq(targets[(round * kPidCount + k) % targets.size()]);
+      }
+      ++round;
+    }
+
+    Pid& at(uint64_t i)
+    {
+      size_t k = (size_t)(i & kPidMask);
+      if (k == 0 && (i & (kPidCount * 64 - 1)) == 0) {
+        retarget();
+      }
+      return pids[k];
+    }
+  };
+
+  PidSet& pidSet()
+  {
+    static PidSet s;
+    return s;
+  }
+} // namespace
+
+MATHBASE_BENCHMARK("pid/APIDAdvance", [](uint64_t n) -> uint64_t {
+  PidSet& s = pidSet();
+  for (uint64_t i=0; i<n; ++i) {
+    stevesch::APIDAdvance(&s.at(i), 0.5f);
+  }
+  bench::clobberMemory();
+  return n;
+});
+
+MATHBASE_BENCHMARK("pid/Pid::advance[dt=0.5]", [](uint64_t n) -> uint64_t {
+  PidSet& s = pidSet();
+  for (uint64_t i=0; i<n; ++i) {
+    s.at(i).advance(0.5f);
+  }
+  bench::clobberMemory();
+  return n;
+});
+
+// long frame: 16 sub-steps per call
+MATHBASE_BENCHMARK("pid/Pid::advance[dt=16]", [](uint64_t n) -> uint64_t {
+  PidSet& s = pidSet();
+  for (uint64_t i=0; i<n; ++i) {
+    s.at(i).advance(16.0f);
+  }
+  bench::clobberMemory();
+  return n;
+});
+
+MATHBASE_BENCHMARK("pid/Pid::advanceSticky", [](uint64_t n) -> uint64_t {
+  PidSet& s = pidSet();
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(s.at(i).advanceSticky(0.5f, 0.001f, 0.001f));
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("pid/Pid::advanceClamp", [](uint64_t n) -> uint64_t {
+  PidSet& s = pidSet();
+  for (uint64_t i=0; i<n; ++i) {
+    s.at(i).advanceClamp(0.5f, 0.1f);
+  }
+  bench::clobberMemory();
+  return n;
+});
+
+MATHBASE_BENCHMARK("pid/Pid::advanceClampSticky", [](uint64_t n) -> uint64_t {
+  PidSet& s = pidSet();
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(s.at(i).advanceClampSticky(0.5f, 0.1f, 0.001f, 0.001f));
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("pid/Pid::circularAdvance", [](uint64_t n) -> uint64_t {
+  PidSet& s = pidSet();
+  for (uint64_t i=0; i<n; ++i) {
+    s.at(i).circularAdvance(0.5f);
+  }
+  bench::clobberMemory();
+  return n;
+});
+
+MATHBASE_BENCHMARK("pid/Pid::circularAdvanceSticky", [](uint64_t n) -> uint64_t {
+  PidSet& s = pidSet();
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(s.at(i).circularAdvanceSticky(0.5f, 0.001f, 0.001f));
+  }
+  return n;
+});
+
+//////////////////////////////////////////////////////////////////////
+// PidBank (ops == controller updates)
+
+namespace
+{
+  constexpr size_t kBankSize = 4096;
+
+  stevesch::PidBank& pidBank()
+  {
+    static stevesch::PidBank bank;
+    if (bank.size() == 0) {
+      bank.resize(kBankSize, 0.08f, 0.4f, 0.00001f);
+      std::vector<float> eq = bench::uniformFloats(kBankSize, -3.0f, 3.0f, 42);
+      for (size_t k=0; k<kBankSize; ++k) {
+        bank.setEq(k, eq[k]);
+      }
+    }
+    return bank;
+  }
+
+  std::vector<Pid>& pidArray()
+  {
+    static std::vector<Pid> pids;
+    if (pids.empty()) {
+      pids.resize(kBankSize, Pid(0.08f, 0.4f, 0.00001f));
+      std::vector<float> eq = bench::uniformFloats(kBankSize, -3.0f, 3.0f, 42);
+      for (size_t k=0; k<kBankSize; ++k) {
+        pids[k].setEq(eq[k]);
+      }
+    }
+    return pids;
+  }
+
+  template <int kDt>
+  uint64_t benchPidLoop(uint64_t n)
+  {
+    std::vector<Pid>& pids = pidArray();
+    for (uint64_t i=0; i<n; ++i) {
+      for (Pid& p : pids) {
+        p.advance((float)kDt * 0.5f);
+      }
+      bench::clobberMemory();
+    }
+    return n * kBankSize;
+  }
+
+  template <int kDt>
+  uint64_t benchBankAdvance(uint64_t n)
+  {
+    stevesch::PidBank& bank = pidBank();
+    for (uint64_t i=0; i<n; ++i) {
+      bank.advanceAll((float)kDt * 0.5f);
+      bench::clobberMemory();
+    }
+    return n * kBankSize;
+  }
+} // namespace
+
+// dt == kDt/2
+MATHBASE_BENCHMARK("pid/Pid::advance[4096 loop, dt=0.5]", benchPidLoop<1>);
+MATHBASE_BENCHMARK("pid/Pid::advance[4096 loop, dt=16]", benchPidLoop<32>);
+MATHBASE_BENCHMARK("pid/PidBank::advanceAll[4096, dt=0.5]", benchBankAdvance<1>);
+MATHBASE_BENCHMARK("pid/PidBank::advanceAll[4096, dt=16]", benchBankAdvance<32>);
+
+MATHBASE_BENCHMARK("pid/PidBank::advanceClampAll[4096]", [](uint64_t n) -> uint64_t {
+  stevesch::PidBank& bank = pidBank();
+  for (uint64_t i=0; i<n; ++i) {
+    bank.advanceClampAll(0.5f, 0.1f);
+    bench::clobberMemory();
+  }
+  return n * kBankSize;
+});
+
+MATHBASE_BENCHMARK("pid/PidBank::advanceStickyAll[4096]", [](uint64_t n) -> uint64_t {
+  stevesch::PidBank& bank = pidBank();
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(bank.advanceStickyAll(0.5f, 0.001f, 0.001f).data());
+  }
+  return n * kBankSize;
+});
+
+MATHBASE_BENCHMARK("pid/PidBank::circularAdvanceAll[4096]", [](uint64_t n) -> uint64_t {
+  stevesch::PidBank& bank = pidBank();
+  for (uint64_t i=0; i<n; ++i) {
+    bank.circularAdvanceAll(0.5f);
+    bench::clobberMemory();
+  }
+  return n * kBankSize;
+});
+
+MATHBASE_BENCHMARK("pid/PidBank::circularAdvanceStickyAll[4096]", [](uint64_t n) -> uint64_t {
+  stevesch::PidBank& bank = pidBank();
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(bank.circularAdvanceStickyAll(0.5f, 0.001f, 0.001f).data());
+  }
+  return n * kBankSize;
+});
+
+//////////////////////////////////////////////////////////////////////
+// exact (state-transition) advance
+
+MATHBASE_BENCHMARK("pid/Pid::advanceExact[dt=0.5]", [](uint64_t n) -> uint64_t {
+  PidSet& s = pidSet();
+  for (uint64_t i=0; i<n; ++i) {
+    s.at(i).advanceExact(0.5f);
+  }
+  bench::clobberMemory();
+  return n;
+});
+
+MATHBASE_BENCHMARK("pid/Pid::advanceExact[dt=16]", [](uint64_t n) -> uint64_t {
+  PidSet& s = pidSet();
+  for (uint64_t i=0; i<n; ++i) {
+    s.at(i).advanceExact(16.0f);
+  }
+  bench::clobberMemory();
+  return n;
+});
+
+// cache miss on every call
+MATHBASE_BENCHMARK("pid/PidTransition::compute", [](uint64_t n) -> uint64_t {
+  stevesch::PidTransition t;
+  for (uint64_t i=0; i<n; ++i) {
+    t.compute(0.08f, 0.4f, 0.00001f, 0.5f + (float)(i & 63));
+    bench::doNotOptimize(t.m[0][0]);
+  }
+  return n;
+});
@@ -0,0 +1,654 @@
+// Benchmarks for scalar.h, mathApprox.h and polyApprox.h
+#include "bench.h"
+#include <stevesch-MathBase.h>
+#include <float.h>
+#include <string.h>
+
+namespace bench = stevesch::bench;
+
+namespace
+{
+  template <typename F>
+  inline uint64_t runUnary(uint64_t iterations, const std::vector<float>& in, F fn)
+  {
+    const float* x = in.data();
+    for (uint64_t i=0; i<iterations; ++i) {
+      bench::doNotOptimize(fn(x[i & bench::kInputMask]));
+    }
+    return iterations;
+  }
+
+  template <typename F>
+  inline uint64_t runBinary(uint64_t iterations, const std::vector<float>& in0, const std::vector<float>& in1, F fn)
+  {
+    const float* x = in0.data();
+    const float* y = in1.data();
+    for (uint64_t i=0; i<iterations; ++i) {
+      size_t k = i & bench::kInputMask;
+      bench::doNotOptimize(fn(x[k], y[k]));
+    }
+    return iterations;
+  }
+
+  const std::vector<float>& unitInputs()
+  {
+    static const std::vector<float> in = bench::uniformFloats(bench::kInputCount, -1.0f, 1.0f, 11);
+    return in;
+  }
+
+  const std::vector<float>& unitInputs2()
+  {
+    static const std::vector<float> in = bench::uniformFloats(bench::kInputCount, -1.0f, 1.0f, 12);
+    return in;
+  }
+
+  const std::vector<float>& positiveInputs()
+  {
+    static const std::vector<float> in = bench::uniformFloats(bench::kInputCount, 1.0e-5f, 1.0e+6f, 13);
+    return in;
+  }
+
+  const std::vector<float>& angleInputs()
+  {
+    static const std::vector<float> in = bench::uniformFloats(bench::kInputCount, -20.0f, 20.0f, 14);
+    return in;
+  }
+
+  const std::vector<float>& expInputs()
+  {
+    static const std::vector<float> in = bench::uniformFloats(bench::kInputCount, -80.0f, 80.0f, 18);
+    return in;
+  }
+
+  const std::vector<float>& powBases()
+  {
+    static const std::vector<float> in = bench::uniformFloats(bench::kInputCount, 0.1f, 10.0f, 19);
+    return in;
+  }
+
+  const std::vector<float>& wideInputs()
+  {
+    static const std::vector<float> in = bench::uniformFloats(bench::kInputCount, -1000.0f, 1000.0f, 15);
+    return in;
+  }
+} // namespace
+
+//////////////////////////////////////////////////////////////////////
+// libm references
+
+MATHBASE_BENCHMARK("libm/sqrtf", [](uint64_t n) -> uint64_t {
+  return runUnary(n, positiveInputs(), [](float x) { return sqrtf(x); });
+});
+
+MATHBASE_BENCHMARK("libm/sinf", [](uint64_t n) -> uint64_t {
+  return runUnary(n, angleInputs(), [](float x) { return sinf(x); });
+});
+
+MATHBASE_BENCHMARK("libm/cosf", [](uint64_t n) -> uint64_t {
+  return runUnary(n, angleInputs(), [](float x) { return cosf(x); });
+});
+
+MATHBASE_BENCHMARK("libm/atan2f", [](uint64_t n) -> uint64_t {
+  return runBinary(n, unitInputs(), unitInputs2(), [](float x, float y) { return atan2f(x, y); });
+});
+
+MATHBASE_BENCHMARK("libm/tanf", [](uint64_t n) -> uint64_t {
+  return runUnary(n, unitInputs(), [](float x) { return tanf(1.5f * x); });
+});
+
+MATHBASE_BENCHMARK("libm/expf", [](uint64_t n) -> uint64_t {
+  return runUnary(n, expInputs(), [](float x) { return expf(x); });
+});
+
+MATHBASE_BENCHMARK("libm/logf", [](uint64_t n) -> uint64_t {
+  return runUnary(n, positiveInputs(), [](float x) { return logf(x); });
+});
+
+MATHBASE_BENCHMARK("libm/powf", [](uint64_t n) -> uint64_t {
+  return runBinary(n, powBases(), unitInputs(), [](float x, float y) { return powf(x, 4.0f * y); });
+});
+
+//////////////////////////////////////////////////////////////////////
+// scalar.h
+
+MATHBASE_BENCHMARK("scalar/maxf", [](uint64_t n) -> uint64_t {
+  return runBinary(n, unitInputs(), unitInputs2(), [](float x, float y) { return stevesch::maxf(x, y); });
+});
+
+MATHBASE_BENCHMARK("scalar/minf", [](uint64_t n) -> uint64_t {
+  return runBinary(n, unitInputs(), unitInputs2(), [](float x, float y) { return stevesch::minf(x, y); });
+});
+
+MATHBASE_BENCHMARK("scalar/roundftoi", [](uint64_t n) -> uint64_t {
+  return runUnary(n, wideInputs(), [](float x) { return stevesch::roundftoi(x); });
+});
+
+MATHBASE_BENCHMARK("scalar/statisticalRoundftoi", [](uint64_t n) -> uint64_t {
+  return runUnary(n, wideInputs(), [](float x) { return stevesch::statisticalRoundftoi(x); });
+});
+
+MATHBASE_BENCHMARK("scalar/recipf", [](uint64_t n) -> uint64_t {
+  return runUnary(n, positiveInputs(), [](float x) { return stevesch::recipf(x); });
+});
+
+MATHBASE_BENCHMARK("scalar/rsqrtf", [](uint64_t n) -> uint64_t {
+  return runUnary(n, positiveInputs(), [](float x) { return stevesch::rsqrtf(x); });
+});
+
+MATHBASE_BENCHMARK("scalar/rsqrtfApprox", [](uint64_t n) -> uint64_t {
+  return runUnary(n, positiveInputs(), [](float x) { return stevesch::rsqrtfApprox(x); });
+});
+
+//////////////////////////////////////////////////////////////////////
+// rsqrt variants, error against speed (bench --filter=rsqrt)
+
+namespace
+{
+  // every variant's error pattern repeats for every other power of two
+  const std::vector<float>& rsqrtErrorInputs()
+  {
+    static const std::vector<float> in = bench::uniformFloats(1 << 16, 1.0f, 4.0f, 22);
+    return in;
+  }
+
+  double rsqrtExact(float x) { return 1.0 / sqrt((double)x); }
+
+  template <typename F>
+  bench::ErrorStats rsqrtError(F fn)
+  {
+    return bench::relativeError(rsqrtErrorInputs(), fn, rsqrtExact);
+  }
+
+  template <int kIterations>
+  uint64_t benchRsqrtTier(uint64_t n)
+  {
+    return runUnary(n, positiveInputs(), [](float x) { return stevesch::rsqrtApprox<kIterations>(x); });
+  }
+
+  template <int kIterations>
+  uint64_t benchRsqrtPortableTier(uint64_t n)
+  {
+    return runUnary(n, positiveInputs(), [](float x) { return stevesch::rsqrtApproxPortable<kIterations>(x); });
+  }
+
+  template <int kIterations>
+  bench::ErrorStats rsqrtTierError()
+  {
+    return rsqrtError([](float x) { return stevesch::rsqrtApprox<kIterations>(x); });
+  }
+
+  template <int kIterations>
+  bench::ErrorStats rsqrtPortableTierError()
+  {
+    return rsqrtError([](float x) { return stevesch::rsqrtApproxPortable<kIterations>(x); });
+  }
+} // namespace
+
+MATHBASE_ACCURACY("scalar/rsqrtf", []() -> bench::ErrorStats {
+  return rsqrtError([](float x) { return stevesch::rsqrtf(x); });
+});
+MATHBASE_ACCURACY("scalar/rsqrtfApprox", []() -> bench::ErrorStats {
+  return rsqrtError([](float x) { return stevesch::rsqrtfApprox(x); });
+});
+
+MATHBASE_BENCHMARK("scalar/rsqrtApprox<0>", benchRsqrtTier<0>);
+MATHBASE_BENCHMARK("scalar/rsqrtApprox<1>", benchRsqrtTier<1>);
+MATHBASE_BENCHMARK("scalar/rsqrtApprox<2>", benchRsqrtTier<2>);
+MATHBASE_BENCHMARK("scalar/rsqrtApprox<3>", benchRsqrtTier<3>);
+MATHBASE_BENCHMARK("scalar/rsqrtApproxPortable<0>", benchRsqrtPortableTier<0>);
+MATHBASE_BENCHMARK("scalar/rsqrtApproxPortable<1>", benchRsqrtPortableTier<1>);
+MATHBASE_BENCHMARK("scalar/rsqrtApproxPortable<2>", benchRsqrtPortableTier<2>);
+MATHBASE_BENCHMARK("scalar/rsqrtApproxPortable<3>", benchRsqrtPortableTier<3>);
+MATHBASE_ACCURACY("scalar/rsqrtApprox<0>", rsqrtTierError<0>);
+MATHBASE_ACCURACY("scalar/rsqrtApprox<1>", rsqrtTierError<1>);
+MATHBASE_ACCURACY("scalar/rsqrtApprox<2>", rsqrtTierError<2>);
+MATHBASE_ACCURACY("scalar/rsqrtApprox<3>", rsqrtTierError<3>);
+MATHBASE_ACCURACY("scalar/rsqrtApproxPortable<0>", rsqrtPortableTierError<0>);
+MATHBASE_ACCURACY("scalar/rsqrtApproxPortable<1>", rsqrtPortableTierError<1>);
+MATHBASE_ACCURACY("scalar/rsqrtApproxPortable<2>", rsqrtPortableTierError<2>);
+MATHBASE_ACCURACY("scalar/rsqrtApproxPortable<3>", rsqrtPortableTierError<3>);
+
+MATHBASE_BENCHMARK("scalar/cosSinf", [](uint64_t n) -> uint64_t {
+  return runUnary(n, angleInputs(), [](float x) {
+    float c, s;
+    stevesch::cosSinf(x, &c, &s);
+    return c + s;
+  });
+});
+
+MATHBASE_BENCHMARK("scalar/degToRad", [](uint64_t n) -> uint64_t {
+  return runUnary(n, wideInputs(), [](float x) { return stevesch::degToRad(x); });
+});
+
+MATHBASE_BENCHMARK("scalar/radToDeg", [](uint64_t n) -> uint64_t {
+  return runUnary(n, angleInputs(), [](float x) { return stevesch::radToDeg(x); });
+});
+
+MATHBASE_BENCHMARK("scalar/lerpf", [](uint64_t n) -> uint64_t {
+  return runBinary(n, unitInputs(), unitInputs2(), [](float x, float t) { return stevesch::lerpf(x, 2.0f, t); });
+});
+
+MATHBASE_BENCHMARK("scalar/remapf", [](uint64_t n) -> uint64_t {
+  return runUnary(n, unitInputs(), [](float x) { return stevesch::remapf(x, -1.0f, 1.0f, 10.0f, 20.0f); });
+});
+
+MATHBASE_BENCHMARK("scalar/safeRemapf", [](uint64_t n) -> uint64_t {
+  return runUnary(n, unitInputs(), [](float x) { return stevesch::safeRemapf(x, -1.0f, 1.0f, 10.0f, 20.0f); });
+});
+
+MATHBASE_BENCHMARK("scalar/randf", [](uint64_t n) -> uint64_t {
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(stevesch::randf());
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("scalar/randfAB", [](uint64_t n) -> uint64_t {
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(stevesch::randfAB(-3.0f, 5.0f));
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("scalar/clampf", [](uint64_t n) -> uint64_t {
+  return runUnary(n, unitInputs(), [](float x) { return stevesch::clampf(x, -0.5f, 0.25f); });
+});
+
+MATHBASE_BENCHMARK("scalar/clamp<float>", [](uint64_t n) -> uint64_t {
+  return runUnary(n, unitInputs(), [](float x) { return stevesch::clamp(x, -0.5f, 0.25f); });
+});
+
+MATHBASE_BENCHMARK("scalar/swapf", [](uint64_t n) -> uint64_t {
+  return runBinary(n, unitInputs(), unitInputs2(), [](float x, float y) {
+    stevesch::swapf(x, y);
+    return x - y;
+  });
+});
+
+MATHBASE_BENCHMARK("scalar/wrapUnit", [](uint64_t n) -> uint64_t {
+  return runUnary(n, wideInputs(), [](float x) { return stevesch::wrapUnit(x); });
+});
+
+MATHBASE_BENCHMARK("scalar/closeMod2pi", [](uint64_t n) -> uint64_t {
+  return runUnary(n, angleInputs(), [](float x) { return stevesch::closeMod2pi(0.4f * x); });
+});
+
+MATHBASE_BENCHMARK("scalar/mod2pi", [](uint64_t n) -> uint64_t {
+  return runUnary(n, angleInputs(), [](float x) { return stevesch::mod2pi(x); });
+});
+
+MATHBASE_BENCHMARK("scalar/zeroDeadZone", [](uint64_t n) -> uint64_t {
+  return runUnary(n, unitInputs(), [](float x) { return stevesch::zeroDeadZone(x, 0.2f); });
+});
+
+MATHBASE_BENCHMARK("scalar/zeroDeadZonePolar", [](uint64_t n) -> uint64_t {
+  return runBinary(n, unitInputs(), unitInputs2(), [](float x, float y) {
+    stevesch::zeroDeadZonePolar(x, y, 0.2f);
+    return x + y;
+  });
+});
+
+MATHBASE_BENCHMARK("scalar/lerpInt", [](uint64_t n) -> uint64_t {
+  return runUnary(n, unitInputs(), [](float t) { return stevesch::lerpInt(-100, 250, t); });
+});
+
+//////////////////////////////////////////////////////////////////////
+// mathApprox.h
+
+MATHBASE_BENCHMARK("mathApprox/sinApprox", [](uint64_t n) -> uint64_t {
+  return runUnary(n, angleInputs(), [](float x) { return stevesch::sinApprox(x); });
+});
+
+MATHBASE_BENCHMARK("mathApprox/cosApprox", [](uint64_t n) -> uint64_t {
+  return runUnary(n, angleInputs(), [](float x) { return stevesch::cosApprox(x); });
+});
+
+MATHBASE_BENCHMARK("mathApprox/sinInterp", [](uint64_t n) -> uint64_t {
+  return runUnary(n, unitInputs(), [](float t) { return stevesch::sinInterp(t); });
+});
+
+//////////////////////////////////////////////////////////////////////
+// polyApprox.h accuracy tiers (errors: see testApproxTiers in examples/minimal)
+
+namespace
+{
+  template <int kDegree>
+  uint64_t benchSinTier(uint64_t n)
+  {
+    return runUnary(n, angleInputs(), [](float x) { return stevesch::sinApprox<kDegree>(x); });
+  }
+
+  template <int kDegree>
+  uint64_t benchCosTier(uint64_t n)
+  {
+    return runUnary(n, angleInputs(), [](float x) { return stevesch::cosApprox<kDegree>(x); });
+  }
+
+  template <int kDegree>
+  uint64_t benchSinCosTier(uint64_t n)
+  {
+    return runUnary(n, angleInputs(), [](float x) {
+      float s, c;
+      stevesch::sinCosApprox<kDegree>(x, &s, &c);
+      return s + c;
+    });
+  }
+
+  template <int kDegree>
+  uint64_t benchTanTier(uint64_t n)
+  {
+    return runUnary(n, unitInputs(), [](float x) { return stevesch::tanApprox<kDegree>(1.5f * x); });
+  }
+
+  template <int kDegree>
+  uint64_t benchAtan2Tier(uint64_t n)
+  {
+    return runBinary(n, unitInputs(), unitInputs2(), [](float x, float y) { return stevesch::atan2Approx<kDegree>(x, y); });
+  }
+
+  template <int kDegree>
+  uint64_t benchExpTier(uint64_t n)
+  {
+    return runUnary(n, expInputs(), [](float x) { return stevesch::expApprox<kDegree>(x); });
+  }
+
+  template <int kDegree>
+  uint64_t benchLogTier(uint64_t n)
+  {
+    return runUnary(n, positiveInputs(), [](float x) { return stevesch::logApprox<kDegree>(x); });
+  }
+
+  template <int kDegree>
+  uint64_t benchPowTier(uint64_t n)
+  {
+    return runBinary(n, powBases(), unitInputs(), [](float x, float y) { return stevesch::powApprox<kDegree>(x, 4.0f * y); });
+  }
+} // namespace
+
+MATHBASE_BENCHMARK("mathApprox/sinApprox<3>", benchSinTier<3>);
+MATHBASE_BENCHMARK("mathApprox/sinApprox<5>", benchSinTier<5>);
+MATHBASE_BENCHMARK("mathApprox/sinApprox<7>", benchSinTier<7>);
+MATHBASE_BENCHMARK("mathApprox/sinApprox<9>", benchSinTier<9>);
+MATHBASE_BENCHMARK("mathApprox/cosApprox<3>", benchCosTier<3>);
+MATHBASE_BENCHMARK("mathApprox/cosApprox<5>", benchCosTier<5>);
+MATHBASE_BENCHMARK("mathApprox/cosApprox<7>", benchCosTier<7>);
+MATHBASE_BENCHMARK("mathApprox/cosApprox<9>", benchCosTier<9>);
+MATHBASE_BENCHMARK("mathApprox/sinCosApprox<3>", benchSinCosTier<3>);
+MATHBASE_BENCHMARK("mathApprox/sinCosApprox<5>", benchSinCosTier<5>);
+MATHBASE_BENCHMARK("mathApprox/sinCosApprox<7>", benchSinCosTier<7>);
+// separate calls, for comparison with sinCosApprox<5>
+MATHBASE_BENCHMARK("mathApprox/sinApprox<5>+cosApprox<5>", [](uint64_t n) -> uint64_t {
+  return runUnary(n, angleInputs(), [](float x) { return stevesch::sinApprox<5>(x) + stevesch::cosApprox<5>(x); });
+});
+MATHBASE_BENCHMARK("mathApprox/tanApprox<3>", benchTanTier<3>);
+MATHBASE_BENCHMARK("mathApprox/tanApprox<5>", benchTanTier<5>);
+MATHBASE_BENCHMARK("mathApprox/tanApprox<7>", benchTanTier<7>);
+MATHBASE_BENCHMARK("mathApprox/tanApprox<9>", benchTanTier<9>);
+MATHBASE_BENCHMARK("mathApprox/atan2Approx<5>", benchAtan2Tier<5>);
+MATHBASE_BENCHMARK("mathApprox/atan2Approx<7>", benchAtan2Tier<7>);
+MATHBASE_BENCHMARK("mathApprox/atan2Approx<9>", benchAtan2Tier<9>);
+MATHBASE_BENCHMARK("mathApprox/atan2Approx<11>", benchAtan2Tier<11>);
+MATHBASE_BENCHMARK("mathApprox/atan2Approx<13>", benchAtan2Tier<13>);
+MATHBASE_BENCHMARK("mathApprox/expApprox<3>", benchExpTier<3>);
+MATHBASE_BENCHMARK("mathApprox/expApprox<4>", benchExpTier<4>);
+MATHBASE_BENCHMARK("mathApprox/expApprox<5>", benchExpTier<5>);
+MATHBASE_BENCHMARK("mathApprox/expApprox<6>", benchExpTier<6>);
+MATHBASE_BENCHMARK("mathApprox/logApprox<3>", benchLogTier<3>);
+MATHBASE_BENCHMARK("mathApprox/logApprox<5>", benchLogTier<5>);
+MATHBASE_BENCHMARK("mathApprox/logApprox<7>", benchLogTier<7>);
+MATHBASE_BENCHMARK("mathApprox/powApprox<3>", benchPowTier<3>);
+MATHBASE_BENCHMARK("mathApprox/powApprox<4>", benchPowTier<4>);
+MATHBASE_BENCHMARK("mathApprox/powApprox<5>", benchPowTier<5>);
+MATHBASE_BENCHMARK("mathApprox/powApprox<6>", benchPowTier<6>);
+
+//////////////////////////////////////////////////////////////////////
+// batch versions (ops == elements processed)
+
+namespace
+{
+  template <size_t kCount>
+  const std::vector<float>& batchAngles()
+  {
+    static const std::vector<float> in = bench::uniformFloats(kCount, -20.0f, 20.0f, 16);
+    return in;
+  }
+
+  template <size_t kCount>
+  const std::vector<float>& batchPositive()
+  {
+    static const std::vector<float> in = bench::uniformFloats(kCount, 1.0e-5f, 1.0e+6f, 17);
+    return in;
+  }
+
+  template <size_t kCount, uint32_t kSeed>
+  const std::vector<float>& batchUnit()
+  {
+    static const std::vector<float> in = bench::uniformFloats(kCount, -1.0f, 1.0f, kSeed);
+    return in;
+  }
+
+  template <size_t kCount, typename F>
+  inline uint64_t runBatch(uint64_t iterations, const std::vector<float>& in, F fn)
+  {
+    static std::vector<float> out(kCount);
+    for (uint64_t i=0; i<iterations; ++i) {
+      fn(in.data(), out.data(), kCount);
+      bench::clobberMemory();
+    }
+    return iterations * kCount;
+  }
+
+  template <size_t kCount>
+  uint64_t benchSinBatch(uint64_t n)
+  {
+    return runBatch<kCount>(n, batchAngles<kCount>(),
+      [](const float* in, float* out, size_t count) { stevesch::sinApprox(in, out, count); });
+  }
+
+  template <size_t kCount>
+  uint64_t benchCosBatch(uint64_t n)
+  {
+    return runBatch<kCount>(n, batchAngles<kCount>(),
+      [](const float* in, float* out, size_t count) { stevesch::cosApprox(in, out, count); });
+  }
+
+  template <size_t kCount>
+  uint64_t benchSinCosBatch(uint64_t n)
+  {
+    static std::vector<float> outCos(kCount);
+    return runBatch<kCount>(n, batchAngles<kCount>(),
+      [](const float* in, float* out, size_t count) { stevesch::sinCosApprox(in, out, outCos.data(), count); });
+  }
+
+  // sinApprox and cosApprox batches over the same input
+  template <size_t kCount>
+  uint64_t benchSinPlusCosBatch(uint64_t n)
+  {
+    static std::vector<float> outCos(kCount);
+    return runBatch<kCount>(n, batchAngles<kCount>(), [](const float* in, float* out, size_t count) {
+      stevesch::sinApprox(in, out, count);
+      stevesch::cosApprox(in, outCos.data(), count);
+    });
+  }
+
+  template <size_t kCount>
+  uint64_t benchDeadZoneBatch(uint64_t n)
+  {
+    static std::vector<float> xs(kCount);
+    static std::vector<float> ys(kCount);
+    const std::vector<float>& in0 = batchUnit<kCount, 20>();
+    const std::vector<float>& in1 = batchUnit<kCount, 21>();
+    for (uint64_t i=0; i<n; ++i) {
+      // the batch works in place: restart from the same inputs each time
+      memcpy(xs.data(), in0.data(), kCount * sizeof(float));
+      memcpy(ys.data(), in1.data(), kCount * sizeof(float));
+      stevesch::zeroDeadZonePolar(xs.data(), ys.data(), kCount, 0.2f);
+      bench::clobberMemory();
+    }
+    return n * kCount;
+  }
+
+  // the same work done one call at a time, for comparison
+  template <size_t kCount>
+  uint64_t benchDeadZoneLoop(uint64_t n)
+  {
+    static std::vector<float> xs(kCount);
+    static std::vector<float> ys(kCount);
+    const std::vector<float>& in0 = batchUnit<kCount, 20>();
+    const std::vector<float>& in1 = batchUnit<kCount, 21>();
+    for (uint64_t i=0; i<n; ++i) {
+      memcpy(xs.data(), in0.data(), kCount * sizeof(float));
+      memcpy(ys.data(), in1.data(), kCount * sizeof(float));
+      for (size_t k=0; k<kCount; ++k) {
+        stevesch::zeroDeadZonePolar(xs[k], ys[k], 0.2f);
+      }
+      bench::clobberMemory();
+    }
+    return n * kCount;
+  }
+
+  // zeroDeadZonePolar inputs: pairs in [-2, 2]^2 (inside the dead zone,
+  // between it and 1, and beyond 1), then pairs whose x*x + y*y overflows
+  const std::vector<float>& deadZoneInputs(int component)
+  {
+    static const float kHuge[][2] = {
+      { 1e20f, 0.0f }, { 3e19f, 3e19f }, { -2e19f, 1e-3f }, { FLT_MAX, -FLT_MAX },
+      { INFINITY, 0.0f }, { -INFINITY, 5.0f }, { INFINITY, -INFINITY }, { 0.0f, -1e30f },
+      { 1e38f, 1e37f }, { 2.0f, -INFINITY },
+    };
+    static std::vector<float> in[2];
+    if (in[0].empty()) {
+      for (int c=0; c<2; ++c) {
+        in[c] = (c == 0) ? unitInputs() : unitInputs2();
+        for (float& v : in[c]) {
+          v *= 2.0f;
+        }
+        for (const float* h : kHuge) {
+          in[c].push_back(h[c]);
+        }
+      }
+    }
+    return in[component];
+  }
+
+  // largest component error of zeroDeadZonePolar(deadzone 0.2) applied by
+  // 'apply' to deadZoneInputs(), against the result in double (NaN counts as
+  // an infinite error)
+  template <typename F>
+  bench::ErrorStats deadZoneError(F apply)
+  {
+    const float dz = 0.2f;
+    std::vector<float> xs = deadZoneInputs(0);
+    std::vector<float> ys = deadZoneInputs(1);
+    apply(xs.data(), ys.data(), xs.size());
+    bench::ErrorStats e = {0.0, 0.0};
+    for (size_t i=0; i<xs.size(); ++i) {
+      double x = deadZoneInputs(0)[i];
+      double y = deadZoneInputs(1)[i];
+      if (isinf(x) || isinf(y)) {
+        x = isinf(x) ? copysign(1.0, x) : 0.0;
+        y = isinf(y) ? copysign(1.0, y) : 0.0;
+      }
+      double r = sqrt(x * x + y * y);
+      double scale = (r < dz) ? 0.0 : fmin((r - dz) / (1.0 - dz), 1.0) / r;
+      double err = fmax(fabs(xs[i] - x * scale), fabs(ys[i] - y * scale));
+      err = isnan(err) ? INFINITY : err;
+      e.maxError = (err > e.maxError) ? err : e.maxError;
+      e.rmsError += err * err;
+    }
+    e.rmsError = sqrt(e.rmsError / (double)xs.size());
+    return e;
+  }
+
+  template <size_t kCount>
+  uint64_t benchRsqrtBatch(uint64_t n)
+  {
+    return runBatch<kCount>(n, batchPositive<kCount>(),
+      [](const float* in, float* out, size_t count) { stevesch::rsqrtfApprox(in, out, count); });
+  }
+
+  template <int kIterations, size_t kCount>
+  uint64_t benchRsqrtTierBatch(uint64_t n)
+  {
+    return runBatch<kCount>(n, batchPositive<kCount>(),
+      [](const float* in, float* out, size_t count) { stevesch::rsqrtApprox<kIterations>(in, out, count); });
+  }
+
+  template <int kIterations, size_t kCount>
+  uint64_t benchRsqrtPortableTierBatch(uint64_t n)
+  {
+    return runBatch<kCount>(n, batchPositive<kCount>(),
+      [](const float* in, float* out, size_t count) { stevesch::rsqrtApproxPortable<kIterations>(in, out, count); });
+  }
+
+  template <typename F>
+  bench::ErrorStats rsqrtBatchError(F fn)
+  {
+    const std::vector<float>& in = rsqrtErrorInputs();
+    std::vector<float> out(in.size());
+    fn(in.data(), out.data(), in.size());
+    return bench::relativeErrorOfResults(in, out, rsqrtExact);
+  }
+
+  template <int kIterations>
+  bench::ErrorStats rsqrtTierBatchError()
+  {
+    return rsqrtBatchError([](const float* in, float* out, size_t count) { stevesch::rsqrtApprox<kIterations>(in, out, count); });
+  }
+
+  template <int kIterations>
+  bench::ErrorStats rsqrtPortableTierBatchError()
+  {
+    return rsqrtBatchError([](const float* in, float* out, size_t count) { stevesch::rsqrtApproxPortable<kIterations>(in, out, count); });
+  }
+
+  // the same work done one call at a time, for comparison
+  template <size_t kCount>
+  uint64_t benchSinLoop(uint64_t n)
+  {
+    return runBatch<kCount>(n, batchAngles<kCount>(), [](const float* in, float* out, size_t count) {
+      for (size_t k=0; k<count; ++k) { out[k] = stevesch::sinApprox(in[k]); }
+    });
+  }
+} // namespace
+
+MATHBASE_BENCHMARK("mathApprox/sinApprox[loop 4096]", benchSinLoop<4096>);
+MATHBASE_BENCHMARK("mathApprox/sinApprox[batch 4096]", benchSinBatch<4096>);
+MATHBASE_BENCHMARK("mathApprox/sinApprox[batch 16384]", benchSinBatch<16384>);
+MATHBASE_BENCHMARK("mathApprox/cosApprox[batch 4096]", benchCosBatch<4096>);
+MATHBASE_BENCHMARK("mathApprox/cosApprox[batch 16384]", benchCosBatch<16384>);
+MATHBASE_BENCHMARK("mathApprox/sinCosApprox[batch 4096]", benchSinCosBatch<4096>);
+MATHBASE_BENCHMARK("mathApprox/sinApprox+cosApprox[batch 4096]", benchSinPlusCosBatch<4096>);
+MATHBASE_BENCHMARK("scalar/zeroDeadZonePolar[loop 4096]", benchDeadZoneLoop<4096>);
+MATHBASE_BENCHMARK("scalar/zeroDeadZonePolar[batch 4096]", benchDeadZoneBatch<4096>);
+MATHBASE_ACCURACY("scalar/zeroDeadZonePolar[loop 4096]", []() -> bench::ErrorStats {
+  return deadZoneError([](float* xs, float* ys, size_t count) {
+    for (size_t k=0; k<count; ++k) {
+      stevesch::zeroDeadZonePolar(xs[k], ys[k], 0.2f);
+    }
+  });
+});
+MATHBASE_ACCURACY("scalar/zeroDeadZonePolar[batch 4096]", []() -> bench::ErrorStats {
+  return deadZoneError([](float* xs, float* ys, size_t count) { stevesch::zeroDeadZonePolar(xs, ys, count, 0.2f); });
+});
+MATHBASE_BENCHMARK("scalar/rsqrtfApprox[batch 4096]", benchRsqrtBatch<4096>);
+MATHBASE_BENCHMARK("scalar/rsqrtfApprox[batch 16384]", benchRsqrtBatch<16384>);
+MATHBASE_ACCURACY("scalar/rsqrtfApprox[batch 4096]", []() -> bench::ErrorStats {
+  return rsqrtBatchError([](const float* in, float* out, size_t count) { stevesch::rsqrtfApprox(in, out, count); });
+});
+MATHBASE_BENCHMARK("scalar/rsqrtApprox<0>[batch 4096]", (benchRsqrtTierBatch<0, 4096>));
+MATHBASE_BENCHMARK("scalar/rsqrtApprox<1>[batch 4096]", (benchRsqrtTierBatch<1, 4096>));
+MATHBASE_BENCHMARK("scalar/rsqrtApprox<2>[batch 4096]", (benchRsqrtTierBatch<2, 4096>));
+MATHBASE_BENCHMARK("scalar/rsqrtApprox<3>[batch 4096]", (benchRsqrtTierBatch<3, 4096>));
+MATHBASE_BENCHMARK("scalar/rsqrtApproxPortable<0>[batch 4096]", (benchRsqrtPortableTierBatch<0, 4096>));
+MATHBASE_BENCHMARK("scalar/rsqrtApproxPortable<1>[batch 4096]", (benchRsqrtPortableTierBatch<1, 4096>));
+MATHBASE_BENCHMARK("scalar/rsqrtApproxPortable<2>[batch 4096]", (benchRsqrtPortableTierBatch<2, 4096>));
+MATHBASE_BENCHMARK("scalar/rsqrtApproxPortable<3>[batch 4096]", (benchRsqrtPortableTierBatch<3, 4096>));
+MATHBASE_ACCURACY("scalar/rsqrtApprox<0>[batch 4096]", rsqrtTierBatchError<0>);
+MATHBASE_ACCURACY("scalar/rsqrtApprox<1>[batch 4096]", rsqrtTierBatchError<1>);
+MATHBASE_ACCURACY("scalar/rsqrtApprox<2>[batch 4096]", rsqrtTierBatchError<2>);
+MATHBASE_ACCURACY("scalar/rsqrtApprox<3>[batch 4096]", rsqrtTierBatchError<3>);
+MATHBASE_ACCURACY("scalar/rsqrtApproxPortable<0>[batch 4096]", rsqrtPortableTierBatchError<0>);
+MATHBASE_ACCURACY("scalar/rsqrtApproxPortable<1>[batch 4096]", rsqrtPortableTierBatchError<1>);
+MATHBASE_ACCURACY("scalar/rsqrtApproxPortable<2>[batch 4096]", rsqrtPortableTierBatchError<2>);
+MATHBASE_ACCURACY("scalar/rsqrtApproxPortable<3>[batch 4096]", rsqrtPortableTierBatchError<3>);
@@ -0,0 +1,401 @@
+// Benchmarks for spline.h
+#include "bench.h"
+#include <stevesch-MathBase.h>
+
+namespace bench = stevesch::bench;
+using stevesch::ArcLengthTable;
+using stevesch::BezierBatch;
+using stevesch::BezierCurve;
+using stevesch::CatmullRomSpline;
+using stevesch::VecN;
+
+namespace
+{
+  struct Vec3
+  {
+    float x, y, z;
+  };
+
+  inline Vec3 operator+(const Vec3& a, const Vec3& b) { return Vec3{a.x + b.x, a.y + b.y, a.z + b.z}; }
+  inline Vec3 operator-(const Vec3& a, const Vec3& b) { return Vec3{a.x - b.x, a.y - b.y, a.z - b.z}; }
+  inline Vec3 operator*(const Vec3& a, float s) { return Vec3{a.x * s, a.y * s, a.z * s}; }
+
+  constexpr uint32_t kPointCount = 64;
+  constexpr size_t kSampleCount = 4096;
+
+  const std::vector<Vec3>& controlPoints()
+  {
+    static std::vector<Vec3> points;
+    if (points.empty()) {
+      std::vector<float> c = bench::uniformFloats(kPointCount * 3, -10.0f, 10.0f, 51);
+      for (uint32_t i=0; i<kPointCount; ++i) {
+        points.push_back(Vec3{c[3*i], c[3*i + 1], c[3*i + 2]});
+      }
+    }
+    return points;
+  }
+
+  const CatmullRomSpline<Vec3>& benchSpline()
+  {
+    static const CatmullRomSpline<Vec3> spline(controlPoints().data(), kPointCount);
+    return spline;
+  }
+
+  const std::vector<VecN<3>>& controlPointsN()
+  {
+    static std::vector<VecN<3>> points;
+    if (points.empty()) {
+      for (const Vec3& p : controlPoints()) {
+        points.push_back(VecN<3>(p.x, p.y, p.z));
+      }
+    }
+    return points;
+  }
+
+  const std::vector<float>& splineParameters()
+  {
+    static const std::vector<float> in = bench::uniformFloats(bench::kInputCount, 0.0f, (float)kPointCount, 52);
+    return in;
+  }
+
+  // what evaluating without the cache costs: locate the four control points
+  // (as T_GetSplinePoint does) and build the coefficients (as
+  // T_EvaluateCatmullRom does) on every call
+  Vec3 catmullRomUncached(const Vec3* points, int count, float t)
+  {
+    int k = (int)floorf(t);
+    float u = t - (float)k;
+    const Vec3& p0 = points[(k + count - 1) % count];
+    const Vec3& p1 = points[k % count];
+    const Vec3& p2 = points[(k + 1) % count];
+    const Vec3& p3 = points[(k + 2) % count];
+    Vec3 a = (p3 - p0) * 0.5f + (p1 - p2) * 1.5f;
+    Vec3 b = p0 + p2 * 2.0f - (p1 * 5.0f + p3) * 0.5f;
+    Vec3 c = (p2 - p0) * 0.5f;
+    return ((a * u + b) * u + c) * u + p1;
+  }
+
+  inline float sum(const Vec3& v) { return v.x + v.y + v.z; }
+  inline float sum(const VecN<3>& v) { return v[0] + v[1] + v[2]; }
+  // found by ArcLengthNorm
+  inline float length(const Vec3& v) { return sqrtf(v.x * v.x + v.y * v.y + v.z * v.z); }
+
+  constexpr uint32_t kLongPointCount = 10000;
+
+  const std::vector<Vec3>& longControlPoints()
+  {
+    static std::vector<Vec3> points;
+    if (points.empty()) {
+      std::vector<float> c = bench::uniformFloats(kLongPointCount * 3, -10.0f, 10.0f, 53);
+      for (uint32_t i=0; i<kLongPointCount; ++i) {
+        points.push_back(Vec3{c[3*i], c[3*i + 1], c[3*i + 2]});
+      }
+    }
+    return points;
+  }
+
+  // closed, so 10k segments
+  const CatmullRomSpline<Vec3>& longSpline()
+  {
+    static const CatmullRomSpline<Vec3> spline(longControlPoints().data(), kLongPointCount, true);
+    return spline;
+  }
+
+  const ArcLengthTable<>& longTable()
+  {
+    static ArcLengthTable<> table;
+    if (table.isStale(longSpline())) {
+      table.build(longSpline());
+    }
+    return table;
+  }
+
+  const std::vector<float>& distances()
+  {
+    static const std::vector<float> in = bench::uniformFloats(bench::kInputCount, 0.0f, longTable().getLength(), 54);
+    return in;
+  }
+
+  const std::vector<float>& longParameters()
+  {
+    static const std::vector<float> in = bench::uniformFloats(bench::kInputCount, 0.0f, (float)kLongPointCount, 55);
+    return in;
+  }
+
+  const BezierCurve<Vec3>& benchBezier()
+  {
+    static BezierCurve<Vec3> curve;
+    if (curve.knotCount() == 0) {
+      const std::vector<Vec3>& points = controlPoints();
+      std::vector<Vec3> tangents(kPointCount);
+      for (uint32_t i=0; i<kPointCount; ++i) {
+        tangents[i] = (points[(i + 1) % kPointCount] - points[(i + kPointCount - 1) % kPointCount]) * (1.0f / 6.0f);
+      }
+      curve.setKnots(points.data(), tangents.data(), kPointCount);
+    }
+    return curve;
+  }
+} // namespace
+
+MATHBASE_BENCHMARK("spline/CatmullRom[uncached]", [](uint64_t n) -> uint64_t {
+  const float* t = splineParameters().data();
+  const Vec3* points = controlPoints().data();
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(sum(catmullRomUncached(points, (int)kPointCount, t[i & bench::kInputMask])));
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("spline/CatmullRomSpline::evaluate", [](uint64_t n) -> uint64_t {
+  const float* t = splineParameters().data();
+  const CatmullRomSpline<Vec3>& spline = benchSpline();
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(sum(spline.evaluate(t[i & bench::kInputMask])));
+  }
+  return n;
+});
+
+// the same with padded, aligned VecN<3> points
+MATHBASE_BENCHMARK("spline/T_GetSplinePoint<VecN<3>>", [](uint64_t n) -> uint64_t {
+  const float* t = splineParameters().data();
+  const VecN<3>* points = controlPointsN().data();
+  for (uint64_t i=0; i<n; ++i) {
+    VecN<3> p;
+    stevesch::T_GetSplinePoint(points, (int)kPointCount, t[i & bench::kInputMask], &p);
+    bench::doNotOptimize(sum(p));
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("spline/CatmullRomSpline<VecN<3>>::evaluate", [](uint64_t n) -> uint64_t {
+  static const CatmullRomSpline<VecN<3>> spline(controlPointsN().data(), kPointCount);
+  const float* t = splineParameters().data();
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(sum(spline.evaluate(t[i & bench::kInputMask])));
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("spline/CatmullRomSpline::evaluateTangent", [](uint64_t n) -> uint64_t {
+  const float* t = splineParameters().data();
+  const CatmullRomSpline<Vec3>& spline = benchSpline();
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(sum(spline.evaluateTangent(t[i & bench::kInputMask])));
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("spline/CatmullRomSpline::setPoint", [](uint64_t n) -> uint64_t {
+  static CatmullRomSpline<Vec3> spline(controlPoints().data(), kPointCount);
+  const std::vector<Vec3>& points = controlPoints();
+  for (uint64_t i=0; i<n; ++i) {
+    uint32_t k = (uint32_t)(i % kPointCount);
+    spline.setPoint(k, points[(k + 1) % kPointCount]);
+  }
+  bench::clobberMemory();
+  return n;
+});
+
+//////////////////////////////////////////////////////////////////////
+// sampling the whole spline (ops == points produced)
+
+MATHBASE_BENCHMARK("spline/CatmullRom[uncached, loop 4096]", [](uint64_t n) -> uint64_t {
+  static std::vector<Vec3> out(kSampleCount);
+  const Vec3* points = controlPoints().data();
+  const float h = (float)kPointCount / (float)(kSampleCount - 1);
+  for (uint64_t i=0; i<n; ++i) {
+    for (size_t k=0; k<kSampleCount; ++k) {
+      out[k] = catmullRomUncached(points, (int)kPointCount, (float)k * h);
+    }
+    bench::clobberMemory();
+  }
+  return n * kSampleCount;
+});
+
+MATHBASE_BENCHMARK("spline/CatmullRomSpline::evaluate[loop 4096]", [](uint64_t n) -> uint64_t {
+  static std::vector<Vec3> out(kSampleCount);
+  const CatmullRomSpline<Vec3>& spline = benchSpline();
+  const float h = spline.getEndParameter() / (float)(kSampleCount - 1);
+  for (uint64_t i=0; i<n; ++i) {
+    for (size_t k=0; k<kSampleCount; ++k) {
+      out[k] = spline.evaluate((float)k * h);
+    }
+    bench::clobberMemory();
+  }
+  return n * kSampleCount;
+});
+
+MATHBASE_BENCHMARK("spline/CatmullRomSpline::sample[4096]", [](uint64_t n) -> uint64_t {
+  static std::vector<Vec3> out(kSampleCount);
+  const CatmullRomSpline<Vec3>& spline = benchSpline();
+  for (uint64_t i=0; i<n; ++i) {
+    spline.sample(0.0f, spline.getEndParameter(), (uint32_t)kSampleCount, out.data());
+    bench::clobberMemory();
+  }
+  return n * kSampleCount;
+});
+
+MATHBASE_BENCHMARK("spline/BezierCurve::evaluate", [](uint64_t n) -> uint64_t {
+  const float* t = splineParameters().data();
+  const BezierCurve<Vec3>& curve = benchBezier();
+  const float scale = curve.getEndParameter() / (float)kPointCount;
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(sum(curve.evaluate(t[i & bench::kInputMask] * scale)));
+  }
+  return n;
+});
+
+//////////////////////////////////////////////////////////////////////
+// arc length over a 10k-segment spline
+
+// ops == segments measured
+MATHBASE_BENCHMARK("spline/ArcLengthTable::build[10k segments]", [](uint64_t n) -> uint64_t {
+  static ArcLengthTable<> table;
+  const CatmullRomSpline<Vec3>& spline = longSpline();
+  for (uint64_t i=0; i<n; ++i) {
+    table.build(spline);
+    bench::doNotOptimize(table.getLength());
+  }
+  return n * kLongPointCount;
+});
+
+// ops == calls (each re-measures the 4 segments one point affects)
+MATHBASE_BENCHMARK("spline/ArcLengthTable::rebuildSegments[4 of 10k]", [](uint64_t n) -> uint64_t {
+  static CatmullRomSpline<Vec3> spline(longControlPoints().data(), kLongPointCount, true);
+  static ArcLengthTable<> table;
+  if (table.isStale(spline)) {
+    table.build(spline);
+  }
+  const std::vector<Vec3>& points = longControlPoints();
+  for (uint64_t i=0; i<n; ++i) {
+    uint32_t k = (uint32_t)(i % kLongPointCount);
+    spline.setPoint(k, points[(k + 1) % kLongPointCount]);
+    table.rebuildSegments(spline, (int32_t)k - 2, 4);
+  }
+  bench::doNotOptimize(table.getLength());
+  return n;
+});
+
+MATHBASE_BENCHMARK("spline/ArcLengthTable::parameterAt[10k segments]", [](uint64_t n) -> uint64_t {
+  const float* s = distances().data();
+  const ArcLengthTable<>& table = longTable();
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(table.parameterAt(s[i & bench::kInputMask]));
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("spline/ArcLengthTable::parameterAt(curve)[10k segments]", [](uint64_t n) -> uint64_t {
+  const float* s = distances().data();
+  const ArcLengthTable<>& table = longTable();
+  const CatmullRomSpline<Vec3>& spline = longSpline();
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(table.parameterAt(spline, s[i & bench::kInputMask]));
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("spline/ArcLengthTable::distanceAt[10k segments]", [](uint64_t n) -> uint64_t {
+  const float* t = longParameters().data();
+  const ArcLengthTable<>& table = longTable();
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(table.distanceAt(t[i & bench::kInputMask]));
+  }
+  return n;
+});
+
+//////////////////////////////////////////////////////////////////////
+// many independent Bezier curves (e.g. one per particle trail);
+// ops == curves evaluated
+
+namespace
+{
+  constexpr uint32_t kCurveCount = 16384;
+
+  struct CurvesAoS
+  {
+    std::vector<VecN<3>> p0, t0, p1, t1;
+  };
+
+  const CurvesAoS& curvesAoS()
+  {
+    static CurvesAoS curves;
+    if (curves.p0.empty()) {
+      std::vector<float> c = bench::uniformFloats(kCurveCount * 12, -10.0f, 10.0f, 56);
+      const float* p = c.data();
+      for (uint32_t i=0; i<kCurveCount; ++i, p += 12) {
+        curves.p0.push_back(VecN<3>(p[0], p[1], p[2]));
+        curves.t0.push_back(VecN<3>(p[3], p[4], p[5]));
+        curves.p1.push_back(VecN<3>(p[6], p[7], p[8]));
+        curves.t1.push_back(VecN<3>(p[9], p[10], p[11]));
+      }
+    }
+    return curves;
+  }
+
+  const BezierBatch& curvesSoA()
+  {
+    static BezierBatch batch(3);
+    if (batch.size() == 0) {
+      const CurvesAoS& c = curvesAoS();
+      batch.resize(kCurveCount);
+      for (uint32_t i=0; i<kCurveCount; ++i) {
+        batch.setCurve(i, c.p0[i].v, c.t0[i].v, c.p1[i].v, c.t1[i].v);
+      }
+    }
+    return batch;
+  }
+
+  const std::vector<float>& curveParameters()
+  {
+    static const std::vector<float> in = bench::uniformFloats(kCurveCount, 0.0f, 1.0f, 57);
+    return in;
+  }
+} // namespace
+
+MATHBASE_BENCHMARK("spline/T_GetBezierPoint[loop 16k curves, shared t]", [](uint64_t n) -> uint64_t {
+  static std::vector<VecN<3>> out(kCurveCount);
+  const CurvesAoS& c = curvesAoS();
+  for (uint64_t k=0; k<n; ++k) {
+    float t = (float)(k & 1023) * (1.0f / 1023.0f);
+    for (uint32_t i=0; i<kCurveCount; ++i) {
+      stevesch::T_GetBezierPoint(out[i], c.p0[i], c.t0[i], c.p1[i], c.t1[i], t);
+    }
+    bench::clobberMemory();
+  }
+  return n * kCurveCount;
+});
+
+MATHBASE_BENCHMARK("spline/T_GetBezierPoint[loop 16k curves, per-curve t]", [](uint64_t n) -> uint64_t {
+  static std::vector<VecN<3>> out(kCurveCount);
+  const CurvesAoS& c = curvesAoS();
+  const float* t = curveParameters().data();
+  for (uint64_t k=0; k<n; ++k) {
+    for (uint32_t i=0; i<kCurveCount; ++i) {
+      stevesch::T_GetBezierPoint(out[i], c.p0[i], c.t0[i], c.p1[i], c.t1[i], t[i]);
+    }
+    bench::clobberMemory();
+  }
+  return n * kCurveCount;
+});
+
+MATHBASE_BENCHMARK("spline/BezierBatch::evaluate[16k curves, shared t]", [](uint64_t n) -> uint64_t {
+  static std::vector<float> out(3 * kCurveCount);
+  const BezierBatch& batch = curvesSoA();
+  for (uint64_t k=0; k<n; ++k) {
+    batch.evaluate((float)(k & 1023) * (1.0f / 1023.0f), out.data());
+    bench::clobberMemory();
+  }
+  return n * kCurveCount;
+});
+
+MATHBASE_BENCHMARK("spline/BezierBatch::evaluate[16k curves, per-curve t]", [](uint64_t n) -> uint64_t {
+  static std::vector<float> out(3 * kCurveCount);
+  const BezierBatch& batch = curvesSoA();
+  const float* t = curveParameters().data();
+  for (uint64_t k=0; k<n; ++k) {
+    batch.evaluate(t, out.data());
+    bench::clobberMemory();
+  }
+  return n * kCurveCount;
+});
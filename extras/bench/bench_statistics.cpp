@@ -0,0 +1,411 @@
+// Benchmarks for statistics.h
+#include "bench.h"
+#include <stevesch-MathBase.h>
+#include <algorithm>
+
+namespace bench = stevesch::bench;
+using stevesch::ProbabilityTable;
+using stevesch::RandGen;
+
+namespace
+{
+  const std::vector<float>& weightInputs()
+  {
+    static const std::vector<float> in = bench::uniformFloats(bench::kInputCount, 0.1f, 10.0f, 51);
+    return in;
+  }
+
+  const std::vector<float>& probabilityInputs()
+  {
+    static const std::vector<float> in = bench::uniformFloats(bench::kInputCount, 0.0f, 1.0f, 52);
+    return in;
+  }
+
+  ProbabilityTable<int> makeTable(size_t entries)
+  {
+    ProbabilityTable<int> table;
+    const float* w = weightInputs().data();
+    for (size_t k=0; k<entries; ++k) {
+      table.insert(w[k & bench::kInputMask], (int)k);
+    }
+    return table;
+  }
+
+  template <size_t kEntries>
+  const ProbabilityTable<int>& table()
+  {
+    static const ProbabilityTable<int> t = makeTable(kEntries);
+    return t;
+  }
+
+  template <size_t kEntries>
+  const ProbabilityTable<int>& finalizedTable()
+  {
+    static const ProbabilityTable<int> t = [] {
+      ProbabilityTable<int> table = makeTable(kEntries);
+      table.finalize();
+      return table;
+    }();
+    return t;
+  }
+
+  template <size_t kEntries>
+  uint64_t benchGet(uint64_t n)
+  {
+    const ProbabilityTable<int>& t = table<kEntries>();
+    const float* p = probabilityInputs().data();
+    for (uint64_t i=0; i<n; ++i) {
+      bench::doNotOptimize(t.get(p[i & bench::kInputMask]));
+    }
+    return n;
+  }
+
+  template <size_t kEntries>
+  uint64_t benchGetRandom(uint64_t n)
+  {
+    const ProbabilityTable<int>& t = table<kEntries>();
+    static RandGen r(777U);
+    for (uint64_t i=0; i<n; ++i) {
+      bench::doNotOptimize(t.getRandom(r));
+    }
+    return n;
+  }
+
+  template <size_t kEntries>
+  uint64_t benchGetAlias(uint64_t n)
+  {
+    const ProbabilityTable<int>& t = finalizedTable<kEntries>();
+    static const std::vector<uint32_t> u = bench::uniformU32(bench::kInputCount, 53);
+    for (uint64_t i=0; i<n; ++i) {
+      bench::doNotOptimize(t.getAlias(u[i & bench::kInputMask]));
+    }
+    return n;
+  }
+
+  template <size_t kEntries>
+  uint64_t benchGetRandomFinalized(uint64_t n)
+  {
+    const ProbabilityTable<int>& t = finalizedTable<kEntries>();
+    static RandGen r(777U);
+    for (uint64_t i=0; i<n; ++i) {
+      bench::doNotOptimize(t.getRandom(r));
+    }
+    return n;
+  }
+
+  // ops == number of inserts
+  template <size_t kEntries>
+  uint64_t benchBuildBulk(uint64_t n)
+  {
+    std::vector<std::pair<float, int> > entries(kEntries);
+    const float* w = weightInputs().data();
+    for (size_t k=0; k<kEntries; ++k) {
+      entries[k] = std::make_pair(w[k & bench::kInputMask], (int)k);
+    }
+    for (uint64_t i=0; i<n; ++i) {
+      ProbabilityTable<int> t;
+      t.insert(entries.begin(), entries.end());
+      t.finalize();
+      bench::doNotOptimize(t);
+    }
+    return n * kEntries;
+  }
+
+  // ops == number of inserts
+  template <size_t kEntries>
+  uint64_t benchBuild(uint64_t n)
+  {
+    for (uint64_t i=0; i<n; ++i) {
+      ProbabilityTable<int> t = makeTable(kEntries);
+      bench::doNotOptimize(t);
+    }
+    return n * kEntries;
+  }
+} // namespace
+
+MATHBASE_BENCHMARK("statistics/RateAccumulator::update", [](uint64_t n) -> uint64_t {
+  stevesch::RateAccumulator acc(30.0f);
+  const float* p = probabilityInputs().data();
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(acc.update(p[i & bench::kInputMask] * 0.1f));
+  }
+  return n;
+});
+
+MATHBASE_BENCHMARK("statistics/ProbabilityTable::insert[16]", benchBuild<16>);
+MATHBASE_BENCHMARK("statistics/ProbabilityTable::insert[1024]", benchBuild<1024>);
+MATHBASE_BENCHMARK("statistics/ProbabilityTable::get[16]", benchGet<16>);
+MATHBASE_BENCHMARK("statistics/ProbabilityTable::get[1024]", benchGet<1024>);
+MATHBASE_BENCHMARK("statistics/ProbabilityTable::getRandom[16]", benchGetRandom<16>);
+MATHBASE_BENCHMARK("statistics/ProbabilityTable::getRandom[1024]", benchGetRandom<1024>);
+MATHBASE_BENCHMARK("statistics/ProbabilityTable::get[65536]", benchGet<65536>);
+MATHBASE_BENCHMARK("statistics/ProbabilityTable::getAlias[16]", benchGetAlias<16>);
+MATHBASE_BENCHMARK("statistics/ProbabilityTable::getAlias[1024]", benchGetAlias<1024>);
+MATHBASE_BENCHMARK("statistics/ProbabilityTable::getAlias[65536]", benchGetAlias<65536>);
+MATHBASE_BENCHMARK("statistics/ProbabilityTable::getRandom[16, finalized]", benchGetRandomFinalized<16>);
+MATHBASE_BENCHMARK("statistics/ProbabilityTable::getRandom[1024, finalized]", benchGetRandomFinalized<1024>);
+MATHBASE_BENCHMARK("statistics/ProbabilityTable::getRandom[65536, finalized]", benchGetRandomFinalized<65536>);
+MATHBASE_BENCHMARK("statistics/ProbabilityTable::insert+finalize[bulk 1024]", benchBuildBulk<1024>);
+MATHBASE_BENCHMARK("statistics/ProbabilityTable::insert+finalize[bulk 65536]", benchBuildBulk<65536>);
+
+//////////////////////////////////////////////////////////////////////
+// DynamicProbabilityTable vs. ProbabilityTable when weights change
+// (ops == one weight change followed by one sample)
+
+namespace
+{
+  using stevesch::DynamicProbabilityTable;
+
+  template <size_t kEntries>
+  DynamicProbabilityTable<int>& dynamicTable()
+  {
+    static DynamicProbabilityTable<int> t;
+    if (t.size() == 0) {
+      const float* w = weightInputs().data();
+      for (size_t k=0; k<kEntries; ++k) {
+        t.insert(w[k & bench::kInputMask], (int)k);
+      }
+    }
+    return t;
+  }
+
+  template <size_t kEntries>
+  uint64_t benchDynamicGet(uint64_t n)
+  {
+    const DynamicProbabilityTable<int>& t = dynamicTable<kEntries>();
+    const float* p = probabilityInputs().data();
+    for (uint64_t i=0; i<n; ++i) {
+      bench::doNotOptimize(t.get(p[i & bench::kInputMask]));
+    }
+    return n;
+  }
+
+  template <size_t kEntries>
+  uint64_t benchDynamicUpdate(uint64_t n)
+  {
+    DynamicProbabilityTable<int>& t = dynamicTable<kEntries>();
+    const float* w = weightInputs().data();
+    const float* p = probabilityInputs().data();
+    for (uint64_t i=0; i<n; ++i) {
+      uint32_t h = (uint32_t)((i * 2654435761U) % kEntries);
+      t.updateWeight(h, w[(i + 17) & bench::kInputMask]);
+      bench::doNotOptimize(t.get(p[i & bench::kInputMask]));
+    }
+    return n;
+  }
+
+  // the static table has to be rebuilt for every change
+  template <size_t kEntries>
+  uint64_t benchStaticUpdate(uint64_t n)
+  {
+    static std::vector<std::pair<float, int> > entries;
+    if (entries.empty()) {
+      const float* w = weightInputs().data();
+      for (size_t k=0; k<kEntries; ++k) {
+        entries.push_back(std::make_pair(w[k & bench::kInputMask], (int)k));
+      }
+    }
+    const float* w = weightInputs().data();
+    const float* p = probabilityInputs().data();
+    ProbabilityTable<int> t;
+    for (uint64_t i=0; i<n; ++i) {
+      entries[(i * 2654435761U) % kEntries].first = w[(i + 17) & bench::kInputMask];
+      t.clear();
+      t.insert(entries.begin(), entries.end());
+      bench::doNotOptimize(t.get(p[i & bench::kInputMask]));
+    }
+    return n;
+  }
+} // namespace
+
+MATHBASE_BENCHMARK("statistics/DynamicProbabilityTable::get[10]", benchDynamicGet<10>);
+MATHBASE_BENCHMARK("statistics/DynamicProbabilityTable::get[1000]", benchDynamicGet<1000>);
+MATHBASE_BENCHMARK("statistics/DynamicProbabilityTable::get[100000]", benchDynamicGet<100000>);
+MATHBASE_BENCHMARK("statistics/DynamicProbabilityTable::updateWeight+get[10]", benchDynamicUpdate<10>);
+MATHBASE_BENCHMARK("statistics/DynamicProbabilityTable::updateWeight+get[1000]", benchDynamicUpdate<1000>);
+MATHBASE_BENCHMARK("statistics/DynamicProbabilityTable::updateWeight+get[100000]", benchDynamicUpdate<100000>);
+MATHBASE_BENCHMARK("statistics/ProbabilityTable::rebuild+get[10]", benchStaticUpdate<10>);
+MATHBASE_BENCHMARK("statistics/ProbabilityTable::rebuild+get[1000]", benchStaticUpdate<1000>);
+MATHBASE_BENCHMARK("statistics/ProbabilityTable::rebuild+get[100000]", benchStaticUpdate<100000>);
+
+//////////////////////////////////////////////////////////////////////
+// streaming accumulators (ops == values pushed)
+
+namespace
+{
+  using stevesch::Ewma;
+  using stevesch::MeanVariance;
+  using stevesch::MinMax;
+  using stevesch::Moments;
+
+  // a sensor-like stream: a large offset with small variations
+  const std::vector<float>& sampleInputs()
+  {
+    static const std::vector<float> in = bench::uniformFloats(bench::kInputCount, 990.0f, 1010.0f, 54);
+    return in;
+  }
+
+  template <typename Accumulator>
+  uint64_t benchPush(uint64_t n)
+  {
+    Accumulator acc;
+    const float* p = sampleInputs().data();
+    for (uint64_t i=0; i<n; ++i) {
+      acc.push(p[i & bench::kInputMask]);
+    }
+    bench::doNotOptimize(acc);
+    return n;
+  }
+
+  template <typename Accumulator>
+  uint64_t benchPushBatch(uint64_t n)
+  {
+    Accumulator acc;
+    const float* p = sampleInputs().data();
+    for (uint64_t i=0; i<n; ++i) {
+      acc.push(p, bench::kInputCount);
+    }
+    bench::doNotOptimize(acc);
+    return n * bench::kInputCount;
+  }
+} // namespace
+
+// what the accumulators replace: sum and sum of squares (which loses the
+// variance of offset data to cancellation)
+MATHBASE_BENCHMARK("statistics/sum+sumOfSquares[loop 4096]", [](uint64_t n) -> uint64_t {
+  const float* p = sampleInputs().data();
+  for (uint64_t i=0; i<n; ++i) {
+    float sum = 0.0f;
+    float sumOfSquares = 0.0f;
+    for (size_t k=0; k<bench::kInputCount; ++k) {
+      sum += p[k];
+      sumOfSquares += p[k] * p[k];
+    }
+    bench::doNotOptimize(sum);
+    bench::doNotOptimize(sumOfSquares);
+  }
+  return n * bench::kInputCount;
+});
+
+MATHBASE_BENCHMARK("statistics/MeanVariance::push", benchPush<MeanVariance>);
+MATHBASE_BENCHMARK("statistics/MeanVariance::push[batch 4096]", benchPushBatch<MeanVariance>);
+MATHBASE_BENCHMARK("statistics/Moments::push", benchPush<Moments>);
+MATHBASE_BENCHMARK("statistics/Moments::push[batch 4096]", benchPushBatch<Moments>);
+MATHBASE_BENCHMARK("statistics/MinMax::push", benchPush<MinMax>);
+MATHBASE_BENCHMARK("statistics/MinMax::push[batch 4096]", benchPushBatch<MinMax>);
+MATHBASE_BENCHMARK("statistics/Ewma::push", benchPush<Ewma>);
+
+// ops == merges
+MATHBASE_BENCHMARK("statistics/Moments::merge", [](uint64_t n) -> uint64_t {
+  Moments parts[4];
+  const float* p = sampleInputs().data();
+  for (int k=0; k<4; ++k) {
+    parts[k].push(p + k * 1024, 1024);
+  }
+  Moments total;
+  for (uint64_t i=0; i<n; ++i) {
+    total.merge(parts[i & 3]);
+  }
+  bench::doNotOptimize(total);
+  return n;
+});
+
+//////////////////////////////////////////////////////////////////////
+// quantiles of a stream: QuantileSketch vs sorting everything
+
+namespace
+{
+  using stevesch::QuantileSketch;
+
+  const size_t kLatencyCount = 65536;
+
+  // latency-like values: log-uniform over 1 .. ~3e6 (e.g. us)
+  const std::vector<float>& latencyInputs()
+  {
+    static std::vector<float> in;
+    if (in.empty()) {
+      in = bench::uniformFloats(kLatencyCount, 0.0f, 15.0f, 55);
+      for (float& x : in) {
+        x = expf(x);
+      }
+    }
+    return in;
+  }
+
+  const float kQuantiles[] = { 0.5f, 0.9f, 0.99f, 0.999f };
+
+  QuantileSketch makeSketch(const float* p, size_t n)
+  {
+    QuantileSketch sketch;
+    sketch.add(p, n);
+    return sketch;
+  }
+} // namespace
+
+// ops == values added
+MATHBASE_BENCHMARK("statistics/QuantileSketch::add", [](uint64_t n) -> uint64_t {
+  QuantileSketch sketch;
+  const float* p = latencyInputs().data();
+  for (uint64_t i=0; i<n; ++i) {
+    sketch.add(p[i & (kLatencyCount - 1)]);
+  }
+  bench::doNotOptimize(sketch.count());
+  return n;
+});
+
+MATHBASE_BENCHMARK("statistics/QuantileSketch::add[batch 64k]", [](uint64_t n) -> uint64_t {
+  QuantileSketch sketch;
+  const float* p = latencyInputs().data();
+  for (uint64_t i=0; i<n; ++i) {
+    sketch.add(p, kLatencyCount);
+  }
+  bench::doNotOptimize(sketch.count());
+  return n * kLatencyCount;
+});
+
+// ops == values; the exact answer: copy, sort and pick the same quantiles
+MATHBASE_BENCHMARK("statistics/std::sort+pick[64k]", [](uint64_t n) -> uint64_t {
+  std::vector<float> sorted;
+  for (uint64_t i=0; i<n; ++i) {
+    sorted = latencyInputs();
+    std::sort(sorted.begin(), sorted.end());
+    for (float q : kQuantiles) {
+      bench::doNotOptimize(sorted[(size_t)(q * (float)(kLatencyCount - 1))]);
+    }
+  }
+  return n * kLatencyCount;
+});
+
+// ops == quantile queries (p50, p90, p99, p999 in turn)
+MATHBASE_BENCHMARK("statistics/QuantileSketch::quantile", [](uint64_t n) -> uint64_t {
+  static const QuantileSketch sketch = makeSketch(latencyInputs().data(), kLatencyCount);
+  for (uint64_t i=0; i<n; ++i) {
+    bench::doNotOptimize(sketch.quantile(kQuantiles[i & 3]));
+  }
+  return n;
+});
+
+// ops == merges of a 16k-value sketch (~1000 buckets)
+MATHBASE_BENCHMARK("statistics/QuantileSketch::merge", [](uint64_t n) -> uint64_t {
+  static const QuantileSketch part = makeSketch(latencyInputs().data(), kLatencyCount / 4);
+  QuantileSketch total;
+  for (uint64_t i=0; i<n; ++i) {
+    total.merge(part);
+  }
+  bench::doNotOptimize(total.count());
+  return n;
+});
+
+// relative error of p50, p90, p99 and p999 against the sorted values
+MATHBASE_ACCURACY("statistics/QuantileSketch::quantile", []() -> bench::ErrorStats {
+  static std::vector<float> sorted;
+  if (sorted.empty()) {
+    sorted = latencyInputs();
+    std::sort(sorted.begin(), sorted.end());
+  }
+  QuantileSketch sketch = makeSketch(latencyInputs().data(), kLatencyCount);
+  std::vector<float> quantiles(kQuantiles, kQuantiles + 4);
+  return bench::measureError(quantiles,
+    [&](size_t i) { return sketch.quantile(quantiles[i]); },
+    [&](float q) { return sorted[(size_t)(q * (float)(kLatencyCount - 1))]; }, true);
+});
@@ -0,0 +1,36 @@
+#ifndef STEVESCH_MATHBASE_EXTRAS_HOST_ARDUINO_H_
+#define STEVESCH_MATHBASE_EXTRAS_HOST_ARDUINO_H_
+// Minimal stand-in for the Arduino core, used only by the host (Linux/macOS)
+// build in CMakeLists.txt.  It provides just enough of the Arduino API for
+// the library, the example sketch and the benchmarks to compile and run
+// natively.  Device builds never see this file.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+#include "Stream.h"
+
+unsigned long micros();
+unsigned long millis();
+void delay(unsigned long ms);
+
+// Serial port replacement that writes to stdout.
+class HardwareSerial : public Stream
+{
+public:
+  void begin(unsigned long baud) { (void)baud; }
+  void end() {}
+  explicit operator bool() const { return true; }
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  void flush() override;
+};
+
+extern HardwareSerial Serial;
+
+#endif
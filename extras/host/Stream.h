@@ -0,0 +1,41 @@
+#ifndef STEVESCH_MATHBASE_EXTRAS_HOST_STREAM_H_
+#define STEVESCH_MATHBASE_EXTRAS_HOST_STREAM_H_
+// Host replacement for the Arduino Print/Stream classes (see Arduino.h).
+// Only output is supported; formatting follows the Arduino core (e.g.
+// floating-point values print with 2 decimal places by default).
+
+#include <stdint.h>
+#include <stddef.h>
+
+class Print
+{
+public:
+  virtual ~Print() {}
+
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size);
+  virtual void flush() {}
+
+  size_t print(const char* s);
+  size_t print(char c);
+  size_t print(int n);
+  size_t print(unsigned int n);
+  size_t print(long n);
+  size_t print(unsigned long n);
+  size_t print(long long n);
+  size_t print(unsigned long long n);
+  size_t print(double n, int digits = 2);
+
+  size_t println();
+  template <typename T>
+  size_t println(const T& value) { return print(value) + println(); }
+  size_t println(double n, int digits) { return print(n, digits) + println(); }
+
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print
+{
+};
+
+#endif
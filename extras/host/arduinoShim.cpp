@@ -0,0 +1,97 @@
+#include "Arduino.h"
+
+#include <chrono>
+#include <thread>
+#include <stdarg.h>
+#include <stdio.h>
+
+namespace {
+  typedef std::chrono::steady_clock clock_type;
+  const clock_type::time_point s_startTime = clock_type::now();
+} // namespace
+
+unsigned long micros()
+{
+  auto elapsed = clock_type::now() - s_startTime;
+  return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+unsigned long millis()
+{
+  auto elapsed = clock_type::now() - s_startTime;
+  return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+}
+
+void delay(unsigned long ms)
+{
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+size_t Print::write(const uint8_t* buffer, size_t size)
+{
+  size_t n = 0;
+  while (size--) {
+    n += write(*buffer++);
+  }
+  return n;
+}
+
+size_t Print::print(const char* s)
+{
+  return write((const uint8_t*)s, strlen(s));
+}
+
+size_t Print::print(char c) { return write((uint8_t)c); }
+size_t Print::print(int n) { return printf("%d", n); }
+size_t Print::print(unsigned int n) { return printf("%u", n); }
+size_t Print::print(long n) { return printf("%ld", n); }
+size_t Print::print(unsigned long n) { return printf("%lu", n); }
+size_t Print::print(long long n) { return printf("%lld", n); }
+size_t Print::print(unsigned long long n) { return printf("%llu", n); }
+size_t Print::print(double n, int digits) { return printf("%.*f", digits, n); }
+
+size_t Print::println() { return print("\r\n"); }
+
+size_t Print::printf(const char* format, ...)
+{
+  char buffer[256];
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  if (len < 0) {
+    return 0;
+  }
+  if ((size_t)len < sizeof(buffer)) {
+    return write((const uint8_t*)buffer, (size_t)len);
+  }
+
+  char* large = new char[len + 1];
+  va_start(args, format);
+  vsnprintf(large, len + 1, format, args);
+  va_end(args);
+  size_t n = write((const uint8_t*)large, (size_t)len);
+  delete[] large;
+  return n;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+HardwareSerial Serial;
+
+size_t HardwareSerial::write(uint8_t c)
+{
+  return (fputc(c, stdout) == EOF) ? 0 : 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size)
+{
+  return fwrite(buffer, 1, size, stdout);
+}
+
+void HardwareSerial::flush()
+{
+  fflush(stdout);
+}
@@ -0,0 +1,13 @@
+// Entry point for running an Arduino sketch on the host: setup() runs once
+// and loop() is not called (the example sketches do all of their work in
+// setup()).
+#include "Arduino.h"
+
+void setup();
+
+int main()
+{
+  setup();
+  Serial.flush();
+  return 0;
+}
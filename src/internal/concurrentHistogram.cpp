@@ -0,0 +1,102 @@
+#include "mathBase.h"
+#include "concurrentHistogram.h"
+
+#include <thread>
+
+namespace stevesch {
+
+namespace {
+  constexpr uint32_t kCacheLineBytes = 64;
+  constexpr uint32_t kCacheLineBins = kCacheLineBytes / sizeof(int32_t);
+  constexpr uint32_t kMaxShards = 64;
+
+  uint32_t defaultShardCount()
+  {
+#if defined(ARDUINO_ARCH_ESP32)
+    return portNUM_PROCESSORS;
+#else
+    uint32_t n = std::thread::hardware_concurrency();
+    return (n > 0) ? n : 1;
+#endif
+  }
+} // namespace
+
+uint32_t ConcurrentHistogram::currentThreadSlot()
+{
+#if defined(ARDUINO_ARCH_ESP32)
+  return (uint32_t)xPortGetCoreID();
+#else
+  static std::atomic<uint32_t> s_nextSlot(0);
+  static thread_local uint32_t t_slot = s_nextSlot.fetch_add(1, std::memory_order_relaxed);
+  return t_slot;
+#endif
+}
+
+ConcurrentHistogram::ConcurrentHistogram(float a, float b, uint32_t binCount, Mode mode, uint32_t shardCount) :
+  mBinCount(binCount), mMode(mode), mBegin(a)
+{
+  if (mode == kAtomic) {
+    shardCount = 1;
+  } else if (shardCount == 0) {
+    shardCount = defaultShardCount();
+  }
+  mShardCount = clampT(shardCount, 1U, kMaxShards);
+  mShardStride = (binCount + kCacheLineBins - 1) / kCacheLineBins * kCacheLineBins;
+  // new[] only aligns to the element (or 16 bytes), so allocate a line extra
+  // and start on a line boundary; otherwise padding the stride would not keep
+  // shards off each other's lines
+  mStorage = new std::atomic<int32_t>[mShardCount * mShardStride + kCacheLineBins - 1];
+  uintptr_t misalign = (uintptr_t)mStorage % kCacheLineBytes;
+  mBins = mStorage + ((misalign != 0) ? (kCacheLineBytes - misalign) / sizeof(int32_t) : 0);
+  // as Histogram::setRange, so a value lands in the same bin in both
+  mPerBinInv = 1.0f / ((b - a) / binCount);
+  clear();
+}
+
+ConcurrentHistogram::~ConcurrentHistogram()
+{
+  delete[] mStorage;
+}
+
+void ConcurrentHistogram::clear()
+{
+  uint32_t total = mShardCount * mShardStride;
+  for (uint32_t i=0; i<total; ++i) {
+    mBins[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+int32_t ConcurrentHistogram::getBinContents(uint32_t binNumber) const
+{
+  if (binNumber >= mBinCount) {
+    return 0;
+  }
+  int32_t total = 0;
+  for (uint32_t s=0; s<mShardCount; ++s) {
+    total += mBins[s * mShardStride + binNumber].load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+std::vector<int32_t> ConcurrentHistogram::snapshot() const
+{
+  std::vector<int32_t> totals(mBinCount, 0);
+  for (uint32_t s=0; s<mShardCount; ++s) {
+    const std::atomic<int32_t>* shard = mBins + s * mShardStride;
+    for (uint32_t i=0; i<mBinCount; ++i) {
+      totals[i] += shard[i].load(std::memory_order_relaxed);
+    }
+  }
+  return totals;
+}
+
+void ConcurrentHistogram::snapshot(Histogram& dst) const
+{
+  std::vector<int32_t> totals = snapshot();
+  uint32_t numBins = (dst.getBinCount() < mBinCount) ? dst.getBinCount() : mBinCount;
+  for (uint32_t i=0; i<numBins; ++i) {
+    dst.setBinContents(i, totals[i]);
+  }
+}
+
+}
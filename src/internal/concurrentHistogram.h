@@ -0,0 +1,88 @@
+#ifndef STEVESCH_MATHBASE_INTERNAL_CONCURRENTHISTOGRAM_H_
+#define STEVESCH_MATHBASE_INTERNAL_CONCURRENTHISTOGRAM_H_
+#include <atomic>
+#include <vector>
+#include "histogram.h"
+
+namespace stevesch {
+
+// Histogram that can be fed from several threads (or both ESP32 cores) at
+// once without a lock.  Bins follow the same rules as Histogram (values
+// outside [a, b) go to the first/last bin).
+//
+// Modes:
+// - kSharded: each thread adds into one of several copies ("shards") of the
+//   bins, chosen by thread (by core on ESP32), so threads rarely touch the
+//   same cache lines.  Reads merge the shards.
+// - kAtomic: a single set of bins updated with atomic increments; uses less
+//   memory and suits low-contention use.
+//
+// add() may be called concurrently from any number of threads.  Reads
+// (getBinContents, snapshot) may run concurrently with add() and see each
+// bin's count at some recent point; clear() should not race with add().
+class ConcurrentHistogram
+{
+public:
+  enum Mode {
+    kSharded,
+    kAtomic,
+  };
+
+  // shardCount == 0 selects one shard per hardware thread (kSharded only)
+  ConcurrentHistogram(float a, float b, uint32_t binCount, Mode mode=kSharded, uint32_t shardCount=0);
+  ~ConcurrentHistogram();
+
+  void clear();
+
+  uint32_t getBinNumber(float value) const
+  {
+    int n = (int)floorf((value - mBegin) * mPerBinInv);
+    int binMax = (int)mBinCount - 1;
+    n = clampT(n, 0, binMax);
+    return (uint32_t)n;
+  }
+
+  void add(float value, int32_t amount=1)
+  {
+    uint32_t n = getBinNumber(value);
+    mBins[shardIndex() * mShardStride + n].fetch_add(amount, std::memory_order_relaxed);
+  }
+
+  // total of a bin over all shards
+  int32_t getBinContents(uint32_t binNumber) const;
+
+  // merged bin totals.  Bins are copied by index and dst's range is not
+  // checked: dst must be a kClamp Histogram built with the same a, b and
+  // bin count for its bins to match (its other bins are left as they are).
+  void snapshot(Histogram& dst) const;
+  std::vector<int32_t> snapshot() const;
+
+  uint32_t getBinCount() const { return mBinCount; }
+  uint32_t getShardCount() const { return mShardCount; }
+  Mode getMode() const { return mMode; }
+
+private:
+  ConcurrentHistogram(const ConcurrentHistogram&);             // not copyable
+  ConcurrentHistogram& operator=(const ConcurrentHistogram&);
+
+  uint32_t shardIndex() const
+  {
+    return (mShardCount > 1) ? (currentThreadSlot() % mShardCount) : 0;
+  }
+
+  // small per-thread (per-core on ESP32) number used to pick a shard
+  static uint32_t currentThreadSlot();
+
+  std::atomic<int32_t>* mStorage;  // as allocated, with a cache line to spare
+  std::atomic<int32_t>* mBins;     // mStorage rounded up to a cache line
+  uint32_t mBinCount;
+  uint32_t mShardCount;
+  uint32_t mShardStride;  // bins per shard, padded to a whole number of cache lines
+  Mode mMode;
+  float mBegin;
+  float mPerBinInv;
+};
+
+}
+
+#endif
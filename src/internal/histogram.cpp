@@ -1,7 +1,58 @@
 #include "mathBase.h"
 #include "histogram.h"
 
+#include "simd.h"
 #include <Stream.h>
+#include <vector>
+
+namespace {
+  using namespace stevesch::simd;
+
+  // addBatch computes bin numbers this many at a time
+  const size_t c_blockSize = 256;
+  // partial histograms used by addBatch (when it has enough values to
+  // make summing them worthwhile)
+  const uint32_t c_partialCount = 4;
+
+  struct UnitAmount
+  {
+    int32_t operator[](size_t) const { return 1; }
+  };
+
+  // smallest and largest finite values of values[0..n); false if none is finite
+  bool batchRange(const float* values, size_t n, float& lo, float& hi)
+  {
+    const vfloat inf = set1(INFINITY);
+    vfloat vlo = inf;
+    vfloat vhi = -inf;
+    size_t i = 0;
+    for (; i + kWidth <= n; i += kWidth) {
+      // (compares rather than vmin/vmax, which differ in how they treat NaN)
+      vfloat x = load(values + i);
+      vfloat xlo = select(x > -inf, x, vlo);
+      vfloat xhi = select(x < inf, x, vhi);
+      vlo = select(xlo < vlo, xlo, vlo);
+      vhi = select(xhi > vhi, xhi, vhi);
+    }
+    float lanes[2][kWidth];
+    store(lanes[0], vlo);
+    store(lanes[1], vhi);
+    lo = INFINITY;
+    hi = -INFINITY;
+    for (int k=0; k<kWidth; ++k) {
+      lo = (lanes[0][k] < lo) ? lanes[0][k] : lo;
+      hi = (lanes[1][k] > hi) ? lanes[1][k] : hi;
+    }
+    for (; i<n; ++i) {
+      float x = values[i];
+      if (isfinite(x)) {
+        lo = (x < lo) ? x : lo;
+        hi = (x > hi) ? x : hi;
+      }
+    }
+    return lo <= hi;
+  }
+} // namespace
 
 namespace stevesch {
 
@@ -25,27 +76,179 @@ floatRange_t quantizationRange(int bin, float a, float b, int numDivisions)
   return floatRange_t(bina, binb);
 }
 
-Histogram::Histogram(float a, float b, uint32_t binCount) : mBinCount(binCount), mBegin(a), mEnd(b)
+Histogram::Histogram(float a, float b, uint32_t binCount, RangeMode mode) :
+  mBinCount(binCount), mRangeMode(mode)
 {
-  mBin = new int32_t[binCount]{0};
-  float perBin = (b - a) / binCount;
-  mPerBin = perBin;
-  mPerBinInv = 1.0f / perBin;
+  mStorage = new int32_t[binCount + 2]{0};
+  mBin = mStorage + 1;
+  mSlotMin = (mode == kClamp) ? 0 : -1;
+  mSlotMax = (mode == kClamp) ? (int)binCount - 1 : (int)binCount;
+  setRange(a, b);
 }
 
 Histogram::~Histogram()
 {
-  delete[] mBin;
+  delete[] mStorage;
 }
 
 void Histogram::clear()
 {
-  uint32_t numBins = mBinCount;
-  for (uint32_t i=0; i<numBins; ++i) {
-    mBin[i] = 0;
+  uint32_t numSlots = mBinCount + 2;
+  for (uint32_t i=0; i<numSlots; ++i) {
+    mStorage[i] = 0;
+  }
+}
+
+void Histogram::setRange(float a, float b)
+{
+  mBegin = a;
+  mEnd = b;
+  float perBin = (b - a) / mBinCount;
+  mPerBin = perBin;
+  mPerBinInv = 1.0f / perBin;
+}
+
+void Histogram::expandToInclude(float lo, float hi)
+{
+  const int binCount = (int)mBinCount;
+  // an empty (or reversed) range can't grow by doubling
+  if (binCount == 0 || !(mEnd > mBegin)) {
+    return;
+  }
+  // (the same test as getSlot, so that the value lands in a bin afterwards)
+  while (isfinite(hi) && floorf((hi - mBegin) * mPerBinInv) >= (float)binCount) {
+    float end = mBegin + 2.0f * (mEnd - mBegin);
+    if (!isfinite(end)) {
+      break;
+    }
+    // extend upward: bins 2j and 2j+1 become bin j
+    for (int j=0; j<binCount; ++j) {
+      int i = 2 * j;
+      int32_t sum = (i < binCount) ? mBin[i] : 0;
+      sum += (i + 1 < binCount) ? mBin[i + 1] : 0;
+      mBin[j] = sum;
+    }
+    setRange(mBegin, end);
+  }
+  while (isfinite(lo) && floorf((lo - mBegin) * mPerBinInv) < 0.0f) {
+    float begin = mEnd - 2.0f * (mEnd - mBegin);
+    if (!isfinite(begin)) {
+      break;
+    }
+    // extend downward: the old range is the upper half of the new one,
+    // so old bin i goes to new bin (binCount + i) / 2
+    for (int j=binCount - 1; j>=0; --j) {
+      int i = 2 * j - binCount;
+      int32_t sum = (i >= 0) ? mBin[i] : 0;
+      sum += (i + 1 >= 0 && i + 1 < binCount) ? mBin[i + 1] : 0;
+      mBin[j] = sum;
+    }
+    setRange(begin, mEnd);
   }
 }
 
+void Histogram::getBinNumbers(const float* values, uint32_t* bins, size_t n) const
+{
+  const vfloat begin = set1(mBegin);
+  const vfloat perBinInv = set1(mPerBinInv);
+  const vfloat zero = set1(0.0f);
+  const vfloat binMax = set1((float)(mBinCount - 1));
+  size_t i = 0;
+  for (; i + kWidth <= n; i += kWidth) {
+    // clamped to [0, binMax] before truncating, so truncation == floorf
+    vfloat x = (load(values + i) - begin) * perBinInv;
+    x = vmin(vmax(x, zero), binMax);
+    storeInt(bins + i, toInt(x));
+  }
+  for (; i<n; ++i) {
+    bins[i] = getBinNumber(values[i]);
+  }
+}
+
+void Histogram::getSlotIndices(const float* values, uint32_t* slots, size_t n) const
+{
+  // the same arithmetic as getSlot, so both put a value in the same bin
+  const vfloat begin = set1(mBegin);
+  const vfloat perBinInv = set1(mPerBinInv);
+  const vfloat slotMin = set1((float)mSlotMin);
+  const vfloat slotMax = set1((float)mSlotMax);
+  const vint one = set1Int(1);
+  size_t i = 0;
+  for (; i + kWidth <= n; i += kWidth) {
+    vfloat x = (load(values + i) - begin) * perBinInv;
+    // clamped before vfloor (which may only handle |x| < 2^31); for
+    // whole-number limits that gives the same as clamping afterwards.
+    // NaN fails the compare and goes to slotMin, as in getSlot
+    x = vmin(select(x > slotMin, x, slotMin), slotMax);
+    storeInt(slots + i, toInt(vfloor(x)) + one);
+  }
+  for (; i<n; ++i) {
+    slots[i] = (uint32_t)(getSlot(values[i]) + 1);
+  }
+}
+
+template <typename Amounts>
+void Histogram::countBatch(const float* values, const Amounts& amounts, size_t n)
+{
+  if (mRangeMode == kAutoRange) {
+    float lo, hi;
+    if (batchRange(values, n, lo, hi)) {
+      expandToInclude(lo, hi);
+    }
+  }
+
+  // indices into mStorage, i.e. bin + 1
+  const uint32_t slotCount = mBinCount + 2;
+  int32_t* slot = mStorage;
+  uint32_t slots[c_blockSize];
+
+  if (n < (size_t)c_partialCount * slotCount) {
+    for (size_t k=0; k<n; k+=c_blockSize) {
+      size_t count = (n - k < c_blockSize) ? (n - k) : c_blockSize;
+      getSlotIndices(values + k, slots, count);
+      for (size_t j=0; j<count; ++j) {
+        slot[slots[j]] += amounts[k + j];
+      }
+    }
+    return;
+  }
+
+  // consecutive values go to different partial histograms, so an
+  // increment never has to wait on the one just before it
+  std::vector<int32_t> partial((size_t)c_partialCount * slotCount, 0);
+  int32_t* p0 = partial.data();
+  int32_t* p1 = p0 + slotCount;
+  int32_t* p2 = p1 + slotCount;
+  int32_t* p3 = p2 + slotCount;
+  for (size_t k=0; k<n; k+=c_blockSize) {
+    size_t count = (n - k < c_blockSize) ? (n - k) : c_blockSize;
+    getSlotIndices(values + k, slots, count);
+    size_t j = 0;
+    for (; j + 4 <= count; j += 4) {
+      p0[slots[j + 0]] += amounts[k + j + 0];
+      p1[slots[j + 1]] += amounts[k + j + 1];
+      p2[slots[j + 2]] += amounts[k + j + 2];
+      p3[slots[j + 3]] += amounts[k + j + 3];
+    }
+    for (; j<count; ++j) {
+      p0[slots[j]] += amounts[k + j];
+    }
+  }
+  for (uint32_t i=0; i<slotCount; ++i) {
+    slot[i] += (p0[i] + p1[i]) + (p2[i] + p3[i]);
+  }
+}
+
+void Histogram::addBatch(const float* values, size_t n)
+{
+  countBatch(values, UnitAmount(), n);
+}
+
+void Histogram::addBatch(const float* values, const int32_t* amounts, size_t n)
+{
+  countBatch(values, amounts, n);
+}
+
 void Histogram::log(Stream& out, uint32_t height)
 {
   auto range = getRange();
@@ -87,6 +290,12 @@ void Histogram::log(Stream& out, uint32_t height)
   out.print(", ");
   out.print(mEnd);
   out.print("]");
+  if (mRangeMode != kClamp) {
+    out.print(" below: ");
+    out.print(getUnderflow());
+    out.print(" above: ");
+    out.print(getOverflow());
+  }
   out.println();
 }
 
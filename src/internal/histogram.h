@@ -1,5 +1,6 @@
 #ifndef STEVESCH_MATHBASE_INTERNAL_HISTOGRAM_H_
 #define STEVESCH_MATHBASE_INTERNAL_HISTOGRAM_H_
+#include <cstddef>
 #include <cstdint>
 #include <utility>
 #include <math.h>
@@ -25,12 +26,28 @@ int quantize(float x, float a, float b, int numDivisions);
 // interval for a particular bin.
 floatRange_t quantizationRange(int bin, float a, float b, int numDivisions);
 
+// Histogram of values in [a, b) divided into binCount equal bins.  What
+// happens to values outside [a, b) depends on the RangeMode:
+// - kClamp: they are counted in the first/last bin (as quantize()).
+// - kCount: they are counted separately (getUnderflow(), getOverflow()).
+// - kAutoRange: the range grows to include them.  Each step doubles the
+//   width of the bins, extending the range on the side of the value and
+//   adding neighbouring pairs of bins together, so it costs O(binCount)
+//   and needs nothing but the bins; memory stays fixed.  Infinities and
+//   NaN, which no range includes, go to the underflow/overflow counts.
+//   The range only grows if a < b.
 class Histogram
 {
 public:
   typedef std::pair<int32_t, int32_t> countRange_t;
 
-  Histogram(float a, float b, uint32_t binCount);
+  enum RangeMode {
+    kClamp,
+    kCount,
+    kAutoRange,
+  };
+
+  Histogram(float a, float b, uint32_t binCount, RangeMode mode=kClamp);
   ~Histogram();
 
   void clear();
@@ -48,11 +65,13 @@ public:
   }
 
   float getBinCenter(uint32_t binNumber) const {
-    // float a = mBegin;
-    // float b = mEnd;
-    // float perBin = (b - a) / mBinCount;
-    float binCenter = 0.5f * mPerBin*(binNumber + 1);
-    return binCenter;
+    return mBegin + mPerBin*((float)binNumber + 0.5f);
+  }
+
+  // [lower, upper) bounds of a bin in the current range
+  floatRange_t getBinRange(uint32_t binNumber) const {
+    float lower = mBegin + mPerBin*(float)binNumber;
+    return floatRange_t(lower, lower + mPerBin);
   }
 
   int32_t getBinContents(uint32_t binNumber) const {
@@ -62,13 +81,53 @@ public:
     return mBin[binNumber];
   }
 
+  void setBinContents(uint32_t binNumber, int32_t count) {
+    if (binNumber < mBinCount) {
+      mBin[binNumber] = count;
+    }
+  }
+
+  uint32_t getBinCount() const { return mBinCount; }
+  RangeMode getRangeMode() const { return mRangeMode; }
+  // current range (changes in kAutoRange mode)
+  float getBegin() const { return mBegin; }
+  float getEnd() const { return mEnd; }
+
+  // amounts added below/above the range (kCount and kAutoRange modes)
+  int32_t getUnderflow() const { return mBin[-1]; }
+  int32_t getOverflow() const { return mBin[mBinCount]; }
+
+  // returns the count of the bin (or underflow/overflow) value went to
   int32_t add(float value, int32_t amount=1) {
-    uint32_t n = getBinNumber(value);
+    int n = getSlot(value);
+    if (mRangeMode == kAutoRange && (n < 0 || n >= (int)mBinCount)) {
+      expandToInclude(value, value);
+      n = getSlot(value);
+    }
     uint32_t count = mBin[n] + amount;
     mBin[n] = count;
     return count;
   }
 
+  // Purpose: grow the range (by doubling bin widths, as kAutoRange mode
+  // does) until it includes [lo, hi].  Infinite or NaN bounds are ignored.
+  void expandToInclude(float lo, float hi);
+
+  // Purpose: add each of values[0..n) (as by add(values[i])).  Bin numbers are
+  // computed several at a time and large batches are counted into separate
+  // partial histograms that are summed at the end, so runs of equal bins don't
+  // serialize on one counter.
+  // In kAutoRange mode the range is first grown to include the batch's
+  // smallest and largest finite values, rather than value by value as add()
+  // grows it, so the final range can differ from adding the same values one
+  // at a time (each value is still counted in the bin of the final range).
+  void addBatch(const float* values, size_t n);
+  // weighted: as by add(values[i], amounts[i])
+  void addBatch(const float* values, const int32_t* amounts, size_t n);
+
+  // Purpose: bins[i] = getBinNumber(values[i]) for i in [0, n)
+  void getBinNumbers(const float* values, uint32_t* bins, size_t n) const;
+
   int32_t get(float value) const {
     uint32_t n = getBinNumber(value);
     return mBin[n];
@@ -96,12 +155,36 @@ public:
   void log(Stream& out, uint32_t height);
 
 protected:
-  int32_t* mBin;
+  // bin number, or -1/mBinCount (underflow/overflow) outside the range
+  // unless the mode is kClamp
+  int getSlot(float value) const
+  {
+    // clamped as float, so that infinities and NaN convert safely
+    float n = floorf((value - mBegin) * mPerBinInv);
+    n = (n > (float)mSlotMin) ? n : (float)mSlotMin;
+    n = (n < (float)mSlotMax) ? n : (float)mSlotMax;
+    return (int)n;
+  }
+
+  // getSlot(values[i]) + 1 for i in [0, n)
+  void getSlotIndices(const float* values, uint32_t* slots, size_t n) const;
+
+  template <typename Amounts>
+  void countBatch(const float* values, const Amounts& amounts, size_t n);
+
+  void setRange(float a, float b);
+
+  int32_t* mBin; // bins [0, mBinCount) of mStorage, with the underflow
+                 // count at mBin[-1] and overflow at mBin[mBinCount]
+  int32_t* mStorage;
   uint32_t mBinCount;
   float mBegin;
   float mEnd;
   float mPerBin; // == (mEnd - mBegin) / mBinCount
   float mPerBinInv; // == (float)mBinCount / (mEnd - mBegin)
+  int mSlotMin; // lowest/highest getSlot() result: 0 and mBinCount - 1 in
+  int mSlotMax; // kClamp mode, -1 and mBinCount otherwise
+  RangeMode mRangeMode;
 };
 
 }
@@ -0,0 +1,374 @@
+#ifndef STEVESCH_MATHBASE_INTERNAL_HISTOGRAMND_H_
+#define STEVESCH_MATHBASE_INTERNAL_HISTOGRAMND_H_
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "histogram.h"
+#include "simd.h"
+
+namespace stevesch {
+
+// D-dimensional histogram, e.g. the joint distribution of a stick's x and
+// y, or of a value and a time bucket.  Each axis d divides [a[d], b[d])
+// into binCount[d] bins with the rules of quantize() (values outside the
+// range go to the first/last bin of that axis), and
+// quantizationRange(bin, a[d], b[d], binCount[d]) is the range of a bin.
+//
+// Counts are kept in one contiguous array.  The position of a bin in it
+// is the sum of one small table lookup per axis, so the layout is just a
+// choice of tables:
+// - kRowMajor: axis 0 varies fastest, no padding.
+// - kMorton: the bits of the bin numbers are interleaved (Z-order), so
+//   bins that are close in every dimension are close in memory, which
+//   suits correlated data (e.g. a slowly moving stick).  Each axis is
+//   padded to a power of two bins.
+//
+// rangeSum() counts any box of bins in O(2^D) from a summed-area table,
+// which is rebuilt (O(bins)) on the first query after the counts change.
+template <int D>
+class HistogramND
+{
+public:
+  static_assert(D >= 1, "HistogramND needs at least one dimension");
+
+  enum Layout {
+    kRowMajor,
+    kMorton,
+  };
+
+  HistogramND(const float (&a)[D], const float (&b)[D], const uint32_t (&binCount)[D],
+    Layout layout=kRowMajor);
+
+  void clear();
+
+  Layout getLayout() const { return mLayout; }
+  uint32_t getBinCount(int axis) const { return mBinCount[axis]; }
+  // number of bins over all axes (product of getBinCount)
+  size_t getTotalBinCount() const { return mTotalBinCount; }
+  // bytes used by counts, layout tables and the summed-area table
+  size_t memoryBytes() const;
+
+  // as quantize(value, a[axis], b[axis], binCount[axis])
+  uint32_t getBinNumber(int axis, float value) const
+  {
+    int n = (int)floorf((value - mBegin[axis]) * mPerBinInv[axis]);
+    int binMax = (int)mBinCount[axis] - 1;
+    n = clampT(n, 0, binMax);
+    return (uint32_t)n;
+  }
+
+  floatRange_t getBinRange(int axis, uint32_t binNumber) const
+  {
+    return quantizationRange((int)binNumber, mBegin[axis], mEnd[axis], (int)mBinCount[axis]);
+  }
+
+  int32_t getBinContents(const uint32_t (&bin)[D]) const { return mBin[storageIndex(bin)]; }
+  void setBinContents(const uint32_t (&bin)[D], int32_t count)
+  {
+    mBin[storageIndex(bin)] = count;
+    mbSummedAreaValid = false;
+  }
+
+  int32_t add(const float (&value)[D], int32_t amount=1)
+  {
+    uint32_t index = 0;
+    for (int d=0; d<D; ++d) {
+      index += mOffset[d][getBinNumber(d, value[d])];
+    }
+    mbSummedAreaValid = false;
+    return (mBin[index] += amount);
+  }
+
+  // Purpose: add n points given one array per axis, i.e. point i is
+  // (axes[0][i], axes[1][i], ...).  Bin numbers are computed several at a
+  // time.
+  void addBatch(const float* const (&axes)[D], size_t n);
+
+  // Purpose: counts summed over every axis but 'axis' (binCount[axis]
+  // values)
+  std::vector<int32_t> marginal(int axis) const;
+  // the same into a 1D Histogram; dst keeps its own range, and gets the
+  // first min(dst bins, binCount[axis]) counts
+  void marginal(int axis, Histogram& dst) const;
+
+  // Purpose: total count of bins lo[d] <= bin[d] <= hi[d] on every axis
+  // (inclusive; empty if any lo[d] > hi[d]).  Not thread safe: the first
+  // query after a change rebuilds the summed-area table.
+  int64_t rangeSum(const uint32_t (&lo)[D], const uint32_t (&hi)[D]) const;
+  // the bins containing lo .. hi (as getBinNumber)
+  int64_t rangeSum(const float (&lo)[D], const float (&hi)[D]) const;
+
+private:
+  uint32_t storageIndex(const uint32_t (&bin)[D]) const
+  {
+    uint32_t index = 0;
+    for (int d=0; d<D; ++d) {
+      index += mOffset[d][bin[d]];
+    }
+    return index;
+  }
+
+  // f(row, base, bin) for each row of bins along axis 0, in row-major
+  // order: row is the row-major index of its first bin, base the sum of
+  // the offsets of axes 1..D-1 and bin[1..D-1] their bin numbers
+  template <typename F>
+  void forEachRow(F f) const;
+
+  void updateSummedArea() const;
+
+  std::vector<int32_t> mBin;
+  std::vector<uint32_t> mOffset[D]; // position in mBin of each bin of an axis
+  uint32_t mBinCount[D];
+  uint32_t mStride[D];              // row-major strides of mSummedArea
+  size_t mTotalBinCount;
+  float mBegin[D];
+  float mEnd[D];
+  float mPerBinInv[D];
+  Layout mLayout;
+
+  // inclusive prefix sums in row-major order; built by the first rangeSum
+  mutable std::vector<int64_t> mSummedArea;
+  mutable bool mbSummedAreaValid;
+};
+
+template <int D>
+HistogramND<D>::HistogramND(const float (&a)[D], const float (&b)[D], const uint32_t (&binCount)[D],
+  Layout layout) : mLayout(layout), mbSummedAreaValid(false)
+{
+  size_t total = 1;
+  for (int d=0; d<D; ++d) {
+    mBinCount[d] = (binCount[d] > 0) ? binCount[d] : 1;
+    mBegin[d] = a[d];
+    mEnd[d] = b[d];
+    mPerBinInv[d] = (float)mBinCount[d] / (b[d] - a[d]);
+    mStride[d] = (uint32_t)total;
+    total *= mBinCount[d];
+    mOffset[d].resize(mBinCount[d]);
+  }
+  mTotalBinCount = total;
+
+  if (layout == kRowMajor) {
+    for (int d=0; d<D; ++d) {
+      for (uint32_t i=0; i<mBinCount[d]; ++i) {
+        mOffset[d][i] = i * mStride[d];
+      }
+    }
+    mBin.assign(total, 0);
+    return;
+  }
+
+  // Morton: bit l of axis d's bin number goes to the next free position,
+  // level by level; axes with fewer bits drop out of the higher levels
+  int bits[D];
+  int maxBits = 0;
+  for (int d=0; d<D; ++d) {
+    bits[d] = 0;
+    while ((1U << bits[d]) < mBinCount[d]) {
+      ++bits[d];
+    }
+    maxBits = (bits[d] > maxBits) ? bits[d] : maxBits;
+  }
+  uint32_t position = 0;
+  for (int l=0; l<maxBits; ++l) {
+    for (int d=0; d<D; ++d) {
+      if (l < bits[d]) {
+        for (uint32_t i=0; i<mBinCount[d]; ++i) {
+          mOffset[d][i] |= ((i >> l) & 1U) << position;
+        }
+        ++position;
+      }
+    }
+  }
+  mBin.assign((size_t)1 << position, 0);
+}
+
+template <int D>
+void HistogramND<D>::clear()
+{
+  mBin.assign(mBin.size(), 0);
+  mbSummedAreaValid = false;
+}
+
+template <int D>
+size_t HistogramND<D>::memoryBytes() const
+{
+  size_t bytes = mBin.capacity() * sizeof(int32_t) + mSummedArea.capacity() * sizeof(int64_t);
+  for (int d=0; d<D; ++d) {
+    bytes += mOffset[d].capacity() * sizeof(uint32_t);
+  }
+  return bytes;
+}
+
+template <int D>
+void HistogramND<D>::addBatch(const float* const (&axes)[D], size_t n)
+{
+  using namespace simd;
+  const size_t kBlock = 256;
+  uint32_t bins[kBlock];
+  uint32_t index[kBlock];
+  for (size_t k=0; k<n; k+=kBlock) {
+    size_t count = (n - k < kBlock) ? (n - k) : kBlock;
+    for (size_t j=0; j<count; ++j) {
+      index[j] = 0;
+    }
+    for (int d=0; d<D; ++d) {
+      // as Histogram::getBinNumbers
+      const float* values = axes[d] + k;
+      const vfloat begin = set1(mBegin[d]);
+      const vfloat perBinInv = set1(mPerBinInv[d]);
+      const vfloat zero = set1(0.0f);
+      const vfloat binMax = set1((float)(mBinCount[d] - 1));
+      size_t j = 0;
+      for (; j + kWidth <= count; j += kWidth) {
+        vfloat x = (load(values + j) - begin) * perBinInv;
+        x = vmin(vmax(x, zero), binMax);
+        storeInt(bins + j, toInt(x));
+      }
+      for (; j<count; ++j) {
+        bins[j] = getBinNumber(d, values[j]);
+      }
+      const uint32_t* offset = mOffset[d].data();
+      for (j=0; j<count; ++j) {
+        index[j] += offset[bins[j]];
+      }
+    }
+    int32_t* bin = mBin.data();
+    for (size_t j=0; j<count; ++j) {
+      ++bin[index[j]];
+    }
+  }
+  mbSummedAreaValid = false;
+}
+
+template <int D>
+template <typename F>
+void HistogramND<D>::forEachRow(F f) const
+{
+  // odometer over the bin numbers of axes 1..D-1
+  uint32_t bin[D] = {};
+  const uint32_t rowCount = (uint32_t)(mTotalBinCount / mBinCount[0]);
+  for (uint32_t row=0; row<rowCount; ++row) {
+    uint32_t base = 0;
+    for (int d=1; d<D; ++d) {
+      base += mOffset[d][bin[d]];
+    }
+    f((size_t)row * mBinCount[0], base, bin);
+    for (int d=1; d<D && ++bin[d] == mBinCount[d]; ++d) {
+      bin[d] = 0;
+    }
+  }
+}
+
+template <int D>
+std::vector<int32_t> HistogramND<D>::marginal(int axis) const
+{
+  std::vector<int32_t> result(mBinCount[axis], 0);
+  const int32_t* counts = mBin.data();
+  const uint32_t* offset0 = mOffset[0].data();
+  const uint32_t binCount0 = mBinCount[0];
+  int32_t* total = result.data();
+  forEachRow([&](size_t, uint32_t base, const uint32_t* bin) {
+    if (axis == 0) {
+      for (uint32_t i=0; i<binCount0; ++i) {
+        total[i] += counts[base + offset0[i]];
+      }
+    } else {
+      int32_t sum = 0;
+      for (uint32_t i=0; i<binCount0; ++i) {
+        sum += counts[base + offset0[i]];
+      }
+      total[bin[axis]] += sum;
+    }
+  });
+  return result;
+}
+
+template <int D>
+void HistogramND<D>::marginal(int axis, Histogram& dst) const
+{
+  std::vector<int32_t> totals = marginal(axis);
+  uint32_t numBins = (dst.getBinCount() < mBinCount[axis]) ? dst.getBinCount() : mBinCount[axis];
+  for (uint32_t i=0; i<numBins; ++i) {
+    dst.setBinContents(i, totals[i]);
+  }
+}
+
+template <int D>
+void HistogramND<D>::updateSummedArea() const
+{
+  mSummedArea.resize(mTotalBinCount);
+  int64_t* sum = mSummedArea.data();
+  const int32_t* counts = mBin.data();
+  const uint32_t* offset0 = mOffset[0].data();
+  const uint32_t binCount0 = mBinCount[0];
+  forEachRow([&](size_t row, uint32_t base, const uint32_t*) {
+    for (uint32_t i=0; i<binCount0; ++i) {
+      sum[row + i] = counts[base + offset0[i]];
+    }
+  });
+
+  // a running sum along each axis in turn
+  for (int d=0; d<D; ++d) {
+    size_t stride = mStride[d];
+    size_t span = stride * mBinCount[d];
+    for (size_t first=0; first<mTotalBinCount; first+=span) {
+      for (size_t i=first + stride; i<first + span; ++i) {
+        sum[i] += sum[i - stride];
+      }
+    }
+  }
+  mbSummedAreaValid = true;
+}
+
+template <int D>
+int64_t HistogramND<D>::rangeSum(const uint32_t (&lo)[D], const uint32_t (&hi)[D]) const
+{
+  uint32_t top[D];
+  for (int d=0; d<D; ++d) {
+    top[d] = (hi[d] < mBinCount[d]) ? hi[d] : (mBinCount[d] - 1);
+    if (lo[d] > top[d]) {
+      return 0;
+    }
+  }
+  if (!mbSummedAreaValid) {
+    updateSummedArea();
+  }
+
+  // inclusion-exclusion over the 2^D corners: for each axis either the
+  // top bin or the one below lo (which contributes nothing if lo == 0)
+  int64_t sum = 0;
+  for (uint32_t corner=0; corner<(1U << D); ++corner) {
+    size_t index = 0;
+    bool bNegative = false;
+    bool bInside = true;
+    for (int d=0; d<D; ++d) {
+      uint32_t coordinate = top[d];
+      if (corner & (1U << d)) {
+        bInside = bInside && (lo[d] > 0);
+        coordinate = lo[d] - 1;
+        bNegative = !bNegative;
+      }
+      index += (size_t)coordinate * mStride[d];
+    }
+    if (bInside) {
+      sum += bNegative ? -mSummedArea[index] : mSummedArea[index];
+    }
+  }
+  return sum;
+}
+
+template <int D>
+int64_t HistogramND<D>::rangeSum(const float (&lo)[D], const float (&hi)[D]) const
+{
+  uint32_t binLo[D];
+  uint32_t binHi[D];
+  for (int d=0; d<D; ++d) {
+    binLo[d] = getBinNumber(d, lo[d]);
+    binHi[d] = getBinNumber(d, hi[d]);
+  }
+  return rangeSum(binLo, binHi);
+}
+
+}
+
+#endif
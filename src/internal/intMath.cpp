@@ -1,4 +1,5 @@
 #include "intMath.h"
+#include <atomic>
 
 namespace stevesch
 {
@@ -7,15 +8,65 @@ namespace stevesch
   // std::uniform_int_distribution<uint8_t> distu8(0, 255);
   // std::uniform_int_distribution<uint32_t> distu32(0, 4294967295);
 
-	RandGen::RandGen() : mGenerator(micros())
+	RandGen S_RandGen(micros());
+
+	namespace
 	{
+		std::atomic<uint32_t> s_masterSeed((uint32_t)micros());
+		std::atomic<uint32_t> s_seedGeneration(0);	// bumped by setThreadRandSeed
+		std::atomic<uint32_t> s_nextStreamId(0);
+
+		struct ThreadRandState
+		{
+			RandGen mGen;
+			uint32_t mStreamId;
+			uint32_t mGeneration;
+
+			ThreadRandState() : mGen(0U), mStreamId(s_nextStreamId.fetch_add(1, std::memory_order_relaxed))
+			{
+				reseed();
+			}
+
+			void reseed()
+			{
+				mGeneration = s_seedGeneration.load(std::memory_order_acquire);
+				mGen.setSeed(s_masterSeed.load(std::memory_order_relaxed), mStreamId);
+			}
+		};
+
+		ThreadRandState& threadRandState()
+		{
+			static thread_local ThreadRandState state;
+			return state;
+		}
 	}
 
-	void RandGen::setSeed( uint32_t nSeed )
+	RandGen& threadRandGen()
 	{
-    mGenerator = std::default_random_engine(nSeed);
+		ThreadRandState& state = threadRandState();
+		if (state.mGeneration != s_seedGeneration.load(std::memory_order_relaxed))
+		{
+			state.reseed();
+		}
+		return state.mGen;
 	}
 
-	RandGen S_RandGen(micros());
+	void setThreadStreamId(uint32_t nStream)
+	{
+		ThreadRandState& state = threadRandState();
+		state.mStreamId = nStream;
+		state.reseed();
+	}
+
+	uint32_t getThreadStreamId()
+	{
+		return threadRandState().mStreamId;
+	}
+
+	void setThreadRandSeed(uint32_t nMasterSeed)
+	{
+		s_masterSeed.store(nMasterSeed, std::memory_order_relaxed);
+		s_seedGeneration.fetch_add(1, std::memory_order_release);
+	}
 
 }	// namespace S
@@ -2,7 +2,7 @@
 #define STEVESCH_MATHBASE_INTERNAL_INTMATH_H_
 
 #include "mathBase.h"
-#include <random>
+#include "randEngine.h"
 
 namespace
 {
@@ -90,65 +90,142 @@ namespace stevesch
   // random integer numbers
 
   // pseudo-random number generator class
-  class RandGen
+  //
+  // Engine is one of the engines in randEngine.h (or any type with
+  // seed(uint32_t) and a uint32_t operator()()).  RandGen below is the
+  // generator used throughout the library.
+  template <typename Engine>
+  class TRandGen
   {
   private:
-    std::default_random_engine mGenerator;
+    Engine mGenerator;
 
   public:
-    RandGen();
-    RandGen(uint32_t nSeed) : mGenerator(nSeed) {}
-    RandGen(uint16_t s1, uint16_t s2) // 2D seed (16 bits each guaranteed)
+    typedef Engine engine_type;
+
+    TRandGen() { setSeed((uint32_t)micros()); }
+    TRandGen(uint32_t nSeed) { setSeed(nSeed); }
+    TRandGen(uint16_t s1, uint16_t s2) // 2D seed (16 bits each guaranteed)
     {
       set2DSeed(s1, s2);
     }
 
-    void setSeed(uint32_t nSeed);
-    void set2DSeed(uint16_t s1, uint16_t s2); // 2D seed (16 bits each guaranteed)
+    void setSeed(uint32_t nSeed) { mGenerator.seed(nSeed); }
+    // stream 'nStream' of seed 'nSeed' (see randEngine.h); different streams
+    // of one seed give independent sequences
+    void setSeed(uint32_t nSeed, uint32_t nStream) { mGenerator.seed(nSeed, nStream); }
+    void set2DSeed(uint16_t s1, uint16_t s2) // 2D seed (16 bits each guaranteed)
+    {
+      setSeed(((uint32_t)s1 << 16) | s2);
+    }
+
+    Engine& engine() { return mGenerator; }
 
     inline uint32_t getU()
     {
-      std::uniform_int_distribution<uint32_t> distribution(0, 4294967295);
-      uint32_t value = distribution(mGenerator);
-      return value;
+      return mGenerator();
     }
 
-    // return a random integer between 0..n-1. the distribution will get worse as n approaches 2^32.
+    // return a random integer between 0..n-1 (exactly uniform).
+    // Lemire's multiply-and-shift; the rejection step that removes the bias
+    // is rarely taken and only then needs a division.
     inline int getInt(int nRange)
     {
-      std::uniform_int_distribution<uint32_t> distribution(0, nRange - 1);
-      uint32_t value = distribution(mGenerator);
-      return value;
+      const uint32_t range = (uint32_t)nRange;
+      uint64_t m = (uint64_t)getU() * range;
+      uint32_t low = (uint32_t)m;
+      if (low < range) {
+        const uint32_t threshold = (0U - range) % range;
+        while (low < threshold) {
+          m = (uint64_t)getU() * range;
+          low = (uint32_t)m;
+        }
+      }
+      return (int)(m >> 32);
     }
 
+    // [0.0, 1.0): top 24 bits, one float ulp apart
     inline float getFloat()
     {
-      std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
-      float value = distribution(mGenerator);
-      return value;
+      return randBitsToFloat(getU());
     }
 
     inline float getFloatAB(float a, float b)
     {
-      std::uniform_real_distribution<float> distribution(a, b);
-      float value = distribution(mGenerator);
-      return value;
+      return a + (b - a) * getFloat();
     }
+
+    // fill out[0..n) with random values (as getU, getFloat, getFloatAB).
+    // For large n the xoshiro engines generate several streams at once (see
+    // RandFill in randEngine.h), so the values are not the same as those of
+    // n single calls.
+    void fillU32(uint32_t* out, size_t n) { RandFill<Engine>::fillU32(mGenerator, out, n); }
+    void fillFloat(float* out, size_t n) { RandFill<Engine>::fillFloat(mGenerator, out, n, 0.0f, 1.0f); }
+    void fillFloatAB(float* out, size_t n, float a, float b) { RandFill<Engine>::fillFloat(mGenerator, out, n, a, b); }
   };
 
+  // Engine used by RandGen (StdRandEngine<std::default_random_engine> gives
+  // the old sequences).  This is a build-wide setting: define it for the
+  // library and everything that includes it, e.g.
+  //   build_flags = -DSTEVESCH_MATHBASE_RANDGEN_ENGINE=Xoshiro128Plus
+  // in platformio.ini, or -DMATHBASE_RANDGEN_ENGINE=Xoshiro128Plus with the
+  // host CMake build.  Do not #define it before including the library in one
+  // file: RandGen would then be a different type there than S_RandGen is in
+  // intMath.cpp.  For another engine in one place, use TRandGen<Engine>.
+#ifndef STEVESCH_MATHBASE_RANDGEN_ENGINE
+#define STEVESCH_MATHBASE_RANDGEN_ENGINE Xoshiro128StarStar
+#endif
+
+  typedef TRandGen<STEVESCH_MATHBASE_RANDGEN_ENGINE> RandGen;
+
   ////////////////////////////////////////////////////////////////////////
 
   extern RandGen S_RandGen;
 
-  // return next 32 bit random number. this uses a not-very-random linear
-  // congruential method.
-  inline uint32_t SRandU() { return S_RandGen.getU(); }
+  // Per-thread generators.  Each thread's generator is stream
+  // getThreadStreamId() of the master seed, so a run that seeds with
+  // setThreadRandSeed() and gives its threads fixed stream ids produces the
+  // same numbers on every thread every time, and no generator is shared.
+  //
+  // Threads that don't call setThreadStreamId() get ids in the order they
+  // first use threadRandGen() (0, 1, 2, ...).  Seeding stream k costs one
+  // xoshiro jump (128 steps) per set bit of k, so at most 32 however many
+  // threads have started.
+  RandGen& threadRandGen();
+  void setThreadStreamId(uint32_t nStream);
+  uint32_t getThreadStreamId();
+  // reseeds every thread's generator (each on its next use)
+  void setThreadRandSeed(uint32_t nMasterSeed);
+
+  // Generator used by SRandU, SRandInt, randf, randfAB, statisticalRoundftoi
+  // and as the default RandGen argument (e.g. ProbabilityTable::getRandom):
+  // S_RandGen, or the calling thread's threadRandGen() when the library and
+  // everything using it are built with STEVESCH_MATHBASE_THREAD_RANDGEN
+  // defined (S_RandGen is not safe to use from several threads at once).
+  inline RandGen& defaultRandGen()
+  {
+#if defined(STEVESCH_MATHBASE_THREAD_RANDGEN)
+    return threadRandGen();
+#else
+    return S_RandGen;
+#endif
+  }
+
+  // return next 32 bit random number.
+  inline uint32_t SRandU() { return defaultRandGen().getU(); }
 
-  // set the current random number seed
-  inline void SRandSetSeed(uint32_t n) { S_RandGen.setSeed(n); }
+  // set the current random number seed (the master seed for per-thread generators)
+  inline void SRandSetSeed(uint32_t n)
+  {
+#if defined(STEVESCH_MATHBASE_THREAD_RANDGEN)
+    setThreadRandSeed(n);
+#else
+    S_RandGen.setSeed(n);
+#endif
+  }
 
   // return a random integer between 0..n-1.
-  inline int SRandInt(int n) { return S_RandGen.getInt(n); }
+  inline int SRandInt(int n) { return defaultRandGen().getInt(n); }
 
   //////////////////////////////////////////////////////////////////////
 
@@ -0,0 +1,165 @@
+#include "mathBase.h"
+#include "logHistogram.h"
+
+namespace {
+  using namespace stevesch::simd;
+
+  // addBatch computes bin numbers this many at a time
+  const size_t c_blockSize = 256;
+
+  // mantissa bits kept per significant digit: 2^k >= 10^digits
+  const uint32_t c_mantissaBits[] = { 4, 7, 10, 14, 17 };
+
+  // getBinNumber kWidth at a time; the shift has to be a constant
+  template <uint32_t kShift>
+  size_t binNumbersShifted(const float* values, uint32_t* bins, size_t n,
+    float lowest, float highest, uint32_t base)
+  {
+    const vfloat lo = set1(lowest);
+    const vfloat hi = set1(highest);
+    const vint b = set1Int((int32_t)base);
+    size_t i = 0;
+    for (; i + kWidth <= n; i += kWidth) {
+      vfloat x = load(values + i);
+      x = vmin(select(x > lo, x, lo), hi);
+      storeInt(bins + i, shiftRight<kShift>(asInt(x)) - b);
+    }
+    return i;
+  }
+} // namespace
+
+namespace stevesch {
+
+LogHistogram::LogHistogram(float lowest, float highest, int significantDigits) :
+  mTotalCount(0), mLowest(lowest), mHighest(highest), mMin(0.0f), mMax(0.0f)
+{
+  mSignificantDigits = clampT(significantDigits, 1, 5);
+  mShift = 23 - c_mantissaBits[mSignificantDigits - 1];
+  mBase = simd::floatBits(lowest) >> mShift;
+  uint32_t top = simd::floatBits(highest) >> mShift;
+  mBin.assign((top > mBase) ? (top - mBase + 1) : 1, 0);
+}
+
+void LogHistogram::clear()
+{
+  mBin.assign(mBin.size(), 0);
+  mTotalCount = 0;
+  mMin = 0.0f;
+  mMax = 0.0f;
+}
+
+uint32_t LogHistogram::binsPerDecade(int significantDigits)
+{
+  uint32_t bits = c_mantissaBits[clampT(significantDigits, 1, 5) - 1];
+  return (uint32_t)(3.321928f * (float)(1U << bits) + 0.5f);
+}
+
+void LogHistogram::getBinNumbers(const float* values, uint32_t* bins, size_t n) const
+{
+  size_t i = 0;
+  switch (mShift) {
+    case 19: i = binNumbersShifted<19>(values, bins, n, mLowest, mHighest, mBase); break;
+    case 16: i = binNumbersShifted<16>(values, bins, n, mLowest, mHighest, mBase); break;
+    case 13: i = binNumbersShifted<13>(values, bins, n, mLowest, mHighest, mBase); break;
+    case 9: i = binNumbersShifted<9>(values, bins, n, mLowest, mHighest, mBase); break;
+    case 6: i = binNumbersShifted<6>(values, bins, n, mLowest, mHighest, mBase); break;
+    default: break;
+  }
+  for (; i<n; ++i) {
+    bins[i] = getBinNumber(values[i]);
+  }
+}
+
+void LogHistogram::addBatch(const float* values, size_t n)
+{
+  if (n == 0) {
+    return;
+  }
+  uint32_t bins[c_blockSize];
+  uint32_t* bin = mBin.data();
+  vfloat lo = set1((mTotalCount == 0) ? values[0] : mMin);
+  vfloat hi = set1((mTotalCount == 0) ? values[0] : mMax);
+  float scalarLo = (mTotalCount == 0) ? values[0] : mMin;
+  float scalarHi = (mTotalCount == 0) ? values[0] : mMax;
+  for (size_t k=0; k<n; k+=c_blockSize) {
+    size_t count = (n - k < c_blockSize) ? (n - k) : c_blockSize;
+    getBinNumbers(values + k, bins, count);
+    for (size_t j=0; j<count; ++j) {
+      ++bin[bins[j]];
+    }
+
+    // (compares rather than vmin/vmax, which differ in how they treat NaN)
+    size_t j = 0;
+    for (; j + kWidth <= count; j += kWidth) {
+      vfloat x = load(values + k + j);
+      lo = select(x < lo, x, lo);
+      hi = select(x > hi, x, hi);
+    }
+    for (; j<count; ++j) {
+      float x = values[k + j];
+      scalarLo = (x < scalarLo) ? x : scalarLo;
+      scalarHi = (x > scalarHi) ? x : scalarHi;
+    }
+  }
+
+  float lanes[2][kWidth];
+  store(lanes[0], lo);
+  store(lanes[1], hi);
+  for (int i=0; i<kWidth; ++i) {
+    scalarLo = (lanes[0][i] < scalarLo) ? lanes[0][i] : scalarLo;
+    scalarHi = (lanes[1][i] > scalarHi) ? lanes[1][i] : scalarHi;
+  }
+  mMin = scalarLo;
+  mMax = scalarHi;
+  mTotalCount += n;
+}
+
+void LogHistogram::merge(const LogHistogram& other)
+{
+  if (other.mTotalCount == 0) {
+    return;
+  }
+  float otherMin = other.mMin;
+  float otherMax = other.mMax;
+  uint64_t otherCount = other.mTotalCount;
+  if (other.mBase == mBase && other.mShift == mShift && other.mBin.size() == mBin.size()) {
+    for (size_t i=0; i<mBin.size(); ++i) {
+      mBin[i] += other.mBin[i];
+    }
+  } else {
+    for (uint32_t i=0; i<other.getBinCount(); ++i) {
+      if (other.mBin[i] != 0) {
+        floatRange_t range = other.getBinRange(i);
+        mBin[getBinNumber(0.5f * (range.first + range.second))] += other.mBin[i];
+      }
+    }
+  }
+  mMin = (mTotalCount == 0 || otherMin < mMin) ? otherMin : mMin;
+  mMax = (mTotalCount == 0 || otherMax > mMax) ? otherMax : mMax;
+  mTotalCount += otherCount;
+}
+
+float LogHistogram::getValueAtPercentile(float percentile) const
+{
+  if (mTotalCount == 0) {
+    return 0.0f;
+  }
+  // the smallest count that covers 'percentile' percent of the values
+  double fraction = (double)clampT(percentile, 0.0f, 100.0f) * 0.01;
+  uint64_t target = (uint64_t)ceil(fraction * (double)mTotalCount);
+  target = (target > 0) ? target : 1;
+
+  uint64_t seen = 0;
+  float value = mMax;
+  for (uint32_t i=0; i<getBinCount(); ++i) {
+    seen += mBin[i];
+    if (seen >= target) {
+      value = getBinRange(i).second;
+      break;
+    }
+  }
+  value = (value < mMax) ? value : mMax;
+  return (value > mMin) ? value : mMin;
+}
+
+}
@@ -0,0 +1,106 @@
+#ifndef STEVESCH_MATHBASE_INTERNAL_LOGHISTOGRAM_H_
+#define STEVESCH_MATHBASE_INTERNAL_LOGHISTOGRAM_H_
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "histogram.h"
+#include "simd.h"
+
+namespace stevesch {
+
+// Histogram with logarithmically spaced bins (as HdrHistogram), for values
+// that span many orders of magnitude, e.g. latencies from 1 us to 10 s.
+//
+// Each power of two in [lowest, highest] is split into 2^k equal bins,
+// with 2^k >= 10^significantDigits, so a bin is never wider than
+// 10^-significantDigits of the values in it.  The bin of a value is the
+// float's exponent and top k mantissa bits: a shift and a subtract, no
+// log().  Memory per decade of range (4-byte counts):
+//
+//   significantDigits   bins/decade   bytes/decade
+//           1                53            213
+//           2               425           1.7K
+//           3              3402          13.6K
+//
+// Values <= lowest (including zero and negative values) go to the first
+// bin and values >= highest to the last, as Histogram does at its ends.
+class LogHistogram
+{
+public:
+  // lowest > 0; significantDigits in [1, 5]
+  LogHistogram(float lowest, float highest, int significantDigits=2);
+
+  void clear();
+
+  uint32_t getBinNumber(float value) const
+  {
+    // written so that NaN goes to the first bin
+    float v = (value > mLowest) ? value : mLowest;
+    v = (v < mHighest) ? v : mHighest;
+    return (simd::floatBits(v) >> mShift) - mBase;
+  }
+
+  // [lower, upper) bounds of the values counted in a bin
+  floatRange_t getBinRange(uint32_t binNumber) const
+  {
+    return floatRange_t(simd::bitsFloat((binNumber + mBase) << mShift),
+      simd::bitsFloat((binNumber + mBase + 1) << mShift));
+  }
+
+  uint32_t getBinContents(uint32_t binNumber) const {
+    return (binNumber < mBin.size()) ? mBin[binNumber] : 0;
+  }
+
+  uint32_t getBinCount() const { return (uint32_t)mBin.size(); }
+  int getSignificantDigits() const { return mSignificantDigits; }
+  uint64_t getTotalCount() const { return mTotalCount; }
+  // smallest and largest values added (not clamped to [lowest, highest])
+  float getMin() const { return mMin; }
+  float getMax() const { return mMax; }
+  // bytes used by the bins
+  size_t memoryBytes() const { return mBin.capacity() * sizeof(uint32_t); }
+
+  void add(float value, uint32_t amount=1)
+  {
+    mBin[getBinNumber(value)] += amount;
+    mMin = (mTotalCount == 0 || value < mMin) ? value : mMin;
+    mMax = (mTotalCount == 0 || value > mMax) ? value : mMax;
+    mTotalCount += amount;
+  }
+
+  // Purpose: add each of values[0..n) (as by add(values[i])), computing
+  // bin numbers several at a time
+  void addBatch(const float* values, size_t n);
+
+  // Purpose: bins[i] = getBinNumber(values[i]) for i in [0, n)
+  void getBinNumbers(const float* values, uint32_t* bins, size_t n) const;
+
+  // Purpose: add all counts of another histogram.  Bin by bin if both have
+  // the same range and digits; otherwise each of other's bins is added at
+  // the middle of its range.
+  void merge(const LogHistogram& other);
+
+  // Purpose: the value that 'percentile' percent (0..100) of the values
+  // added are less than or equal to, within the resolution of a bin: the
+  // upper bound of the bin where that count is reached, limited to
+  // [getMin(), getMax()].  0 if the histogram is empty.
+  float getValueAtPercentile(float percentile) const;
+
+  // bins per decade of range for a number of significant digits
+  static uint32_t binsPerDecade(int significantDigits);
+
+private:
+  std::vector<uint32_t> mBin;
+  uint64_t mTotalCount;
+  float mLowest;
+  float mHighest;
+  float mMin;
+  float mMax;
+  uint32_t mShift;  // 23 - mantissa bits kept
+  uint32_t mBase;   // floatBits(mLowest) >> mShift
+  int mSignificantDigits;
+};
+
+}
+
+#endif
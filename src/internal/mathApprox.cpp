@@ -0,0 +1,125 @@
+#include "mathApprox.h"
+#include "polyApprox.h"
+#include "simd.h"
+
+using namespace stevesch::simd;
+
+namespace {
+  // simd::mod2pi is exact for |x| below about 4.1e5; lanes beyond this are
+  // taken from the single-value version, which reduces with fmodf
+  const float c_maxVectorReduce = 4.0e5f;
+
+  template <typename F>
+  inline vfloat withLargeLanes(vfloat x, vfloat r, F scalar)
+  {
+    if (bits(vabs(x) > set1(c_maxVectorReduce)) != 0)
+    {
+      float xs[kWidth];
+      float rs[kWidth];
+      store(xs, x);
+      store(rs, r);
+      for (int i=0; i<kWidth; ++i)
+      {
+        if (fabsf(xs[i]) > c_maxVectorReduce)
+        {
+          rs[i] = scalar(xs[i]);
+        }
+      }
+      r = load(rs);
+    }
+    return r;
+  }
+
+  // same polynomials as _sinApprox and _cosApprox
+  inline vfloat sinPoly(vfloat x)
+  {
+    vfloat xSqr = x * x;
+    vfloat r = madd(set1(7.61e-03f), xSqr, set1(-1.6605e-01f));
+    r = madd(r, xSqr, set1(1.0f));
+    return r * x;
+  }
+
+  inline vfloat cosPoly(vfloat x)
+  {
+    vfloat xSqr = x * x;
+    vfloat r = madd(set1(3.705e-02f), xSqr, set1(-4.967e-01f));
+    return madd(r, xSqr, set1(1.0f));
+  }
+
+  inline vfloat sinKernel(vfloat x)
+  {
+    vfloat r = mod2pi(x);
+    // fold [pi/2, pi] onto [0, pi/2] (and likewise for negative x): sin(x) == sin(+-pi - x)
+    vmask fold = vabs(r) > set1(stevesch::c_fpi_2);
+    r = select(fold, copySign(set1(stevesch::c_fpi), r) - r, r);
+    return withLargeLanes(x, sinPoly(r), [](float v) { return stevesch::sinApprox(v); });
+  }
+
+  inline vfloat cosKernel(vfloat x)
+  {
+    vfloat r = vabs(mod2pi(x));
+    // cos(x) == -cos(pi - x)
+    vmask fold = r > set1(stevesch::c_fpi_2);
+    r = select(fold, set1(stevesch::c_fpi) - r, r);
+    vfloat c = cosPoly(r);
+    return withLargeLanes(x, select(fold, -c, c), [](float v) { return stevesch::cosApprox(v); });
+  }
+
+  // same polynomials and quadrant logic as sinCosApprox<5>
+  inline void sinCosKernel(vfloat x, vfloat& s, vfloat& c)
+  {
+    vfloat k = vround(x * set1(1.0f / stevesch::c_fpi_2));
+    vfloat r = nmadd(k, set1(stevesch::polyApprox::c_pi_2Hi), x);
+    r = nmadd(k, set1(stevesch::polyApprox::c_pi_2Lo), r);
+    vfloat r2 = r * r;
+    vfloat ps = madd(set1(0.00812155753f), r2, set1(-0.166601613f));
+    ps = madd(ps, r2, set1(0.999994993f)) * r;
+    vfloat pc = madd(set1(-0.0013585909f), r2, set1(0.0416550264f));
+    pc = madd(pc, r2, set1(-0.499998569f));
+    pc = madd(pc, r2, set1(1.0f));
+
+    // odd quadrants swap sin and cos; the sign bits come from quadrant
+    // bit 1 (sin) and from bit 1 of quadrant + 1 (cos)
+    vint quadrant = toInt(k);
+    vmask swap = toFloat(quadrant & set1Int(1)) > set1(0.5f);
+    vint sinSign = shiftLeft<30>(quadrant & set1Int(2));
+    vint cosSign = shiftLeft<30>((quadrant + set1Int(1)) & set1Int(2));
+    s = asFloat(asInt(select(swap, pc, ps)) ^ sinSign);
+    c = asFloat(asInt(select(swap, ps, pc)) ^ cosSign);
+  }
+} // namespace
+
+namespace stevesch
+{
+	void sinApprox(const float* in, float* out, size_t n)
+	{
+		transform(in, out, n, sinKernel);
+	}
+
+	void cosApprox(const float* in, float* out, size_t n)
+	{
+		transform(in, out, n, cosKernel);
+	}
+
+	void sinCosApprox(const float* in, float* outSin, float* outCos, size_t n)
+	{
+		vfloat s, c;
+		size_t i = 0;
+		for (; i + kWidth <= n; i += kWidth)
+		{
+			sinCosKernel(load(in + i), s, c);
+			store(outSin + i, s);
+			store(outCos + i, c);
+		}
+		if (i < n)
+		{
+			float tmp[kWidth] = {0.0f};
+			memcpy(tmp, in + i, (n - i) * sizeof(float));
+			sinCosKernel(load(tmp), s, c);
+			store(tmp, s);
+			memcpy(outSin + i, tmp, (n - i) * sizeof(float));
+			store(tmp, c);
+			memcpy(outCos + i, tmp, (n - i) * sizeof(float));
+		}
+	}
+}
@@ -69,7 +69,16 @@ namespace stevesch
 		if (x > c_fpi_2) return -_cosApprox(c_fpi - x);
 		return _cosApprox(x);
 	}
-	
+
+
+	// batch versions of sinApprox and cosApprox: out[i] = sinApprox(in[i]), i in [0, n).
+	// Range reduction is branch-free and vectorized (exact for |x| < 4e5), so
+	// results can differ from the single-value versions in the last bits;
+	// values beyond that range go through the single-value versions, which
+	// reduce with fmodf.  in and out may be the same buffer.
+	void sinApprox(const float* in, float* out, size_t n);
+	void cosApprox(const float* in, float* out, size_t n);
+
 	
 	// parametric sinusoidal interpolation, 0.0f <= t <= 1.0f.
 	// maps linear t to smooth sinusoidal curve between 0 and 1
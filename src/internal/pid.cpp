@@ -1,4 +1,5 @@
 #include "pid.h"
+#include <string.h>
 // Copyright © 2002, Stephen Schlueter, All Rights Reserved. https://github.com/stevesch
 
 namespace stevesch
@@ -109,6 +110,133 @@ namespace stevesch
 	}
 
 
+	namespace
+	{
+		typedef double Matrix3[3][3];
+
+		inline void multiply(Matrix3& dst, const Matrix3& m1, const Matrix3& m2)
+		{
+			Matrix3 tmp;
+			for (int r=0; r<3; ++r)
+			{
+				for (int c=0; c<3; ++c)
+				{
+					tmp[r][c] = m1[r][0]*m2[0][c] + m1[r][1]*m2[1][c] + m1[r][2]*m2[2][c];
+				}
+			}
+			memcpy(dst, tmp, sizeof(tmp));
+		}
+
+		// matrix exponential by scaling and squaring:
+		// exp(A) = exp(A / 2^s)^(2^s), with |A / 2^s| <= 0.5 so that a
+		// short Taylor series is accurate to double precision
+		void exponential(Matrix3& dst, const Matrix3& A)
+		{
+			double norm = 0.0;
+			for (int r=0; r<3; ++r)
+			{
+				double rowSum = fabs(A[r][0]) + fabs(A[r][1]) + fabs(A[r][2]);
+				norm = (rowSum > norm) ? rowSum : norm;
+			}
+
+			int squarings = 0;
+			while (norm > 0.5 && squarings < 1024)
+			{
+				norm *= 0.5;
+				++squarings;
+			}
+			const double scale = ldexp(1.0, -squarings);
+
+			Matrix3 M;
+			for (int r=0; r<3; ++r)
+			{
+				for (int c=0; c<3; ++c)
+				{
+					M[r][c] = A[r][c] * scale;
+				}
+			}
+
+			// Horner form of the Taylor series: I + M(I + M/2(I + M/3(...)))
+			const int kTerms = 12;
+			Matrix3 E = { {1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, {0.0, 0.0, 1.0} };
+			for (int k=kTerms; k>0; --k)
+			{
+				multiply(E, M, E);
+				for (int r=0; r<3; ++r)
+				{
+					for (int c=0; c<3; ++c)
+					{
+						E[r][c] = ((r == c) ? 1.0 : 0.0) + E[r][c] / k;
+					}
+				}
+			}
+
+			for (int n=0; n<squarings; ++n)
+			{
+				multiply(E, E, E);
+			}
+			memcpy(dst, E, sizeof(E));
+		}
+	} // namespace
+
+	PidTransitionCache& threadPidTransitionCache()
+	{
+		static thread_local PidTransitionCache s_cache;
+		return s_cache;
+	}
+
+	void PidTransition::compute(float _a, float _b, float _c, float _dt)
+	{
+		a = _a;
+		b = _b;
+		c = _c;
+		dt = _dt;
+
+		// state [e, v, i]:  e' = v,  v' = -a*e - b*v + c*i,  i' = -e
+		const double t = dt;
+		const Matrix3 A = {
+			{ 0.0,     t,      0.0   },
+			{ -a * t,  -b * t, c * t },
+			{ -t,      0.0,    0.0   },
+		};
+		Matrix3 E;
+		exponential(E, A);
+
+		for (int r=0; r<3; ++r)
+		{
+			for (int col=0; col<3; ++col)
+			{
+				m[r][col] = (float)E[r][col];
+			}
+		}
+	}
+
+	const PidTransition& PidTransitionCache::get(float a, float b, float c, float dt)
+	{
+		for (int n=0; n<mCount; ++n)
+		{
+			const PidTransition& t = mEntries[n];
+			if ((t.dt == dt) && (t.a == a) && (t.b == b) && (t.c == c))
+			{
+				return t;
+			}
+		}
+
+		int n;
+		if (mCount < kCapacity)
+		{
+			n = mCount++;
+		}
+		else
+		{
+			n = mNext;
+			mNext = (mNext + 1) % kCapacity;
+		}
+		mEntries[n].compute(a, b, c, dt);
+		return mEntries[n];
+	}
+
+
 	int Pid::advanceClampStickyInt (float dt, float clamp, float xthreshold, float vthreshold)
 	{
 		float s = eq - x;
@@ -252,6 +252,62 @@ namespace stevesch
 
 	
 	
+	// State-transition matrix of the APID equations for one set of
+	// coefficients and time step.  With offset e = x - eq, the APID is the
+	// linear system
+	//		e' = v
+	//		v' = -a*e - b*v + c*i
+	//		i' = -e
+	// so advancing by dt is exactly [e v i] <- exp(A*dt) * [e v i].  Applying
+	// a transition costs the same for any dt (no sub-stepping).
+	struct PidTransition
+	{
+		float a;
+		float b;
+		float c;
+		float dt;
+		float m[3][3];	// maps [offset, velocity, integral] to the state dt later
+
+		// Purpose: compute the transition for coefficients a, b, c and time step dt
+		void compute(float a, float b, float c, float dt);
+
+		// Purpose: advance p by this transition's dt (eq is unchanged)
+		inline void apply(APID* p) const
+		{
+			float e = p->x - p->eq;
+			float v = p->v;
+			float i = p->i;
+			p->x = p->eq + (m[0][0]*e + m[0][1]*v + m[0][2]*i);
+			p->v = m[1][0]*e + m[1][1]*v + m[1][2]*i;
+			p->i = m[2][0]*e + m[2][1]*v + m[2][2]*i;
+		}
+	};
+
+	// Small cache of PidTransitions keyed by (a, b, c, dt), so controllers
+	// stepped with a fixed time step only compute their transition once.
+	// Not thread-safe; use one cache per thread.
+	class PidTransitionCache
+	{
+	public:
+		static const int kCapacity = 8;
+
+		PidTransitionCache() : mCount(0), mNext(0) {}
+
+		// Purpose: return the transition for (a, b, c, dt), computing it if not cached
+		const PidTransition& get(float a, float b, float c, float dt);
+		void clear() { mCount = 0; mNext = 0; }
+
+	private:
+		PidTransition mEntries[kCapacity];
+		int mCount;
+		int mNext;	// next entry to replace once the cache is full
+	};
+
+	// Purpose: the calling thread's cache, used by Pid::advanceExact when no
+	// cache is passed
+	PidTransitionCache& threadPidTransitionCache();
+
+
 	class Pid;
 
 	typedef void	(Pid::*pidSimpleFn)		( float );
@@ -299,6 +355,17 @@ namespace stevesch
 		// Purpose: Update APID with time step 'dt'
 		inline void advance(float dt)			{ stabilize(&Pid::advanceInt, 1.0f, dt); }
 
+		// Purpose: Update APID with time step 'dt' using the exact solution of the
+		// APID equations (see PidTransition).  Cost does not depend on dt, so this
+		// is suitable for long or irregular frames.  A cache's entries are
+		// replaced by any get(), so a cache must not be shared between
+		// threads; by default each thread uses its own.
+		inline void advanceExact(float dt, PidTransitionCache& cache=threadPidTransitionCache())
+		{
+			if (dt > 0.0f)
+				cache.get(a, b, c, dt).apply(this);
+		}
+
 		// Purpose: Update APID with time step 'dt', but treat near-stationary as stationary.
 		// APID is considered 'stationary' when |x-x0| < xthreshold and |v|<vthreshold.
 		// Returns:
@@ -335,6 +402,18 @@ namespace stevesch
 		inline int circularAdvanceSticky(float dt, float xthreshold, float vthreshold)
 			{ return stabilizeSticky(&Pid::circularAdvanceStickyInt, 1.0f, dt, xthreshold, vthreshold); }
 
+		// Purpose: exact update (see advanceExact) treating position as radians.
+		// The offset from equilibrium is taken the short way around the circle.
+		inline void circularAdvanceExact(float dt, PidTransitionCache& cache=threadPidTransitionCache())
+		{
+			if (dt > 0.0f)
+			{
+				x = eq - closeMod2pi(eq - x);
+				cache.get(a, b, c, dt).apply(this);
+				x = mod2pi(x);
+			}
+		}
+
 		// Purpose: Set the equilibrium point of the APID
 		inline void setEq(float eq) { APIDSetEq (this, eq); }
 
@@ -0,0 +1,315 @@
+#include "pidBank.h"
+#include "simd.h"
+#include <algorithm>
+
+using namespace stevesch::simd;
+
+namespace {
+  // one controller per lane
+  struct Lanes
+  {
+    vfloat x;
+    vfloat eq;
+    vfloat v;
+    vfloat i;
+    vfloat a;
+    vfloat b;
+    vfloat c;
+  };
+
+  inline vfloat acceleration(const Lanes& p, vfloat s)
+  {
+    // (s*a - v*b + i*c)
+    return madd(p.i, p.c, s*p.a - p.v*p.b);
+  }
+
+  // Each step mirrors the APID/Pid function of the same name, and returns
+  // the lanes that were stationary (always 0 for non-sticky steps).
+  struct AdvanceStep
+  {
+    inline int operator()(Lanes& p, vfloat dt) const
+    {
+      vfloat s = p.eq - p.x;
+      vfloat dvdt = acceleration(p, s);
+      p.v = madd(dt, dvdt, p.v);
+      p.i = madd(dt, s, p.i);
+      p.x = madd(dt, p.v, p.x);
+      return 0;
+    }
+  };
+
+  struct AdvanceClampStep
+  {
+    vfloat clamp;
+    inline int operator()(Lanes& p, vfloat dt) const
+    {
+      vfloat s = p.eq - p.x;
+      vfloat dvdt = vmin(vmax(acceleration(p, s), -clamp), clamp);
+      p.v = madd(dt, dvdt, p.v);
+      p.i = madd(dt, s, p.i);
+      p.x = madd(dt, p.v, p.x);
+      return 0;
+    }
+  };
+
+  struct AdvanceStickyStep
+  {
+    vfloat xthreshold;
+    vfloat vthreshold;
+    inline int operator()(Lanes& p, vfloat dt) const
+    {
+      vfloat s = p.eq - p.x;
+      vmask still = (vabs(s) < xthreshold) & (vabs(p.v) < vthreshold);
+      vfloat dvdt = acceleration(p, s);
+      vfloat v = madd(dt, dvdt, p.v);
+      p.i = select(still, p.i, madd(dt, s, p.i));
+      p.x = select(still, p.eq, madd(dt, v, p.x));
+      p.v = select(still, p.v, v);
+      return bits(still);
+    }
+  };
+
+  // note: clamps velocity, as Pid::advanceClampStickyInt does
+  struct AdvanceClampStickyStep
+  {
+    vfloat clamp;
+    vfloat xthreshold;
+    vfloat vthreshold;
+    inline int operator()(Lanes& p, vfloat dt) const
+    {
+      vfloat s = p.eq - p.x;
+      vmask still = (vabs(s) < xthreshold) & (vabs(p.v) < vthreshold);
+      vfloat dvdt = acceleration(p, s);
+      vfloat v = vmin(vmax(madd(dt, dvdt, p.v), -clamp), clamp);
+      p.i = select(still, p.i, madd(dt, s, p.i));
+      p.x = select(still, p.eq, madd(dt, v, p.x));
+      p.v = select(still, p.v, v);
+      return bits(still);
+    }
+  };
+
+  struct CircularAdvanceStep
+  {
+    inline int operator()(Lanes& p, vfloat dt) const
+    {
+      vfloat s = closeMod2pi(p.eq - p.x);
+      vfloat dvdt = acceleration(p, s);
+      p.v = madd(dt, dvdt, p.v);
+      p.i = madd(dt, s, p.i);
+      p.x = mod2pi(madd(dt, p.v, p.x));
+      return 0;
+    }
+  };
+
+  struct CircularAdvanceStickyStep
+  {
+    vfloat xthreshold;
+    vfloat vthreshold;
+    inline int operator()(Lanes& p, vfloat dt) const
+    {
+      vfloat s = closeMod2pi(p.eq - p.x);
+      vmask still = (vabs(s) < xthreshold) & (vabs(p.v) < vthreshold);
+      vfloat dvdt = acceleration(p, s);
+      vfloat v = madd(dt, dvdt, p.v);
+      p.i = select(still, p.i, madd(dt, s, p.i));
+      p.x = select(still, p.eq, mod2pi(madd(dt, v, p.x)));
+      p.v = select(still, p.v, v);
+      return bits(still);
+    }
+  };
+
+  // all controllers use the same sub-steps as Pid::stabilize (dtLimit == 1.0f)
+  const float c_dtLimit = 1.0f;
+
+  struct SubSteps
+  {
+    int fullSteps;
+    float remainder;
+
+    explicit SubSteps(float dt) : fullSteps(0)
+    {
+      while (dt > c_dtLimit)
+      {
+        dt -= c_dtLimit;
+        ++fullSteps;
+      }
+      remainder = dt;
+    }
+  };
+
+  // padding controllers are always stationary; keep them out of the mask
+  inline void clearPaddingBits(std::vector<uint32_t>& mask, size_t count)
+  {
+    for (size_t w=(count + 31) / 32; w<mask.size(); ++w) {
+      mask[w] = 0;
+    }
+    if (count & 31) {
+      mask[count >> 5] &= (1U << (count & 31)) - 1;
+    }
+  }
+
+  inline size_t paddedSize(size_t count)
+  {
+    return (count + kWidth - 1) / kWidth * kWidth;
+  }
+
+  template <typename Step>
+  void advanceLanes(size_t count, float* x, float* eq, float* v, float* i,
+    const float* a, const float* b, const float* c,
+    float dt, const Step& step, uint32_t* stationary)
+  {
+    const SubSteps steps(dt);
+    const vfloat dtFull = set1(c_dtLimit);
+    const vfloat dtRemainder = set1(steps.remainder);
+    const int allLanes = (1 << kWidth) - 1;
+
+    // each block of controllers stays in registers for all of its sub-steps
+    for (size_t k=0; k<count; k+=kWidth)
+    {
+      Lanes p;
+      p.x = load(x + k);
+      p.eq = load(eq + k);
+      p.v = load(v + k);
+      p.i = load(i + k);
+      p.a = load(a + k);
+      p.b = load(b + k);
+      p.c = load(c + k);
+
+      int still = allLanes;
+      for (int n=0; n<steps.fullSteps; ++n)
+      {
+        still &= step(p, dtFull);
+      }
+      if (steps.remainder > 0.0f)
+      {
+        still &= step(p, dtRemainder);
+      }
+
+      store(x + k, p.x);
+      store(eq + k, p.eq);
+      store(v + k, p.v);
+      store(i + k, p.i);
+
+      if (stationary)
+      {
+        stationary[k >> 5] |= (uint32_t)still << (k & 31);
+      }
+    }
+  }
+} // namespace
+
+namespace stevesch
+{
+	void PidBank::resize(size_t count, float a, float b, float c)
+	{
+		const size_t oldCount = mCount;
+		const size_t padded = paddedSize(count);
+		mX.resize(padded, 0.0f);
+		mEq.resize(padded, 0.0f);
+		mV.resize(padded, 0.0f);
+		mI.resize(padded, 0.0f);
+		mA.resize(padded, 0.0f);
+		mB.resize(padded, 0.0f);
+		mC.resize(padded, 0.0f);
+		mStationary.resize((padded + 31) / 32, 0);
+		mCount = count;
+
+		for (size_t k=oldCount; k<count; ++k)
+		{
+			init(k, a, b, c);
+		}
+		// padding controllers don't move
+		for (size_t k=count; k<padded; ++k)
+		{
+			init(k, 0.0f, 0.0f, 0.0f);
+		}
+	}
+
+	size_t PidBank::add(float a, float b, float c)
+	{
+		size_t k = mCount;
+		resize(k + 1, a, b, c);
+		return k;
+	}
+
+	void PidBank::set(size_t k, const APID& pid)
+	{
+		mX[k] = pid.x;
+		mEq[k] = pid.eq;
+		mV[k] = pid.v;
+		mI[k] = pid.i;
+		mA[k] = pid.a;
+		mB[k] = pid.b;
+		mC[k] = pid.c;
+	}
+
+	void PidBank::get(size_t k, APID& pid) const
+	{
+		pid.x = mX[k];
+		pid.eq = mEq[k];
+		pid.v = mV[k];
+		pid.i = mI[k];
+		pid.a = mA[k];
+		pid.b = mB[k];
+		pid.c = mC[k];
+	}
+
+	void PidBank::advanceAll(float dt)
+	{
+		advanceLanes(mCount, mX.data(), mEq.data(), mV.data(), mI.data(),
+			mA.data(), mB.data(), mC.data(), dt, AdvanceStep(), nullptr);
+	}
+
+	void PidBank::advanceClampAll(float dt, float clamp)
+	{
+		AdvanceClampStep step = { set1(clamp) };
+		advanceLanes(mCount, mX.data(), mEq.data(), mV.data(), mI.data(),
+			mA.data(), mB.data(), mC.data(), dt, step, nullptr);
+	}
+
+	const std::vector<uint32_t>& PidBank::advanceStickyAll(float dt, float xthreshold, float vthreshold)
+	{
+		AdvanceStickyStep step = { set1(xthreshold), set1(vthreshold) };
+		std::fill(mStationary.begin(), mStationary.end(), 0);
+		advanceLanes(mCount, mX.data(), mEq.data(), mV.data(), mI.data(),
+			mA.data(), mB.data(), mC.data(), dt, step, mStationary.data());
+		clearPaddingBits(mStationary, mCount);
+		return mStationary;
+	}
+
+	const std::vector<uint32_t>& PidBank::advanceClampStickyAll(float dt, float clamp, float xthreshold, float vthreshold)
+	{
+		AdvanceClampStickyStep step = { set1(clamp), set1(xthreshold), set1(vthreshold) };
+		std::fill(mStationary.begin(), mStationary.end(), 0);
+		advanceLanes(mCount, mX.data(), mEq.data(), mV.data(), mI.data(),
+			mA.data(), mB.data(), mC.data(), dt, step, mStationary.data());
+		clearPaddingBits(mStationary, mCount);
+		return mStationary;
+	}
+
+	void PidBank::circularAdvanceAll(float dt)
+	{
+		advanceLanes(mCount, mX.data(), mEq.data(), mV.data(), mI.data(),
+			mA.data(), mB.data(), mC.data(), dt, CircularAdvanceStep(), nullptr);
+	}
+
+	const std::vector<uint32_t>& PidBank::circularAdvanceStickyAll(float dt, float xthreshold, float vthreshold)
+	{
+		CircularAdvanceStickyStep step = { set1(xthreshold), set1(vthreshold) };
+		std::fill(mStationary.begin(), mStationary.end(), 0);
+		advanceLanes(mCount, mX.data(), mEq.data(), mV.data(), mI.data(),
+			mA.data(), mB.data(), mC.data(), dt, step, mStationary.data());
+		clearPaddingBits(mStationary, mCount);
+		return mStationary;
+	}
+
+	size_t PidBank::countStationary() const
+	{
+		size_t total = 0;
+		for (size_t w=0; w<mStationary.size(); ++w)
+		{
+			total += countBits(mStationary[w]);
+		}
+		return total;
+	}
+}
@@ -0,0 +1,143 @@
+#ifndef STEVESCH_MATHBASE_INTERNAL_PIDBANK_H_
+#define STEVESCH_MATHBASE_INTERNAL_PIDBANK_H_
+
+#include "pid.h"
+#include <vector>
+
+namespace stevesch
+{
+	// PidBank holds many PID controllers (see pid.h) in structure-of-arrays
+	// form: positions, equilibrium points, velocities, integrals and the a, b, c
+	// coefficients each live in their own contiguous array.  The *All() methods
+	// advance every controller in the bank with the same update rules (and the
+	// same sub-stepping) as the corresponding Pid methods, several controllers
+	// per vector instruction.
+	//
+	// Controllers are addressed by index, 0 <= k < size().
+	class PidBank
+	{
+	public:
+		PidBank() : mCount(0) {}
+		//	a - Offset coefficient		(x - x0)
+		//	b - Velocity coefficient	(dx/dt)
+		//	c - Integral coefficient	(integral of (x-x0))
+		explicit PidBank(size_t count, float a=0.08f, float b=0.4f, float c=0.00001f)
+			: mCount(0)
+		{
+			resize(count, a, b, c);
+		}
+
+		size_t size() const { return mCount; }
+
+		// Purpose: change the number of controllers.  Existing controllers keep
+		// their state; new ones are initialized as by APIDInit(a, b, c).
+		void resize(size_t count, float a=0.08f, float b=0.4f, float c=0.00001f);
+
+		// Purpose: append a controller, initialized as by APIDInit(a, b, c).
+		// Returns its index.
+		size_t add(float a, float b, float c);
+
+		// Purpose: copy state and coefficients from/to a single controller
+		void set(size_t k, const APID& pid);
+		void get(size_t k, APID& pid) const;
+
+		inline void init(size_t k, float a, float b, float c)
+		{
+			mA[k] = a; mB[k] = b; mC[k] = c;
+			mX[k] = mEq[k] = mV[k] = mI[k] = 0.0f;
+		}
+
+		// spring, damping, steady-state -- only changes constants, leaves integrator, position and eq unchanged
+		inline void modifyCoefficients(size_t k, float a, float b, float c)
+		{
+			mA[k] = a; mB[k] = b; mC[k] = c;
+		}
+
+		inline void reset(size_t k, float position=0.0f) { reset(k, position, position); }
+		inline void reset(size_t k, float position, float eq)
+		{
+			mX[k] = position;
+			mEq[k] = eq;
+			mI[k] = 0.0f;
+			mV[k] = 0.0f;
+		}
+
+		// Purpose: Set the equilibrium point of controller k
+		inline void setEq(size_t k, float eq) { mEq[k] = eq; mI[k] = 0.0f; }
+
+		// Purpose: Set equilibrium, but only reset the integrator if the new equilibrium
+		// is far from the current equilibrium (difference >= threshold)
+		inline void setEqFrequent(size_t k, float eq, float threshold)
+		{
+			if (fabsf(mEq[k] - eq) >= threshold)
+				mI[k] = 0.0f;
+			mEq[k] = eq;
+		}
+
+		// Purpose: treat position as radians (-pi < x,eq < pi) so that
+		// circular motion can be controlled
+		inline void circularSetEq(size_t k, float eq) { mEq[k] = closeMod2pi(eq); mI[k] = 0.0f; }
+
+		inline float getEq(size_t k) const { return mEq[k]; }
+		inline void setPosition(size_t k, float x) { mX[k] = x; }
+		inline float getPosition(size_t k) const { return mX[k]; }
+		inline float getOffset(size_t k) const { return mX[k] - mEq[k]; }
+		inline void setVelocity(size_t k, float v) { mV[k] = v; }
+		inline float getVelocity(size_t k) const { return mV[k]; }
+
+		// direct access to the arrays (size() valid entries each)
+		inline const float* positions() const { return mX.data(); }
+		inline const float* velocities() const { return mV.data(); }
+		inline float* equilibriums() { return mEq.data(); }
+		inline const float* equilibriums() const { return mEq.data(); }
+
+		// Purpose: Update all controllers with time step 'dt' (see Pid::advance)
+		void advanceAll(float dt);
+
+		// Purpose: Update all controllers, clamping acceleration to [-clamp, clamp]
+		// (see Pid::advanceClamp)
+		void advanceClampAll(float dt, float clamp);
+
+		// Purpose: Update all controllers with time step 'dt', but treat near-stationary
+		// as stationary (see Pid::advanceSticky).
+		// Returns:
+		//	bitmask with bit (k % 32) of word (k / 32) set if controller k was
+		//	stationary (the Pid method would have returned 'FALSE')
+		const std::vector<uint32_t>& advanceStickyAll(float dt, float xthreshold, float vthreshold);
+
+		// Purpose: As advanceStickyAll, but clamping velocity to [-clamp, clamp]
+		// (see Pid::advanceClampSticky)
+		const std::vector<uint32_t>& advanceClampStickyAll(float dt, float clamp, float xthreshold, float vthreshold);
+
+		// Purpose: update all controllers, treating positions as radians (see Pid::circularAdvance)
+		void circularAdvanceAll(float dt);
+
+		// Purpose: sticky update treating positions as radians (see Pid::circularAdvanceSticky).
+		// Returns the stationary bitmask as advanceStickyAll.
+		const std::vector<uint32_t>& circularAdvanceStickyAll(float dt, float xthreshold, float vthreshold);
+
+		// stationary bitmask from the most recent sticky update
+		inline const std::vector<uint32_t>& stationaryMask() const { return mStationary; }
+		inline bool isStationary(size_t k) const
+		{
+			return (k < mCount) && (0 != (mStationary[k >> 5] & (1U << (k & 31))));
+		}
+		// number of controllers that were stationary in the most recent sticky update
+		size_t countStationary() const;
+
+	private:
+		size_t mCount;
+		// arrays are padded to a multiple of the vector width; padding
+		// controllers have zero coefficients and never move
+		std::vector<float> mX;
+		std::vector<float> mEq;
+		std::vector<float> mV;
+		std::vector<float> mI;
+		std::vector<float> mA;
+		std::vector<float> mB;
+		std::vector<float> mC;
+		std::vector<uint32_t> mStationary;
+	};
+}
+
+#endif
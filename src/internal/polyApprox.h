@@ -0,0 +1,286 @@
+#ifndef STEVESCH_MATHBASE_INTERNAL_POLYAPPROX_H_
+#define STEVESCH_MATHBASE_INTERNAL_POLYAPPROX_H_
+// Minimax-polynomial approximations of sin, cos, tan, atan2, exp, log and pow
+// with a compile-time choice of accuracy.  The template parameter is the
+// degree of the polynomial used after range reduction; a higher degree costs
+// a multiply-add or two more per call.  Maximum errors measured by
+// testApproxTiers in examples/minimal (which also reports RMS error and cost):
+//
+//   degree:             3        4        5        7        9       11       13
+//   sinApprox  (abs)  4.5e-3            6.8e-5   7.4e-7   1.9e-7
+//   cosApprox  (abs)  4.5e-3            6.8e-5   7.1e-7   1.5e-7
+//   tanApprox  (rel)  1.8e-2            3.7e-4   4.0e-6   7.4e-7      |x| <= 1.5
+//   atan2Approx (abs)                   6.1e-4   8.2e-5   1.2e-5   1.9e-6   5.2e-7
+//   logApprox  (abs)  7.9e-6            3.3e-7   3.1e-7               1e-3 <= x <= 1e3
+//   sinCosApprox(abs) 1.5e-4            6.3e-7   8.3e-8               (quadrant reduction)
+//
+//   degree:             3        4        5        6
+//   expApprox  (rel)  7.5e-5   2.7e-6   2.2e-7   1.1e-7
+//   powApprox  (rel)  1.0e-4   3.3e-6   8.8e-7   7.6e-7      0.1 <= x <= 10, |y| <= 4
+//
+// The highest degrees are limited by float rounding rather than by the
+// polynomial.  For comparison, sinApprox(x) (non-template, mathApprox.h) is
+// 1.6e-4 and cosApprox(x) is 1.2e-3.
+//
+// Coefficients were fitted with the Remez exchange algorithm (in extended
+// precision) and rounded to float.
+
+#include <string.h>
+#include "scalar.h"
+
+namespace stevesch
+{
+	namespace polyApprox
+	{
+		// c0 + x*(c1 + x*(c2 + ...))
+		inline float horner(float, float c0) { return c0; }
+		template <typename... C>
+		inline float horner(float x, float c0, C... c) { return c0 + x * horner(x, c...); }
+
+		inline uint32_t floatBits(float f) { uint32_t u; memcpy(&u, &f, sizeof(u)); return u; }
+		inline float bitsFloat(uint32_t u) { float f; memcpy(&f, &u, sizeof(f)); return f; }
+
+		// sin(x) for -pi/2 <= x <= pi/2
+		template <int Degree> struct Sin
+		{
+			static_assert(Degree != Degree, "sinApprox/cosApprox/tanApprox: supported degrees are 3, 5, 7, 9");
+		};
+		template <> struct Sin<3> { static inline float eval(float x) {
+			return x * horner(x*x, 0.985529542f, -0.142566726f); } };
+		template <> struct Sin<5> { static inline float eval(float x) {
+			return x * horner(x*x, 0.999696791f, -0.165673077f, 0.00751437712f); } };
+		template <> struct Sin<7> { static inline float eval(float x) {
+			return x * horner(x*x, 0.999996603f, -0.166648284f, 0.00830632541f, -0.000183636541f); } };
+		template <> struct Sin<9> { static inline float eval(float x) {
+			return x * horner(x*x, 1.0f, -0.166666478f, 0.00833289977f, -0.000198008973f, 2.59048852e-06f); } };
+
+		// sin(x) and cos(x) for -pi/4 <= x <= pi/4 (sinCosApprox); the cosine
+		// polynomial is one degree higher than the sine
+		template <int Degree> struct SinCos
+		{
+			static_assert(Degree != Degree, "sinCosApprox: supported degrees are 3, 5, 7");
+		};
+		template <> struct SinCos<3> {
+			static inline float sin(float x) { return x * horner(x*x, 0.999031425f, -0.16034402f); }
+			static inline float cos(float x) { return horner(x*x, 0.999990046f, -0.499708146f, 0.0403985344f); } };
+		template <> struct SinCos<5> {
+			static inline float sin(float x) { return x * horner(x*x, 0.999994993f, -0.166601613f, 0.00812155753f); }
+			static inline float cos(float x) { return horner(x*x, 1.0f, -0.499998569f, 0.0416550264f, -0.0013585909f); } };
+		template <> struct SinCos<7> {
+			static inline float sin(float x) { return x * horner(x*x, 1.0f, -0.166666374f, 0.00833158474f, -0.000194621171f); }
+			static inline float cos(float x) { return horner(x*x, 1.0f, -0.5f, 0.0416666158f, -0.00138866191f, 2.43799295e-05f); } };
+
+		// atan(t) for 0 <= t <= 1
+		template <int Degree> struct Atan
+		{
+			static_assert(Degree != Degree, "atan2Approx: supported degrees are 5, 7, 9, 11, 13");
+		};
+		template <> struct Atan<5> { static inline float eval(float t) {
+			return t * horner(t*t, 0.995357931f, -0.288690239f, 0.0793390423f); } };
+		template <> struct Atan<7> { static inline float eval(float t) {
+			return t * horner(t*t, 0.999213815f, -0.321174979f, 0.146264464f, -0.0389865153f); } };
+		template <> struct Atan<9> { static inline float eval(float t) {
+			return t * horner(t*t, 0.999866307f, -0.330304772f, 0.180159301f, -0.0851563513f, 0.0208451133f); } };
+		template <> struct Atan<11> { static inline float eval(float t) {
+			return t * horner(t*t, 0.999977231f, -0.332622826f, 0.193540379f, -0.116426483f, 0.0526473522f,
+				-0.0117191356f); } };
+		template <> struct Atan<13> { static inline float eval(float t) {
+			return t * horner(t*t, 0.999996126f, -0.333173692f, 0.198078156f, -0.132333428f, 0.0796236694f,
+				-0.0336042196f, 0.00681179296f); } };
+
+		// exp(r) for -ln(2)/2 <= r <= ln(2)/2
+		template <int Degree> struct Exp
+		{
+			static_assert(Degree != Degree, "expApprox/powApprox: supported degrees are 3, 4, 5, 6");
+		};
+		template <> struct Exp<3> { static inline float eval(float r) {
+			return horner(r, 0.999928057f, 1.00016415f, 0.504963279f, 0.165668428f); } };
+		template <> struct Exp<4> { static inline float eval(float r) {
+			return horner(r, 0.999999285f, 0.999963403f, 0.500043571f, 0.167909071f, 0.0414586067f); } };
+		template <> struct Exp<5> { static inline float eval(float r) {
+			return horner(r, 1.00000012f, 0.999999702f, 0.499988943f, 0.166675746f, 0.0419153832f, 0.0082976548f); } };
+		template <> struct Exp<6> { static inline float eval(float r) {
+			return horner(r, 1.0f, 1.0f, 0.499999911f, 0.166664198f, 0.0416682251f, 0.00837481581f, 0.00138368458f); } };
+
+		// log(m) == 2*atanh(s) for s = (m - 1)/(m + 1), |s| <= 3 - 2*sqrt(2)
+		template <int Degree> struct Log
+		{
+			static_assert(Degree != Degree, "logApprox: supported degrees are 3, 5, 7");
+		};
+		template <> struct Log<3> { static inline float eval(float s) {
+			return s * horner(s*s, 1.99995553f, 0.678679883f); } };
+		template <> struct Log<5> { static inline float eval(float s) {
+			return s * horner(s*s, 2.00000024f, 0.666522264f, 0.412963718f); } };
+		template <> struct Log<7> { static inline float eval(float s) {
+			return s * horner(s*s, 2.0f, 0.666668177f, 0.399747938f, 0.299256504f); } };
+
+		// log degree used by powApprox<Degree>
+		template <int Degree> struct PowLog { enum { degree = (Degree < 4) ? 3 : (Degree < 6) ? 5 : 7 }; };
+
+		// Cody-Waite splits: the high parts have few enough significant bits
+		// that k*hi is exact for the multiples of k reached by float inputs
+		constexpr float c_2piHi = 6.28125f;
+		constexpr float c_2piLo = 1.93530717958647692e-3f;
+		constexpr float c_pi_2Hi = 1.5703125f;
+		constexpr float c_pi_2Lo = 4.83826794897e-4f;
+		constexpr float c_piHi = 3.140625f;
+		constexpr float c_piLo = 9.67653589793e-4f;
+		constexpr float c_ln2Hi = 0.693359375f;
+		constexpr float c_ln2Lo = -2.12194440e-4f;
+		constexpr float c_ln2 = 0.693147180559945309f;
+		constexpr float c_log2e = 1.44269504088896341f;
+
+		// x rounded to the nearest integer (halves away from zero), |x| < 2^31;
+		// a conversion, so no rounding-mode or library call
+		inline float nearestInt(float x)
+		{
+			return (float)(int32_t)(x + copysignf(0.5f, x));
+		}
+
+		// x reduced to [-pi, pi]
+		inline float reduce2pi(float x)
+		{
+			float k = nearestInt(x * (1.0f / c_f2pi));
+			return (x - k * c_2piHi) - k * c_2piLo;
+		}
+
+		// 2^k, -126 <= k <= 127
+		inline float pow2i(int k)
+		{
+			return bitsFloat((uint32_t)(k + 127) << 23);
+		}
+
+		// m in [sqrt(1/2), sqrt(2)) and e such that x == m * 2^e (x > 0, normal)
+		inline float splitExponent(float x, int& e)
+		{
+			uint32_t bits = floatBits(x);
+			e = (int)(bits >> 23) - 127;
+			float m = bitsFloat((bits & 0x007fffff) | 0x3f800000);
+			if (m > c_fSqrt2) { m *= 0.5f; ++e; }
+			return m;
+		}
+
+		// 2^y, y clamped to [-126, 127.49]
+		template <int Degree>
+		inline float exp2(float y)
+		{
+			y = clampf(y, -126.0f, 127.49f);
+			float k = nearestInt(y);
+			return Exp<Degree>::eval((y - k) * c_ln2) * pow2i((int)k);
+		}
+
+		// log2(x), x > 0
+		template <int Degree>
+		inline float log2(float x)
+		{
+			int e;
+			float m = splitExponent(x, e);
+			return (float)e + Log<Degree>::eval((m - 1.0f) / (m + 1.0f)) * c_log2e;
+		}
+	}
+
+	// sin(x) from a degree-'Degree' polynomial (see table above), any finite x
+	// with |x| < ~1e5 (beyond that, reduction loses accuracy)
+	template <int Degree>
+	inline float sinApprox(float x)
+	{
+		x = polyApprox::reduce2pi(x);
+		// sin(x) == sin(+-pi - x)
+		if (fabsf(x) > c_fpi_2) x = copysignf(c_fpi, x) - x;
+		return polyApprox::Sin<Degree>::eval(x);
+	}
+
+	// cos(x) == sin(pi/2 - |x|)
+	template <int Degree>
+	inline float cosApprox(float x)
+	{
+		x = polyApprox::reduce2pi(x);
+		return polyApprox::Sin<Degree>::eval(c_fpi_2 - fabsf(x));
+	}
+
+	// sin(theta) and cos(theta) from a single reduction to a quadrant.  The
+	// polynomials only have to cover [-pi/4, pi/4], so each degree is more
+	// accurate than sinApprox/cosApprox of the same degree.
+	template <int Degree = 5>
+	inline void sinCosApprox(float theta, float* pSin, float* pCos)
+	{
+		// theta == r + quadrant*(pi/2), |r| <= pi/4
+		float t = theta * (1.0f / c_fpi_2);
+		int quadrant = (int)(t + copysignf(0.5f, t));
+		float k = (float)quadrant;
+		float r = (theta - k * polyApprox::c_pi_2Hi) - k * polyApprox::c_pi_2Lo;
+		float s = polyApprox::SinCos<Degree>::sin(r);
+		float c = polyApprox::SinCos<Degree>::cos(r);
+		// odd quadrants swap sin and cos; the signs come from bit 1 of the
+		// quadrant (sin) and of quadrant + 1 (cos).  No branches: the quadrant
+		// is unpredictable for arbitrary angles.
+		uint32_t sinBits = polyApprox::floatBits(s);
+		uint32_t cosBits = polyApprox::floatBits(c);
+		uint32_t swap = (sinBits ^ cosBits) & (0u - (uint32_t)(quadrant & 1));
+		uint32_t sinSign = (uint32_t)(quadrant & 2) << 30;
+		uint32_t cosSign = (uint32_t)((quadrant + 1) & 2) << 30;
+		*pSin = polyApprox::bitsFloat(sinBits ^ swap ^ sinSign);
+		*pCos = polyApprox::bitsFloat(cosBits ^ swap ^ cosSign);
+	}
+
+	// batch version of sinCosApprox<5>: outSin[i] = sin(in[i]), outCos[i] = cos(in[i]),
+	// i in [0, n).  Vectorized, so results can differ slightly from the
+	// single-value version.  'in' may be the same buffer as outSin or outCos.
+	void sinCosApprox(const float* in, float* outSin, float* outCos, size_t n);
+
+	// tan(x); relative error is bounded up to the poles
+	template <int Degree = 7>
+	inline float tanApprox(float x)
+	{
+		float k = polyApprox::nearestInt(x * (1.0f / c_fpi));
+		x = (x - k * polyApprox::c_piHi) - k * polyApprox::c_piLo;
+		float s = polyApprox::Sin<Degree>::eval(x);
+		float c = polyApprox::Sin<Degree>::eval(c_fpi_2 - fabsf(x));
+		return s / c;
+	}
+
+	// atan2(y, x) in [-pi, pi]; atan2Approx(0, 0) == 0
+	template <int Degree = 9>
+	inline float atan2Approx(float y, float x)
+	{
+		float ax = fabsf(x);
+		float ay = fabsf(y);
+		float hi = maxf(ax, ay);
+		float lo = minf(ax, ay);
+		float t = (hi > 0.0f) ? (lo / hi) : 0.0f;
+		float a = polyApprox::Atan<Degree>::eval(t);
+		if (ay > ax) a = c_fpi_2 - a;
+		if (x < 0.0f) a = c_fpi - a;
+		return copysignf(a, y);
+	}
+
+	// exp(x); x is clamped to [-87.33, 88.37] so results stay finite and normal
+	template <int Degree = 5>
+	inline float expApprox(float x)
+	{
+		x = clampf(x, -87.33f, 88.37f);
+		float k = polyApprox::nearestInt(x * polyApprox::c_log2e);
+		float r = (x - k * polyApprox::c_ln2Hi) - k * polyApprox::c_ln2Lo;
+		return polyApprox::Exp<Degree>::eval(r) * polyApprox::pow2i((int)k);
+	}
+
+	// natural log of x; x must be positive and normal (no checks for 0,
+	// negatives, denormals, inf or NaN)
+	template <int Degree = 5>
+	inline float logApprox(float x)
+	{
+		int e;
+		float m = polyApprox::splitExponent(x, e);
+		return (float)e * polyApprox::c_ln2 + polyApprox::Log<Degree>::eval((m - 1.0f) / (m + 1.0f));
+	}
+
+	// x^y == 2^(y*log2(x)) for positive, normal x.  Degree selects the exp
+	// polynomial; the log polynomial is matched to it.
+	template <int Degree = 5>
+	inline float powApprox(float x, float y)
+	{
+		return polyApprox::exp2<Degree>(y * polyApprox::log2<polyApprox::PowLog<Degree>::degree>(x));
+	}
+}
+
+#endif
@@ -0,0 +1,366 @@
+#include "randEngine.h"
+#include "simd.h"
+#include <string.h>
+
+using namespace stevesch::simd;
+
+// x^(2^(64 + j)) modulo the characteristic polynomial of xoshiro128, bit b
+// of word i the coefficient of x^(32i + b) (row 0 is the published jump)
+const uint32_t stevesch::Xoshiro128Base::kStreamJump[32][4] = {
+  { 0x8764000bU, 0xf542d2d3U, 0x6fa035c3U, 0x77f2db5bU },  // 2^64
+  { 0x9b802a8bU, 0x794805edU, 0x5eb170f0U, 0x7c0f7916U },  // 2^65
+  { 0x1a235895U, 0x008078d6U, 0x18eca90eU, 0x5f292782U },  // 2^66
+  { 0xf70585fbU, 0x4e0c5957U, 0xbce250c3U, 0x17a896ffU },  // 2^67
+  { 0xd2f6556fU, 0x4a18286dU, 0x3628d30bU, 0x55160319U },  // 2^68
+  { 0x7a7faf9aU, 0xa16bbafdU, 0x0e0ce4fbU, 0x3c7d15deU },  // 2^69
+  { 0xf28e46ebU, 0x5de8d870U, 0x99c73881U, 0x138475d2U },  // 2^70
+  { 0x606a7785U, 0x20e6d45fU, 0x1b647514U, 0x86eb7ca9U },  // 2^71
+  { 0x49666eccU, 0x3789d8a5U, 0x6a660a93U, 0xd71038c4U },  // 2^72
+  { 0x5128e049U, 0x57728e18U, 0x914d8f82U, 0x770b4aaeU },  // 2^73
+  { 0xf4c220b9U, 0x204509e7U, 0xf72abaa8U, 0x87a9ba17U },  // 2^74
+  { 0xa770745cU, 0x6305aeb1U, 0x514fb641U, 0x53f14381U },  // 2^75
+  { 0xef0c0748U, 0x37c6bfd3U, 0xce823c5fU, 0x614b1be8U },  // 2^76
+  { 0xa7598b6eU, 0x56acc333U, 0x7616abebU, 0x444c7482U },  // 2^77
+  { 0x3b8e5872U, 0x95b59666U, 0x250a934eU, 0xe1c8cd14U },  // 2^78
+  { 0x61af734bU, 0xcafb7befU, 0x40320995U, 0x52c3fefdU },  // 2^79
+  { 0x1e448b65U, 0x3d04f456U, 0x0065b6c1U, 0x03ede698U },  // 2^80
+  { 0x999c0c61U, 0x8f514f34U, 0x208ae8a1U, 0xa286055dU },  // 2^81
+  { 0xfd77b051U, 0xdc74937cU, 0x87c9caa7U, 0x87c3b447U },  // 2^82
+  { 0x5cb18704U, 0x3861888cU, 0x421e95f0U, 0x84702775U },  // 2^83
+  { 0x796e8f1cU, 0x17386578U, 0xa950e8b9U, 0x5122b999U },  // 2^84
+  { 0xfd714f38U, 0x6a60580cU, 0x1de92dc7U, 0x0a378a8dU },  // 2^85
+  { 0x920394a9U, 0x59e5f42eU, 0xa82afdb9U, 0x29ec5ed3U },  // 2^86
+  { 0x9d4e636eU, 0x91c22db3U, 0xf24479f8U, 0xb34270eeU },  // 2^87
+  { 0xf610cdc8U, 0x935a2512U, 0xa972efe6U, 0x866bc548U },  // 2^88
+  { 0xf67e06e0U, 0x830fc62fU, 0x426d33f9U, 0x36c311b2U },  // 2^89
+  { 0x82e394f4U, 0x8e7ae190U, 0x74da71b9U, 0x2b8b3ac4U },  // 2^90
+  { 0x1b17a73eU, 0x48ec363cU, 0x9f3a8665U, 0x1ba09ec7U },  // 2^91
+  { 0x5eee0d0eU, 0x8a54b514U, 0x268d5b56U, 0x7c53cf77U },  // 2^92
+  { 0xecb31e06U, 0x1def52d6U, 0x5ec53d4fU, 0xcb831ed8U },  // 2^93
+  { 0x196075bfU, 0xc31db8fbU, 0x2e624b60U, 0xba7e0917U },  // 2^94
+  { 0xf59f8398U, 0x7e8f6a86U, 0xc9ba6afbU, 0xc28a81edU },  // 2^95
+};
+
+namespace {
+  // fills shorter than this use the engine directly (seeding the streams
+  // costs about as much as this many single values)
+  const size_t c_minVectorFill = 64;
+
+  // Streams per fill.  Fixed rather than a multiple of kWidth, so a seed
+  // gives the same sequence whatever the vector width of the build.
+  const int c_streams = 16;
+  const int c_groups = c_streams / kWidth;
+  static_assert(c_streams % kWidth == 0, "streams must fill whole vectors");
+
+  // kWidth streams
+  struct Lanes
+  {
+    vint s0;
+    vint s1;
+    vint s2;
+    vint s3;
+  };
+
+  template <int N>
+  inline vint rotl(vint x) { return shiftLeft<N>(x) | shiftRight<32 - N>(x); }
+
+  inline void advance(Lanes& s)
+  {
+    const vint t = shiftLeft<9>(s.s1);
+    s.s2 = s.s2 ^ s.s0;
+    s.s3 = s.s3 ^ s.s1;
+    s.s1 = s.s1 ^ s.s2;
+    s.s0 = s.s0 ^ s.s3;
+    s.s2 = s.s2 ^ t;
+    s.s3 = rotl<11>(s.s3);
+  }
+
+  struct PlusOutput
+  {
+    inline vint operator()(const Lanes& s) const { return s.s0 + s.s3; }
+  };
+
+  struct StarStarOutput
+  {
+    inline vint operator()(const Lanes& s) const
+    {
+      // rotl(s1 * 5, 7) * 9, multiplies as shift-and-add
+      vint x = shiftLeft<2>(s.s1) + s.s1;
+      x = rotl<7>(x);
+      return shiftLeft<3>(x) + x;
+    }
+  };
+
+  // c_groups sets of lanes (at least two), so consecutive updates don't
+  // wait on each other
+  void seedLanes(uint64_t seed, Lanes (&lanes)[c_groups])
+  {
+    uint32_t s[4][c_streams];
+    stevesch::SplitMix64 sm(seed);
+    for (int lane=0; lane<c_streams; ++lane) {
+      uint64_t x = sm.next64();
+      uint64_t y = sm.next64();
+      s[0][lane] = (uint32_t)x;
+      s[1][lane] = (uint32_t)(x >> 32);
+      s[2][lane] = (uint32_t)y;
+      s[3][lane] = (uint32_t)(y >> 32);
+      if ((s[0][lane] | s[1][lane] | s[2][lane] | s[3][lane]) == 0) {
+        s[0][lane] = 1;
+      }
+    }
+    for (int g=0; g<c_groups; ++g) {
+      lanes[g].s0 = loadInt(s[0] + g * kWidth);
+      lanes[g].s1 = loadInt(s[1] + g * kWidth);
+      lanes[g].s2 = loadInt(s[2] + g * kWidth);
+      lanes[g].s3 = loadInt(s[3] + g * kWidth);
+    }
+  }
+
+  template <typename Engine>
+  inline uint64_t drawSeed(Engine& e)
+  {
+    uint64_t hi = e();
+    return (hi << 32) | e();
+  }
+
+  // Store: void(size_t offset, vint bits) writes kWidth values.
+  // out[i] is output i / c_streams of stream i % c_streams.
+  template <typename Output, typename Store>
+  void generate(uint64_t seed, size_t n, const Output& output, const Store& store)
+  {
+    Lanes lanes[c_groups];
+    seedLanes(seed, lanes);
+    size_t i = 0;
+    for (; i + c_streams <= n; i += c_streams) {
+      for (int g=0; g<c_groups; ++g) {
+        store(i + g * kWidth, output(lanes[g]));
+        advance(lanes[g]);
+      }
+    }
+    for (int g=0; g<c_groups && i<n; ++g, i += kWidth) {
+      if (i + kWidth <= n) {
+        store(i, output(lanes[g]));
+      } else {
+        store.partial(i, n - i, output(lanes[g]));
+      }
+    }
+  }
+
+  struct StoreU32
+  {
+    uint32_t* out;
+    inline void operator()(size_t i, vint bits) const { storeInt(out + i, bits); }
+    void partial(size_t i, size_t count, vint bits) const
+    {
+      uint32_t tmp[kWidth];
+      storeInt(tmp, bits);
+      memcpy(out + i, tmp, count * sizeof(uint32_t));
+    }
+  };
+
+  struct StoreFloat
+  {
+    float* out;
+    vfloat a;
+    vfloat scale;  // (b - a) / 2^24
+
+    inline vfloat convert(vint bits) const
+    {
+      // top 24 bits as a non-negative int, exactly representable
+      return madd(toFloat(shiftRight<8>(bits)), scale, a);
+    }
+    inline void operator()(size_t i, vint bits) const { store(out + i, convert(bits)); }
+    void partial(size_t i, size_t count, vint bits) const
+    {
+      float tmp[kWidth];
+      store(tmp, convert(bits));
+      memcpy(out + i, tmp, count * sizeof(float));
+    }
+  };
+
+  template <typename Engine, typename Output>
+  void fillU32Lanes(Engine& e, uint32_t* out, size_t n, const Output& output)
+  {
+    if (n < c_minVectorFill) {
+      for (size_t i=0; i<n; ++i) {
+        out[i] = e();
+      }
+      return;
+    }
+    StoreU32 s = { out };
+    generate(drawSeed(e), n, output, s);
+  }
+
+  template <typename Engine, typename Output>
+  void fillFloatLanes(Engine& e, float* out, size_t n, float a, float b, const Output& output)
+  {
+    if (n < c_minVectorFill) {
+      const float scale = b - a;
+      for (size_t i=0; i<n; ++i) {
+        out[i] = a + scale * stevesch::randBitsToFloat(e());
+      }
+      return;
+    }
+    StoreFloat s = { out, set1(a), set1((b - a) * (1.0f / 16777216.0f)) };
+    generate(drawSeed(e), n, output, s);
+  }
+
+  ////////////////////////////////////////////////////////////////////////
+  // Philox4x32-10, one block per lane
+
+  struct PhiloxLanes
+  {
+    vint c0;
+    vint c1;
+    vint c2;
+    vint c3;
+  };
+
+  inline void philoxRound(PhiloxLanes& p, vint k0, vint k1)
+  {
+    vint lo0, hi0, lo1, hi1;
+    mulWide(p.c0, 0xd2511f53U, lo0, hi0);
+    mulWide(p.c2, 0xcd9e8d57U, lo1, hi1);
+    p.c0 = hi1 ^ p.c1 ^ k0;
+    p.c1 = lo1;
+    p.c2 = hi0 ^ p.c3 ^ k1;
+    p.c3 = lo0;
+  }
+
+  // blocks firstBlock + [0, kWidth) in lanes
+  inline void loadCounters(PhiloxLanes& p, uint64_t firstBlock)
+  {
+    uint32_t lo[kWidth];
+    uint32_t hi[kWidth];
+    for (int lane=0; lane<kWidth; ++lane) {
+      const uint64_t block = firstBlock + lane;
+      lo[lane] = (uint32_t)block;
+      hi[lane] = (uint32_t)(block >> 32);
+    }
+    p.c0 = loadInt(lo);
+    p.c1 = loadInt(hi);
+    p.c2 = set1Int(0);
+    p.c3 = set1Int(0);
+  }
+
+  // lane j's four words to out[4*j .. 4*j + 3]
+  inline void storeBlocks(const PhiloxLanes& p, uint32_t* out)
+  {
+    uint32_t words[4][kWidth];
+    storeInt(words[0], p.c0);
+    storeInt(words[1], p.c1);
+    storeInt(words[2], p.c2);
+    storeInt(words[3], p.c3);
+    for (int lane=0; lane<kWidth; ++lane) {
+      out[4 * lane + 0] = words[0][lane];
+      out[4 * lane + 1] = words[1][lane];
+      out[4 * lane + 2] = words[2][lane];
+      out[4 * lane + 3] = words[3][lane];
+    }
+  }
+
+  // out[0 .. 4*blockCount) = outputs of blocks firstBlock, firstBlock+1, ...
+  void philoxBlocks(const uint32_t key[2], uint64_t firstBlock, size_t blockCount, uint32_t* out)
+  {
+    const vint w0 = set1Int((int32_t)0x9e3779b9U);
+    const vint w1 = set1Int((int32_t)0xbb67ae85U);
+    size_t b = 0;
+    // two independent sets of lanes, to hide the multiply latency
+    for (; b + 2 * kWidth <= blockCount; b += 2 * kWidth) {
+      PhiloxLanes p;
+      PhiloxLanes q;
+      loadCounters(p, firstBlock + b);
+      loadCounters(q, firstBlock + b + kWidth);
+      vint k0 = set1Int((int32_t)key[0]);
+      vint k1 = set1Int((int32_t)key[1]);
+      for (int round=0; round<10; ++round) {
+        philoxRound(p, k0, k1);
+        philoxRound(q, k0, k1);
+        k0 = k0 + w0;
+        k1 = k1 + w1;
+      }
+      storeBlocks(p, out + 4 * b);
+      storeBlocks(q, out + 4 * (b + kWidth));
+    }
+    for (; b<blockCount; ++b) {
+      const uint64_t block = firstBlock + b;
+      const uint32_t ctr[4] = { (uint32_t)block, (uint32_t)(block >> 32), 0, 0 };
+      stevesch::philox4x32(key, ctr, out + 4 * b);
+    }
+  }
+
+  // shared by CounterRandGen::fillFloatAB and getFloatAB so that both give
+  // the same bits for the same index
+  inline vfloat bitsToFloatAB(vint bits, vfloat a, vfloat scale)
+  {
+    return madd(toFloat(shiftRight<8>(bits)), scale, a);
+  }
+} // namespace
+
+namespace stevesch
+{
+  void RandFill<Xoshiro128Plus>::fillU32(Xoshiro128Plus& e, uint32_t* out, size_t n)
+  {
+    fillU32Lanes(e, out, n, PlusOutput());
+  }
+
+  void RandFill<Xoshiro128Plus>::fillFloat(Xoshiro128Plus& e, float* out, size_t n, float a, float b)
+  {
+    fillFloatLanes(e, out, n, a, b, PlusOutput());
+  }
+
+  void RandFill<Xoshiro128StarStar>::fillU32(Xoshiro128StarStar& e, uint32_t* out, size_t n)
+  {
+    fillU32Lanes(e, out, n, StarStarOutput());
+  }
+
+  void RandFill<Xoshiro128StarStar>::fillFloat(Xoshiro128StarStar& e, float* out, size_t n, float a, float b)
+  {
+    fillFloatLanes(e, out, n, a, b, StarStarOutput());
+  }
+
+  void CounterRandGen::fillU32(uint64_t firstIndex, uint32_t* out, size_t n) const
+  {
+    // whole blocks go straight to 'out'; partial blocks at either end are
+    // computed one index at a time
+    size_t i = 0;
+    while ((i < n) && ((firstIndex + i) & 3)) {
+      out[i] = getU(firstIndex + i);
+      ++i;
+    }
+    const size_t blocks = (n - i) / 4;
+    philoxBlocks(mKey, (firstIndex + i) >> 2, blocks, out + i);
+    i += 4 * blocks;
+    for (; i<n; ++i) {
+      out[i] = getU(firstIndex + i);
+    }
+  }
+
+  void CounterRandGen::fillFloatAB(uint64_t firstIndex, float* out, size_t n, float a, float b) const
+  {
+    const vfloat va = set1(a);
+    const vfloat scale = set1((b - a) * (1.0f / 16777216.0f));
+    const size_t kChunk = 256;
+    uint32_t bits[kChunk] = {0};
+    for (size_t k=0; k<n; k+=kChunk) {
+      const size_t count = (n - k < kChunk) ? (n - k) : kChunk;
+      fillU32(firstIndex + k, bits, count);
+      size_t i = 0;
+      for (; i + kWidth <= count; i += kWidth) {
+        store(out + k + i, bitsToFloatAB(loadInt(bits + i), va, scale));
+      }
+      if (i < count) {
+        float tmp[kWidth];
+        store(tmp, bitsToFloatAB(loadInt(bits + i), va, scale));  // bits has room past 'count'
+        memcpy(out + k + i, tmp, (count - i) * sizeof(float));
+      }
+    }
+  }
+
+  float CounterRandGen::getFloatAB(uint64_t index, float a, float b) const
+  {
+    float tmp[kWidth];
+    store(tmp, bitsToFloatAB(set1Int((int32_t)getU(index)), set1(a), set1((b - a) * (1.0f / 16777216.0f))));
+    return tmp[0];
+  }
+}
@@ -0,0 +1,352 @@
+#ifndef STEVESCH_MATHBASE_INTERNAL_RANDENGINE_H_
+#define STEVESCH_MATHBASE_INTERNAL_RANDENGINE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+
+// Small-state pseudo-random engines for RandGen (see intMath.h).
+//
+// Each engine provides
+//   void seed(uint32_t)         -- deterministic for a given seed
+//   void seed(uint32_t seed, uint32_t stream)
+//                               -- one of many non-overlapping (or, for
+//                                  SplitMix64/StdRandEngine, independently
+//                                  seeded) sequences for the same seed
+//   uint32_t operator()()       -- next 32 random bits
+// and the min()/max() members of a standard uniform random bit generator, so
+// they can also be passed to <random> distributions and std::shuffle.
+
+namespace stevesch
+{
+  inline uint32_t rotl32(uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+
+  // [0.0, 1.0) from the top 24 bits of u, one float ulp apart
+  inline float randBitsToFloat(uint32_t u) { return (float)(u >> 8) * (1.0f / 16777216.0f); }
+
+  // SplitMix64 (Steele, Lea, Flood).  Every seed gives a full-period sequence,
+  // so it is also used to expand a 32-bit seed into the state of the
+  // xoshiro engines.  Returns the high 32 bits of each 64-bit output.
+  class SplitMix64
+  {
+  public:
+    typedef uint32_t result_type;
+
+    explicit SplitMix64(uint64_t nSeed = 0) : mState(nSeed) {}
+    void seed(uint32_t nSeed) { mState = nSeed; }
+    void seed(uint32_t nSeed, uint32_t nStream) { mState = ((uint64_t)nStream << 32) | nSeed; }
+
+    inline uint64_t next64()
+    {
+      uint64_t z = (mState += 0x9e3779b97f4a7c15ULL);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      return z ^ (z >> 31);
+    }
+
+    inline uint32_t operator()() { return (uint32_t)(next64() >> 32); }
+
+    static constexpr result_type (min)() { return 0; }
+    static constexpr result_type (max)() { return 0xffffffffU; }
+
+  private:
+    uint64_t mState;
+  };
+
+  // xoshiro128 family (Blackman, Vigna): 128 bits of state, period 2^128 - 1.
+  class Xoshiro128Base
+  {
+  public:
+    typedef uint32_t result_type;
+
+    void seed(uint32_t nSeed)
+    {
+      SplitMix64 sm(nSeed);
+      uint64_t a = sm.next64();
+      uint64_t b = sm.next64();
+      mS[0] = (uint32_t)a;
+      mS[1] = (uint32_t)(a >> 32);
+      mS[2] = (uint32_t)b;
+      mS[3] = (uint32_t)(b >> 32);
+      if ((mS[0] | mS[1] | mS[2] | mS[3]) == 0) {
+        mS[0] = 1; // the all-zero state is a fixed point
+      }
+    }
+
+    // stream k starts 2^64 * k outputs after stream 0 (costs one jump per
+    // set bit of k, so at most 32)
+    void seed(uint32_t nSeed, uint32_t nStream)
+    {
+      seed(nSeed);
+      for (int j=0; nStream != 0; ++j, nStream >>= 1) {
+        if (nStream & 1) {
+          jump(kStreamJump[j]);
+        }
+      }
+    }
+
+    // advance by 2^64 outputs
+    void jump() { jump(kStreamJump[0]); }
+
+    static constexpr result_type (min)() { return 0; }
+    static constexpr result_type (max)() { return 0xffffffffU; }
+
+  protected:
+    // jump polynomials: kStreamJump[j] advances by 2^(64 + j) outputs
+    static const uint32_t kStreamJump[32][4];
+
+    void jump(const uint32_t (&kJump)[4])
+    {
+      uint32_t s0 = 0;
+      uint32_t s1 = 0;
+      uint32_t s2 = 0;
+      uint32_t s3 = 0;
+      for (int i=0; i<4; ++i) {
+        for (int b=0; b<32; ++b) {
+          if (kJump[i] & (1U << b)) {
+            s0 ^= mS[0];
+            s1 ^= mS[1];
+            s2 ^= mS[2];
+            s3 ^= mS[3];
+          }
+          advance();
+        }
+      }
+      mS[0] = s0;
+      mS[1] = s1;
+      mS[2] = s2;
+      mS[3] = s3;
+    }
+
+    inline void advance()
+    {
+      const uint32_t t = mS[1] << 9;
+      mS[2] ^= mS[0];
+      mS[3] ^= mS[1];
+      mS[1] ^= mS[2];
+      mS[0] ^= mS[3];
+      mS[2] ^= t;
+      mS[3] = rotl32(mS[3], 11);
+    }
+
+    uint32_t mS[4];
+  };
+
+  // xoshiro128+: fastest; the lowest few bits are weaker than the rest, which
+  // doesn't matter for floats (top 24 bits) or bounded integers (high bits).
+  class Xoshiro128Plus : public Xoshiro128Base
+  {
+  public:
+    explicit Xoshiro128Plus(uint32_t nSeed = 0) { seed(nSeed); }
+
+    inline uint32_t operator()()
+    {
+      const uint32_t result = mS[0] + mS[3];
+      advance();
+      return result;
+    }
+  };
+
+  // xoshiro128**: all 32 bits of full quality
+  class Xoshiro128StarStar : public Xoshiro128Base
+  {
+  public:
+    explicit Xoshiro128StarStar(uint32_t nSeed = 0) { seed(nSeed); }
+
+    inline uint32_t operator()()
+    {
+      const uint32_t result = rotl32(mS[1] * 5, 7) * 9;
+      advance();
+      return result;
+    }
+  };
+
+  // PCG32 (O'Neill), XSH-RR output: 64-bit LCG state, 32-bit output
+  class Pcg32
+  {
+  public:
+    typedef uint32_t result_type;
+
+    explicit Pcg32(uint32_t nSeed = 0) { seed(nSeed); }
+
+    void seed(uint32_t nSeed) { seed(nSeed, 0); }
+
+    // each stream uses its own LCG increment
+    void seed(uint32_t nSeed, uint32_t nStream)
+    {
+      mIncrement = kIncrement ^ ((uint64_t)nStream << 1);  // stays odd
+      mState = 0;
+      (*this)();
+      mState += 0x853c49e6748fea9bULL + nSeed;
+      (*this)();
+    }
+
+    inline uint32_t operator()()
+    {
+      const uint64_t old = mState;
+      mState = old * 6364136223846793005ULL + mIncrement;
+      const uint32_t xorShifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+      const uint32_t rot = (uint32_t)(old >> 59);
+      return (xorShifted >> rot) | (xorShifted << ((0U - rot) & 31));
+    }
+
+    static constexpr result_type (min)() { return 0; }
+    static constexpr result_type (max)() { return 0xffffffffU; }
+
+  private:
+    static constexpr uint64_t kIncrement = 0xda3e39cb94b95bdbULL;
+    uint64_t mState;
+    uint64_t mIncrement;
+  };
+
+  // Adapts a <random> engine (e.g. std::default_random_engine, the engine
+  // RandGen used to wrap) to 32-bit outputs.
+  template <typename StdEngine>
+  class StdRandEngine
+  {
+  public:
+    typedef uint32_t result_type;
+
+    explicit StdRandEngine(uint32_t nSeed = 0) : mEngine(nSeed) {}
+    void seed(uint32_t nSeed) { mEngine.seed(nSeed); }
+    void seed(uint32_t nSeed, uint32_t nStream)
+    {
+      std::seed_seq seq = { nSeed, nStream };
+      mEngine.seed(seq);
+    }
+
+    inline uint32_t operator()()
+    {
+      std::uniform_int_distribution<uint32_t> distribution(0, 0xffffffffU);
+      return distribution(mEngine);
+    }
+
+    static constexpr result_type (min)() { return 0; }
+    static constexpr result_type (max)() { return 0xffffffffU; }
+
+  private:
+    StdEngine mEngine;
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // bulk generation (see TRandGen::fillU32 and friends)
+
+  // Default: one value at a time from the engine, in the same order as
+  // repeated getU()/getFloat() calls.
+  template <typename Engine>
+  struct RandFill
+  {
+    static void fillU32(Engine& e, uint32_t* out, size_t n)
+    {
+      for (size_t i=0; i<n; ++i) {
+        out[i] = e();
+      }
+    }
+
+    static void fillFloat(Engine& e, float* out, size_t n, float a, float b)
+    {
+      const float scale = b - a;
+      for (size_t i=0; i<n; ++i) {
+        out[i] = a + scale * randBitsToFloat(e());
+      }
+    }
+  };
+
+  // xoshiro128 engines: large fills run 16 independent xoshiro128 streams
+  // side by side in vector registers.  The streams are seeded from 64 bits
+  // drawn from the engine, so a fill advances the engine by two outputs
+  // rather than by n, and the values differ from those n getU() calls
+  // would return (small fills still use the engine directly).  The number
+  // of streams does not depend on the vector width, so a seed gives the
+  // same fill with SSE2, AVX2, NEON or no vector instructions.
+  template <>
+  struct RandFill<Xoshiro128Plus>
+  {
+    static void fillU32(Xoshiro128Plus& e, uint32_t* out, size_t n);
+    static void fillFloat(Xoshiro128Plus& e, float* out, size_t n, float a, float b);
+  };
+
+  template <>
+  struct RandFill<Xoshiro128StarStar>
+  {
+    static void fillU32(Xoshiro128StarStar& e, uint32_t* out, size_t n);
+    static void fillFloat(Xoshiro128StarStar& e, float* out, size_t n, float a, float b);
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  // counter-based generation
+
+  // Philox4x32-10 (Salmon, Moraes, Dror, Shaw, "Parallel random numbers: as
+  // easy as 1, 2, 3", 2011): a keyed bijection of a 128-bit counter, good
+  // enough as a random number generator on its own.
+  inline void philox4x32(const uint32_t key[2], const uint32_t ctr[4], uint32_t out[4])
+  {
+    uint32_t k0 = key[0];
+    uint32_t k1 = key[1];
+    uint32_t c0 = ctr[0];
+    uint32_t c1 = ctr[1];
+    uint32_t c2 = ctr[2];
+    uint32_t c3 = ctr[3];
+    for (int round=0; round<10; ++round) {
+      const uint64_t p0 = (uint64_t)0xd2511f53U * c0;
+      const uint64_t p1 = (uint64_t)0xcd9e8d57U * c2;
+      c0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+      c1 = (uint32_t)p1;
+      c2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+      c3 = (uint32_t)p0;
+      k0 += 0x9e3779b9U;
+      k1 += 0xbb67ae85U;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+  }
+
+  // Stateless generator: getU(index) is a pure function of the key and the
+  // index, so values can be drawn in any order, from any number of threads,
+  // and a parallel loop gives the same results as a serial one.  Bulk fills
+  // give exactly the values of the corresponding single calls (floats
+  // included), wherever the range is split.
+  //
+  // Each Philox block yields the values for four consecutive indices.
+  class CounterRandGen
+  {
+  public:
+    explicit CounterRandGen(uint64_t nKey = 0) { setKey(nKey); }
+    CounterRandGen(uint32_t nKey0, uint32_t nKey1) { mKey[0] = nKey0; mKey[1] = nKey1; }
+
+    void setKey(uint64_t nKey) { mKey[0] = (uint32_t)nKey; mKey[1] = (uint32_t)(nKey >> 32); }
+
+    inline uint32_t getU(uint64_t index) const
+    {
+      const uint64_t block = index >> 2;
+      const uint32_t ctr[4] = { (uint32_t)block, (uint32_t)(block >> 32), 0, 0 };
+      uint32_t out[4];
+      philox4x32(mKey, ctr, out);
+      return out[index & 3];
+    }
+
+    // [0.0, 1.0), as TRandGen::getFloat
+    inline float getFloat(uint64_t index) const { return randBitsToFloat(getU(index)); }
+    float getFloatAB(uint64_t index, float a, float b) const;
+
+    // 0..n-1 by multiply-shift (bias below n/2^32, no rejection so the
+    // result depends only on this index)
+    inline int getInt(uint64_t index, int nRange) const
+    {
+      return (int)(((uint64_t)getU(index) * (uint32_t)nRange) >> 32);
+    }
+
+    // out[i] = getU(firstIndex + i) etc. for i in [0, n)
+    void fillU32(uint64_t firstIndex, uint32_t* out, size_t n) const;
+    void fillFloat(uint64_t firstIndex, float* out, size_t n) const { fillFloatAB(firstIndex, out, n, 0.0f, 1.0f); }
+    void fillFloatAB(uint64_t firstIndex, float* out, size_t n, float a, float b) const;
+
+  private:
+    uint32_t mKey[2];
+  };
+
+} // namespace stevesch
+
+#endif
@@ -1,4 +1,6 @@
 #include "scalar.h"
+#include "simd.h"
+#include <float.h>
 
 namespace stevesch
 {
@@ -17,18 +19,80 @@ namespace stevesch
     return 0.5f*(a1 + b1);
   }
 
-	// converts cartesian <x, y> to polar <r, theta>
-	// zeros values of r where r < deadzone, otherwise
-	// rescales r as follows:
+	void rsqrtfApprox(const float* in, float* out, size_t n)
+	{
+		using namespace simd;
+		simd::transform(in, out, n, [](vfloat x) {
+			// same steps as the single-value rsqrtfApprox
+			vfloat x2 = x * set1(0.5f);
+			vfloat y = asFloat(set1Int(0x5f3759df) - shiftRight<1>(asInt(x)));
+			return y * (set1(1.5f) - (x2 * y * y));
+		});
+	}
+
+	template <int Iterations>
+	void rsqrtApproxPortable(const float* in, float* out, size_t n)
+	{
+		using namespace simd;
+		simd::transform(in, out, n, [](vfloat x) {
+			// same steps as the single-value rsqrtApproxPortable
+			if (Iterations == 0) {
+				return asFloat(set1Int(0x5f37642f) - shiftRight<1>(asInt(x)));
+			}
+			vfloat x2 = x * set1(0.5f);
+			vfloat y = asFloat(set1Int(0x5f1ffff9) - shiftRight<1>(asInt(x)));
+			y = y * (set1(0.703952253f) * nmadd(x * y, y, set1(2.38924456f)));
+			for (int i=1; i<Iterations; ++i) {
+				y = y * nmadd(x2 * y, y, set1(1.5f));
+			}
+			return y;
+		});
+	}
+
+	template <int Iterations>
+	void rsqrtApprox(const float* in, float* out, size_t n)
+	{
+#if defined(STEVESCH_SIMD_PORTABLE)
+		// no estimate instruction: same as the single-value rsqrtApprox
+		rsqrtApproxPortable<Iterations>(in, out, n);
+#else
+		using namespace simd;
+		simd::transform(in, out, n, [](vfloat x) {
+			vfloat x2 = x * set1(0.5f);
+			vfloat y = vrsqrtEstimate(x);
+			for (int i=0; i<Iterations; ++i) {
+				y = y * nmadd(x2 * y, y, set1(1.5f));
+			}
+			return y;
+		});
+#endif
+	}
+
+	template void rsqrtApprox<0>(const float* in, float* out, size_t n);
+	template void rsqrtApprox<1>(const float* in, float* out, size_t n);
+	template void rsqrtApprox<2>(const float* in, float* out, size_t n);
+	template void rsqrtApprox<3>(const float* in, float* out, size_t n);
+	template void rsqrtApproxPortable<0>(const float* in, float* out, size_t n);
+	template void rsqrtApproxPortable<1>(const float* in, float* out, size_t n);
+	template void rsqrtApproxPortable<2>(const float* in, float* out, size_t n);
+	template void rsqrtApproxPortable<3>(const float* in, float* out, size_t n);
+
+	// Rescales the length r of <x, y> as follows, keeping its direction:
 	//
+	// [0.0, deadzone) ---> 0.0
 	// [deadzone, 1.0] ---> [0.0, 1.0]
+	// (1.0, inf)      ---> 1.0
 	//
 	// This effectively "chops out" the range of values
-	// near 0.0 (within the dead zone)
-	// resulting <r, theta> is converted back to <x, y>
+	// near 0.0 (within the dead zone).  Rather than converting to polar
+	// <r, theta> and back, <x, y> is scaled by newR / r, with 1/r from an
+	// inverse square root estimate refined by two Newton steps (error in
+	// the result ~1e-5).  If x*x + y*y overflows, <x, y> is first scaled so
+	// that its larger component is +-1 (an infinite component becomes +-1 and
+	// a finite one beside it 0), which keeps the direction.
 	bool zeroDeadZonePolar(float & x, float & y, float deadzone)
 	{
-		// SASSERT(deadzone <= 1.0f);
+		// SASSERT(deadzone < 1.0f);
 
 		float rr = (x*x + y*y);	// radius squared
 
@@ -38,23 +102,96 @@ namespace stevesch
 			return true;
 		}
 
-		float theta = atan2f(x, y);
+		if (rr > FLT_MAX)
+		{
+			float m = fmaxf(fabsf(x), fabsf(y));
+			if (m > FLT_MAX)
+			{
+				x = (fabsf(x) > FLT_MAX) ? copysignf(1.0f, x) : 0.0f;
+				y = (fabsf(y) > FLT_MAX) ? copysignf(1.0f, y) : 0.0f;
+			}
+			else
+			{
+				x /= m;
+				y /= m;
+			}
+			rr = x*x + y*y;
+		}
+
+		float invR = rsqrtfApprox(rr);
+		invR *= 1.5f - (0.5f * rr * invR * invR);
+		float r = rr * invR;
+		float newR = clampf((r - deadzone) / (1.0f - deadzone), 0.0f, 1.0f);
+		float scale = newR * invR;
+		x *= scale;
+		y *= scale;
+
+		return false;
+	}
+
+	void zeroDeadZonePolar(float* xs, float* ys, size_t n, float deadzone)
+	{
+		using namespace simd;
+		const vfloat dz = set1(deadzone);
+		const vfloat dz2 = set1(deadzone * deadzone);
+		const vfloat invRange = set1(1.0f / (1.0f - deadzone));
+		const vfloat zero = set1(0.0f);
+		const vfloat one = set1(1.0f);
+		const vfloat fltMax = set1(FLT_MAX);
+
+		// as the single-value version, with 1/(1 - deadzone) hoisted out;
+		// scales x and y in place
+		auto deadZone = [&](vfloat& x, vfloat& y) {
+			vfloat rr = madd(x, x, y * y);
+			vmask huge = rr > fltMax;
+			if (bits(huge) != 0)
+			{
+				// x*x + y*y overflowed in some lanes: scale those to a larger
+				// component of +-1 first (inf / inf would be NaN, so infinite
+				// components become +-1 and finite ones beside them 0)
+				vfloat ax = vabs(x);
+				vfloat ay = vabs(y);
+				vfloat invM = one / vmax(ax, ay);
+				vfloat sx = select(ax > fltMax, copySign(one, x), x * invM);
+				vfloat sy = select(ay > fltMax, copySign(one, y), y * invM);
+				x = select(huge, sx, x);
+				y = select(huge, sy, y);
+				rr = madd(x, x, y * y);
+			}
+			vfloat halfRR = rr * set1(0.5f);
+			vfloat invR = asFloat(set1Int(0x5f3759df) - shiftRight<1>(asInt(rr)));
+			invR = invR * (set1(1.5f) - (halfRR * invR * invR));
+			invR = invR * (set1(1.5f) - (halfRR * invR * invR));
+			vfloat newR = vmin(vmax((rr * invR - dz) * invRange, zero), one);
+			vfloat scale = select(rr < dz2, zero, newR * invR);
+			x = x * scale;
+			y = y * scale;
+		};
 
-		if (rr >= 1.0f)
+		size_t i = 0;
+		for (; i + kWidth <= n; i += kWidth)
 		{
-			rr = 1.0f;
+			vfloat x = load(xs + i);
+			vfloat y = load(ys + i);
+			deadZone(x, y);
+			store(xs + i, x);
+			store(ys + i, y);
 		}
-		else
+		if (i < n)
 		{
-			rr = (sqrtf(rr) - deadzone) / (1.0f - deadzone);
+			// padding lanes are <0, 0>
+			float tx[kWidth] = {0.0f};
+			float ty[kWidth] = {0.0f};
+			memcpy(tx, xs + i, (n - i) * sizeof(float));
+			memcpy(ty, ys + i, (n - i) * sizeof(float));
+			vfloat x = load(tx);
+			vfloat y = load(ty);
+			deadZone(x, y);
+			store(tx, x);
+			store(ty, y);
+			memcpy(xs + i, tx, (n - i) * sizeof(float));
+			memcpy(ys + i, ty, (n - i) * sizeof(float));
 		}
-	
-		// rr is now radius
-		cosSinf( theta, &y, &x );
-		x *= rr;
-		y *= rr;
-
-		return false;
 	}
 
 	
@@ -9,6 +9,7 @@
 //	Modified:
 
 #include <math.h>
+#include <string.h>
 #include <type_traits>
 #include <limits>
 #include <functional>
@@ -16,6 +17,15 @@
 #include "mathBase.h"
 #include "intMath.h"
 
+// reciprocal square root estimate instructions used by rsqrtApprox
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define STEVESCH_RSQRT_SSE 1
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define STEVESCH_RSQRT_NEON 1
+#include <arm_neon.h>
+#endif
+
 namespace stevesch
 {
   constexpr float c_fpi = 3.1415926535897932384626433832795029f;         // pi
@@ -46,6 +56,7 @@ namespace stevesch
 
   inline float recipf(float x) { return (1.0f / x); }
   inline float rsqrtf(float x) { return 1.0f / sqrtf(x); }
+  // see also rsqrtApprox<Iterations> below (tuned constants, hardware estimates)
   inline float rsqrtfApprox(float x)
   {
     // See http://en.wikipedia.org/wiki/Fast_inverse_square_root
@@ -64,8 +75,98 @@ namespace stevesch
     return float2;
   }
 
+  // batch version of rsqrtfApprox: out[i] = rsqrtfApprox(in[i]), i in [0, n).
+  // in and out may be the same buffer.
+  void rsqrtfApprox(const float* in, float* out, size_t n);
+
+  // 1/sqrt(x) with a compile-time choice of accuracy, for normal x > 0
+  // (0, denormals, infinity and NaN are not handled).
+  //
+  // rsqrtApproxPortable<Iterations> uses the bit trick of rsqrtfApprox on
+  // every target, with constants tuned for the iteration count: 0x5f37642f
+  // for the bare estimate, otherwise 0x5f1ffff9 followed by a first step with
+  // adjusted coefficients (Moroz et al., 2018), then ordinary Newton-Raphson
+  // steps.  rsqrtApprox<Iterations> starts instead from the target's
+  // reciprocal square root estimate instruction (SSE rsqrtss, NEON vrsqrte)
+  // and applies 'Iterations' Newton-Raphson steps; on targets without one
+  // (e.g. ESP32) it is rsqrtApproxPortable.
+  //
+  // Maximum relative error, measured over every float in [1, 4) (the error
+  // pattern repeats for every other power of two):
+  //
+  //   Iterations:             0        1        2        3
+  //   rsqrtApprox (SSE)     3.3e-4   2.7e-7   1.4e-7   1.1e-7
+  //   rsqrtApprox (NEON)    3.3e-3   1.6e-5   1.5e-7   1.1e-7
+  //   rsqrtApproxPortable   3.4e-2   6.5e-4   7.7e-7   1.4e-7
+  //
+  // For comparison rsqrtfApprox (0x5f3759df and one step) is 1.8e-3 and
+  // rsqrtf is 9e-8.  The benchmarks "scalar/rsqrt*" in extras/bench report
+  // error next to speed.
+  namespace rsqrt
+  {
+    inline float bitEstimate(float x, uint32_t magic)
+    {
+      uint32_t i;
+      memcpy(&i, &x, sizeof(i));
+      i = magic - (i >> 1);
+      float y;
+      memcpy(&y, &i, sizeof(y));
+      return y;
+    }
+
+    // one Newton-Raphson step for y ~= 1/sqrt(x)
+    inline float newtonStep(float x, float y)
+    {
+      return y * (1.5f - 0.5f * x * y * y);
+    }
+  } // namespace rsqrt
+
+  template <int Iterations = 1>
+  inline float rsqrtApproxPortable(float x)
+  {
+    static_assert(Iterations >= 0, "rsqrtApproxPortable: Iterations must be >= 0");
+    if (Iterations == 0) {
+      return rsqrt::bitEstimate(x, 0x5f37642f);
+    }
+    float y = rsqrt::bitEstimate(x, 0x5f1ffff9);
+    y *= 0.703952253f * (2.38924456f - x * y * y);
+    for (int i=1; i<Iterations; ++i) {
+      y = rsqrt::newtonStep(x, y);
+    }
+    return y;
+  }
+
+  template <int Iterations = 1>
+  inline float rsqrtApprox(float x)
+  {
+    static_assert(Iterations >= 0, "rsqrtApprox: Iterations must be >= 0");
+#if defined(STEVESCH_RSQRT_SSE) || defined(STEVESCH_RSQRT_NEON)
+#if defined(STEVESCH_RSQRT_SSE)
+    float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+#else
+    float y = vget_lane_f32(vrsqrte_f32(vdup_n_f32(x)), 0);
+#endif
+    for (int i=0; i<Iterations; ++i) {
+      y = rsqrt::newtonStep(x, y);
+    }
+    return y;
+#else
+    return rsqrtApproxPortable<Iterations>(x);
+#endif
+  }
+
+  // batch versions: out[i] = rsqrtApprox<Iterations>(in[i]) (respectively
+  // rsqrtApproxPortable), i in [0, n).  in and out may be the same buffer.
+  // Iterations 0 to 3 are available.  The vector estimate instruction may
+  // differ from the scalar one, so results can differ in the last bits.
+  template <int Iterations>
+  void rsqrtApprox(const float* in, float* out, size_t n);
+  template <int Iterations>
+  void rsqrtApproxPortable(const float* in, float* out, size_t n);
+
   // future expansion for simultaneous cosine & sine computation
   // given a single theta value
+  // see also sinCosApprox (polyApprox.h), which shares one range reduction
   inline void cosSinf(float theta, float *pCosf, float *pSinf)
   {
     // SASSERT( 0 != pCosf );
@@ -117,7 +218,7 @@ namespace stevesch
   // random number (0.0, 1.0)
   inline float randf()
   {
-    return S_RandGen.getFloat();
+    return defaultRandGen().getFloat();
     //		return ( ((float)rand()) / RAND_MAX );
     //		return ( (float)SRandU() / ((float)0xffffffffU) );
   }
@@ -125,7 +226,7 @@ namespace stevesch
   // random number (a, b)
   inline float randfAB(float a, float b)
   {
-    return S_RandGen.getFloatAB(a, b);
+    return defaultRandGen().getFloatAB(a, b);
     //		return Lerpf( a, b, Randf() );
   }
 
@@ -216,18 +317,25 @@ namespace stevesch
     return t;
   }
 
-  // converts cartesian <x, y> to polar <r, theta>
-  // zeros values of r where r < deadzone, otherwise
+  // rescales the length r of <x, y>, keeping its direction:
+  // zeros <x, y> where r < deadzone, otherwise
   // rescales r as follows:
   //
   // [deadzone, 1.0] ---> [0.0, 1.0]
+  // (1.0, inf)      ---> 1.0
   //
   // This effectively "chops out" the range of values
-  // near 0.0 (within the dead zone)
-  // resulting <r, theta> is converted back to <x, y>
+  // near 0.0 (within the dead zone).  0 <= deadzone < 1.
+  // No trig: <x, y> is scaled directly, using an inverse square root
+  // estimate (error in the result ~1e-5).
   // returns 'true' if <x, y> is within dead-zone (output x=y=0)
   bool zeroDeadZonePolar(float &x, float &y, float deadzone);
 
+  // batch version of zeroDeadZonePolar: applied in place to each <xs[i], ys[i]>,
+  // i in [0, n).  Vectorized, so results can differ from the single-value
+  // version in the last bits.
+  void zeroDeadZonePolar(float* xs, float* ys, size_t n, float deadzone);
+
   // linearly interpolate between two integer values and return the nearest integer to that result
   inline int lerpInt(int a, int b, float t)
   {
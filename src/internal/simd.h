@@ -0,0 +1,445 @@
+#ifndef STEVESCH_MATHBASE_INTERNAL_SIMD_H_
+#define STEVESCH_MATHBASE_INTERNAL_SIMD_H_
+// Thin wrappers over the vector instructions of the target, used by the
+// batch (array) functions of this library.  Exactly one implementation is
+// selected at compile time:
+//
+//   AVX2+FMA   8 lanes   (x86 built with -mavx2 -mfma or -march=native)
+//   SSE2       4 lanes   (any x86-64; SSE4.1 rounding is used if enabled)
+//   NEON       4 lanes   (ARM/AArch64)
+//   portable   4 lanes   (plain C++ loops, e.g. ESP32)
+//
+// vfloat holds kWidth floats, vint holds kWidth 32-bit integers and vmask
+// holds the result of a lane-wise comparison.  Loads and stores are
+// unaligned.  Functions here are internal; the library's public batch APIs
+// take plain pointers and a count.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#define STEVESCH_SIMD_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define STEVESCH_SIMD_SSE2 1
+#include <emmintrin.h>
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define STEVESCH_SIMD_NEON 1
+#include <arm_neon.h>
+#else
+#define STEVESCH_SIMD_PORTABLE 1
+#endif
+
+namespace stevesch
+{
+namespace simd
+{
+  // reinterpret the bits of a float as an integer and vice-versa
+  inline uint32_t floatBits(float f)
+  {
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+  }
+
+  inline float bitsFloat(uint32_t u)
+  {
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+  }
+
+#if defined(STEVESCH_SIMD_AVX2)
+  ////////////////////////////////////////////////////////////////////////
+  // AVX2
+
+  constexpr int kWidth = 8;
+  struct vfloat { __m256 v; };
+  struct vint { __m256i v; };
+  struct vmask { __m256 v; };
+
+  inline vfloat load(const float* p) { return vfloat{_mm256_loadu_ps(p)}; }
+  inline void store(float* p, vfloat a) { _mm256_storeu_ps(p, a.v); }
+  inline vfloat set1(float f) { return vfloat{_mm256_set1_ps(f)}; }
+
+  inline vfloat operator+(vfloat a, vfloat b) { return vfloat{_mm256_add_ps(a.v, b.v)}; }
+  inline vfloat operator-(vfloat a, vfloat b) { return vfloat{_mm256_sub_ps(a.v, b.v)}; }
+  inline vfloat operator*(vfloat a, vfloat b) { return vfloat{_mm256_mul_ps(a.v, b.v)}; }
+  inline vfloat operator/(vfloat a, vfloat b) { return vfloat{_mm256_div_ps(a.v, b.v)}; }
+  inline vfloat operator-(vfloat a) { return vfloat{_mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f))}; }
+  // a*b + c
+  inline vfloat madd(vfloat a, vfloat b, vfloat c) { return vfloat{_mm256_fmadd_ps(a.v, b.v, c.v)}; }
+  // c - a*b
+  inline vfloat nmadd(vfloat a, vfloat b, vfloat c) { return vfloat{_mm256_fnmadd_ps(a.v, b.v, c.v)}; }
+  inline vfloat vmin(vfloat a, vfloat b) { return vfloat{_mm256_min_ps(a.v, b.v)}; }
+  inline vfloat vmax(vfloat a, vfloat b) { return vfloat{_mm256_max_ps(a.v, b.v)}; }
+  inline vfloat vabs(vfloat a) { return vfloat{_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)}; }
+  inline vfloat vsqrt(vfloat a) { return vfloat{_mm256_sqrt_ps(a.v)}; }
+  // 1/sqrt(a) estimate, relative error < 1.5 * 2^-12
+  inline vfloat vrsqrtEstimate(vfloat a) { return vfloat{_mm256_rsqrt_ps(a.v)}; }
+  // round to nearest (even)
+  inline vfloat vround(vfloat a) { return vfloat{_mm256_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)}; }
+  inline vfloat vfloor(vfloat a) { return vfloat{_mm256_floor_ps(a.v)}; }
+
+  inline vmask operator<(vfloat a, vfloat b) { return vmask{_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)}; }
+  inline vmask operator<=(vfloat a, vfloat b) { return vmask{_mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ)}; }
+  inline vmask operator>(vfloat a, vfloat b) { return vmask{_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)}; }
+  inline vmask operator>=(vfloat a, vfloat b) { return vmask{_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)}; }
+  inline vmask operator&(vmask a, vmask b) { return vmask{_mm256_and_ps(a.v, b.v)}; }
+  inline vmask operator|(vmask a, vmask b) { return vmask{_mm256_or_ps(a.v, b.v)}; }
+  // bit i set if lane i is true
+  inline int bits(vmask m) { return _mm256_movemask_ps(m.v); }
+  // m ? a : b (per lane)
+  inline vfloat select(vmask m, vfloat a, vfloat b) { return vfloat{_mm256_blendv_ps(b.v, a.v, m.v)}; }
+
+  inline vint loadInt(const int32_t* p) { return vint{_mm256_loadu_si256((const __m256i*)p)}; }
+  inline vint loadInt(const uint32_t* p) { return vint{_mm256_loadu_si256((const __m256i*)p)}; }
+  inline void storeInt(int32_t* p, vint a) { _mm256_storeu_si256((__m256i*)p, a.v); }
+  inline void storeInt(uint32_t* p, vint a) { _mm256_storeu_si256((__m256i*)p, a.v); }
+  inline vint set1Int(int32_t i) { return vint{_mm256_set1_epi32(i)}; }
+  inline vint operator+(vint a, vint b) { return vint{_mm256_add_epi32(a.v, b.v)}; }
+  inline vint operator-(vint a, vint b) { return vint{_mm256_sub_epi32(a.v, b.v)}; }
+  inline vint operator&(vint a, vint b) { return vint{_mm256_and_si256(a.v, b.v)}; }
+  inline vint operator|(vint a, vint b) { return vint{_mm256_or_si256(a.v, b.v)}; }
+  inline vint operator^(vint a, vint b) { return vint{_mm256_xor_si256(a.v, b.v)}; }
+  template <int N> inline vint shiftLeft(vint a) { return vint{_mm256_slli_epi32(a.v, N)}; }
+  template <int N> inline vint shiftRight(vint a) { return vint{_mm256_srli_epi32(a.v, N)}; }  // logical
+  // unsigned 32x32 -> 64-bit products of each lane with b, split into low and high words
+  inline void mulWide(vint a, uint32_t b, vint& lo, vint& hi)
+  {
+    const __m256i bv = _mm256_set1_epi32((int)b);
+    const __m256i even = _mm256_mul_epu32(a.v, bv);
+    const __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a.v, 32), bv);
+    lo.v = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xaa);
+    hi.v = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xaa);
+  }
+
+  // truncating conversion to int, and int to float
+  inline vint toInt(vfloat a) { return vint{_mm256_cvttps_epi32(a.v)}; }
+  inline vfloat toFloat(vint a) { return vfloat{_mm256_cvtepi32_ps(a.v)}; }
+  inline vint asInt(vfloat a) { return vint{_mm256_castps_si256(a.v)}; }
+  inline vfloat asFloat(vint a) { return vfloat{_mm256_castsi256_ps(a.v)}; }
+
+#elif defined(STEVESCH_SIMD_SSE2)
+  ////////////////////////////////////////////////////////////////////////
+  // SSE2 (SSE4.1 when available)
+
+  constexpr int kWidth = 4;
+  struct vfloat { __m128 v; };
+  struct vint { __m128i v; };
+  struct vmask { __m128 v; };
+
+  inline vfloat load(const float* p) { return vfloat{_mm_loadu_ps(p)}; }
+  inline void store(float* p, vfloat a) { _mm_storeu_ps(p, a.v); }
+  inline vfloat set1(float f) { return vfloat{_mm_set1_ps(f)}; }
+
+  inline vfloat operator+(vfloat a, vfloat b) { return vfloat{_mm_add_ps(a.v, b.v)}; }
+  inline vfloat operator-(vfloat a, vfloat b) { return vfloat{_mm_sub_ps(a.v, b.v)}; }
+  inline vfloat operator*(vfloat a, vfloat b) { return vfloat{_mm_mul_ps(a.v, b.v)}; }
+  inline vfloat operator/(vfloat a, vfloat b) { return vfloat{_mm_div_ps(a.v, b.v)}; }
+  inline vfloat operator-(vfloat a) { return vfloat{_mm_xor_ps(a.v, _mm_set1_ps(-0.0f))}; }
+  inline vfloat madd(vfloat a, vfloat b, vfloat c) { return vfloat{_mm_add_ps(_mm_mul_ps(a.v, b.v), c.v)}; }
+  inline vfloat nmadd(vfloat a, vfloat b, vfloat c) { return vfloat{_mm_sub_ps(c.v, _mm_mul_ps(a.v, b.v))}; }
+  inline vfloat vmin(vfloat a, vfloat b) { return vfloat{_mm_min_ps(a.v, b.v)}; }
+  inline vfloat vmax(vfloat a, vfloat b) { return vfloat{_mm_max_ps(a.v, b.v)}; }
+  inline vfloat vabs(vfloat a) { return vfloat{_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)}; }
+  inline vfloat vsqrt(vfloat a) { return vfloat{_mm_sqrt_ps(a.v)}; }
+  // 1/sqrt(a) estimate, relative error < 1.5 * 2^-12
+  inline vfloat vrsqrtEstimate(vfloat a) { return vfloat{_mm_rsqrt_ps(a.v)}; }
+
+  inline vmask operator<(vfloat a, vfloat b) { return vmask{_mm_cmplt_ps(a.v, b.v)}; }
+  inline vmask operator<=(vfloat a, vfloat b) { return vmask{_mm_cmple_ps(a.v, b.v)}; }
+  inline vmask operator>(vfloat a, vfloat b) { return vmask{_mm_cmpgt_ps(a.v, b.v)}; }
+  inline vmask operator>=(vfloat a, vfloat b) { return vmask{_mm_cmpge_ps(a.v, b.v)}; }
+  inline vmask operator&(vmask a, vmask b) { return vmask{_mm_and_ps(a.v, b.v)}; }
+  inline vmask operator|(vmask a, vmask b) { return vmask{_mm_or_ps(a.v, b.v)}; }
+  inline int bits(vmask m) { return _mm_movemask_ps(m.v); }
+  inline vfloat select(vmask m, vfloat a, vfloat b)
+  {
+#if defined(__SSE4_1__)
+    return vfloat{_mm_blendv_ps(b.v, a.v, m.v)};
+#else
+    return vfloat{_mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v))};
+#endif
+  }
+
+#if defined(__SSE4_1__)
+  inline vfloat vround(vfloat a) { return vfloat{_mm_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)}; }
+  inline vfloat vfloor(vfloat a) { return vfloat{_mm_floor_ps(a.v)}; }
+#else
+  // valid for |a| < 2^31 (callers only round reduced arguments and bin indices)
+  inline vfloat vround(vfloat a) { return vfloat{_mm_cvtepi32_ps(_mm_cvtps_epi32(a.v))}; }
+  inline vfloat vfloor(vfloat a)
+  {
+    vfloat r = vround(a);
+    return r - vfloat{_mm_and_ps(_mm_cmpgt_ps(r.v, a.v), _mm_set1_ps(1.0f))};
+  }
+#endif
+
+  inline vint loadInt(const int32_t* p) { return vint{_mm_loadu_si128((const __m128i*)p)}; }
+  inline vint loadInt(const uint32_t* p) { return vint{_mm_loadu_si128((const __m128i*)p)}; }
+  inline void storeInt(int32_t* p, vint a) { _mm_storeu_si128((__m128i*)p, a.v); }
+  inline void storeInt(uint32_t* p, vint a) { _mm_storeu_si128((__m128i*)p, a.v); }
+  inline vint set1Int(int32_t i) { return vint{_mm_set1_epi32(i)}; }
+  inline vint operator+(vint a, vint b) { return vint{_mm_add_epi32(a.v, b.v)}; }
+  inline vint operator-(vint a, vint b) { return vint{_mm_sub_epi32(a.v, b.v)}; }
+  inline vint operator&(vint a, vint b) { return vint{_mm_and_si128(a.v, b.v)}; }
+  inline vint operator|(vint a, vint b) { return vint{_mm_or_si128(a.v, b.v)}; }
+  inline vint operator^(vint a, vint b) { return vint{_mm_xor_si128(a.v, b.v)}; }
+  template <int N> inline vint shiftLeft(vint a) { return vint{_mm_slli_epi32(a.v, N)}; }
+  template <int N> inline vint shiftRight(vint a) { return vint{_mm_srli_epi32(a.v, N)}; }
+  inline void mulWide(vint a, uint32_t b, vint& lo, vint& hi)
+  {
+    const __m128i bv = _mm_set1_epi32((int)b);
+    const __m128i even = _mm_mul_epu32(a.v, bv);
+    const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a.v, 32), bv);
+    const __m128i lowWords = _mm_set_epi32(0, -1, 0, -1);
+    lo.v = _mm_or_si128(_mm_and_si128(even, lowWords), _mm_slli_epi64(odd, 32));
+    hi.v = _mm_or_si128(_mm_srli_epi64(even, 32), _mm_andnot_si128(lowWords, odd));
+  }
+
+  inline vint toInt(vfloat a) { return vint{_mm_cvttps_epi32(a.v)}; }
+  inline vfloat toFloat(vint a) { return vfloat{_mm_cvtepi32_ps(a.v)}; }
+  inline vint asInt(vfloat a) { return vint{_mm_castps_si128(a.v)}; }
+  inline vfloat asFloat(vint a) { return vfloat{_mm_castsi128_ps(a.v)}; }
+
+#elif defined(STEVESCH_SIMD_NEON)
+  ////////////////////////////////////////////////////////////////////////
+  // NEON
+
+  constexpr int kWidth = 4;
+  struct vfloat { float32x4_t v; };
+  struct vint { int32x4_t v; };
+  struct vmask { uint32x4_t v; };
+
+  inline vfloat load(const float* p) { return vfloat{vld1q_f32(p)}; }
+  inline void store(float* p, vfloat a) { vst1q_f32(p, a.v); }
+  inline vfloat set1(float f) { return vfloat{vdupq_n_f32(f)}; }
+
+  inline vfloat operator+(vfloat a, vfloat b) { return vfloat{vaddq_f32(a.v, b.v)}; }
+  inline vfloat operator-(vfloat a, vfloat b) { return vfloat{vsubq_f32(a.v, b.v)}; }
+  inline vfloat operator*(vfloat a, vfloat b) { return vfloat{vmulq_f32(a.v, b.v)}; }
+  inline vfloat operator-(vfloat a) { return vfloat{vnegq_f32(a.v)}; }
+  inline vfloat madd(vfloat a, vfloat b, vfloat c) { return vfloat{vmlaq_f32(c.v, a.v, b.v)}; }
+  inline vfloat nmadd(vfloat a, vfloat b, vfloat c) { return vfloat{vmlsq_f32(c.v, a.v, b.v)}; }
+  inline vfloat vmin(vfloat a, vfloat b) { return vfloat{vminq_f32(a.v, b.v)}; }
+  inline vfloat vmax(vfloat a, vfloat b) { return vfloat{vmaxq_f32(a.v, b.v)}; }
+  inline vfloat vabs(vfloat a) { return vfloat{vabsq_f32(a.v)}; }
+
+  inline vmask operator<(vfloat a, vfloat b) { return vmask{vcltq_f32(a.v, b.v)}; }
+  inline vmask operator<=(vfloat a, vfloat b) { return vmask{vcleq_f32(a.v, b.v)}; }
+  inline vmask operator>(vfloat a, vfloat b) { return vmask{vcgtq_f32(a.v, b.v)}; }
+  inline vmask operator>=(vfloat a, vfloat b) { return vmask{vcgeq_f32(a.v, b.v)}; }
+  inline vmask operator&(vmask a, vmask b) { return vmask{vandq_u32(a.v, b.v)}; }
+  inline vmask operator|(vmask a, vmask b) { return vmask{vorrq_u32(a.v, b.v)}; }
+  inline int bits(vmask m)
+  {
+    return (int)((vgetq_lane_u32(m.v, 0) & 1) | (vgetq_lane_u32(m.v, 1) & 2) |
+                 (vgetq_lane_u32(m.v, 2) & 4) | (vgetq_lane_u32(m.v, 3) & 8));
+  }
+  inline vfloat select(vmask m, vfloat a, vfloat b) { return vfloat{vbslq_f32(m.v, a.v, b.v)}; }
+  // 1/sqrt(a) estimate, relative error < 2^-8
+  inline vfloat vrsqrtEstimate(vfloat a) { return vfloat{vrsqrteq_f32(a.v)}; }
+
+#if defined(__aarch64__)
+  inline vfloat operator/(vfloat a, vfloat b) { return vfloat{vdivq_f32(a.v, b.v)}; }
+  inline vfloat vsqrt(vfloat a) { return vfloat{vsqrtq_f32(a.v)}; }
+  inline vfloat vround(vfloat a) { return vfloat{vrndnq_f32(a.v)}; }
+  inline vfloat vfloor(vfloat a) { return vfloat{vrndmq_f32(a.v)}; }
+#else
+  inline vfloat operator/(vfloat a, vfloat b)
+  {
+    float32x4_t r = vrecpeq_f32(b.v);
+    r = vmulq_f32(r, vrecpsq_f32(b.v, r));
+    r = vmulq_f32(r, vrecpsq_f32(b.v, r));
+    return vfloat{vmulq_f32(a.v, r)};
+  }
+  inline vfloat vsqrt(vfloat a)
+  {
+    float t[4];
+    vst1q_f32(t, a.v);
+    for (int i=0; i<4; ++i) { t[i] = sqrtf(t[i]); }
+    return vfloat{vld1q_f32(t)};
+  }
+  // valid for |a| < 2^22
+  inline vfloat vround(vfloat a)
+  {
+    const float32x4_t magic = vdupq_n_f32(12582912.0f);  // 1.5 * 2^23
+    return vfloat{vsubq_f32(vaddq_f32(a.v, magic), magic)};
+  }
+  inline vfloat vfloor(vfloat a)
+  {
+    vfloat r = vround(a);
+    uint32x4_t gt = vcgtq_f32(r.v, a.v);
+    return vfloat{vsubq_f32(r.v, vreinterpretq_f32_u32(vandq_u32(gt, vreinterpretq_u32_f32(vdupq_n_f32(1.0f)))))};
+  }
+#endif
+
+  inline vint loadInt(const int32_t* p) { return vint{vld1q_s32(p)}; }
+  inline vint loadInt(const uint32_t* p) { return vint{vreinterpretq_s32_u32(vld1q_u32(p))}; }
+  inline void storeInt(int32_t* p, vint a) { vst1q_s32(p, a.v); }
+  inline void storeInt(uint32_t* p, vint a) { vst1q_u32(p, vreinterpretq_u32_s32(a.v)); }
+  inline vint set1Int(int32_t i) { return vint{vdupq_n_s32(i)}; }
+  inline vint operator+(vint a, vint b) { return vint{vaddq_s32(a.v, b.v)}; }
+  inline vint operator-(vint a, vint b) { return vint{vsubq_s32(a.v, b.v)}; }
+  inline vint operator&(vint a, vint b) { return vint{vandq_s32(a.v, b.v)}; }
+  inline vint operator|(vint a, vint b) { return vint{vorrq_s32(a.v, b.v)}; }
+  inline vint operator^(vint a, vint b) { return vint{veorq_s32(a.v, b.v)}; }
+  template <int N> inline vint shiftLeft(vint a) { return vint{vshlq_n_s32(a.v, N)}; }
+  template <int N> inline vint shiftRight(vint a)
+  {
+    return vint{vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(a.v), N))};
+  }
+  inline void mulWide(vint a, uint32_t b, vint& lo, vint& hi)
+  {
+    const uint32x4_t ua = vreinterpretq_u32_s32(a.v);
+    const uint32x2_t bv = vdup_n_u32(b);
+    const uint64x2_t p0 = vmull_u32(vget_low_u32(ua), bv);
+    const uint64x2_t p1 = vmull_u32(vget_high_u32(ua), bv);
+    const uint32x4x2_t words = vuzpq_u32(vreinterpretq_u32_u64(p0), vreinterpretq_u32_u64(p1));
+    lo.v = vreinterpretq_s32_u32(words.val[0]);
+    hi.v = vreinterpretq_s32_u32(words.val[1]);
+  }
+
+  inline vint toInt(vfloat a) { return vint{vcvtq_s32_f32(a.v)}; }
+  inline vfloat toFloat(vint a) { return vfloat{vcvtq_f32_s32(a.v)}; }
+  inline vint asInt(vfloat a) { return vint{vreinterpretq_s32_f32(a.v)}; }
+  inline vfloat asFloat(vint a) { return vfloat{vreinterpretq_f32_s32(a.v)}; }
+
+#else
+  ////////////////////////////////////////////////////////////////////////
+  // portable (plain loops; compilers may still auto-vectorize these)
+
+  constexpr int kWidth = 4;
+  struct vfloat { float v[kWidth]; };
+  struct vint { int32_t v[kWidth]; };
+  struct vmask { bool v[kWidth]; };
+
+#define STEVESCH_SIMD_LANES(expr) for (int i=0; i<kWidth; ++i) { expr; }
+
+  inline vfloat load(const float* p) { vfloat r; STEVESCH_SIMD_LANES(r.v[i] = p[i]); return r; }
+  inline void store(float* p, vfloat a) { STEVESCH_SIMD_LANES(p[i] = a.v[i]); }
+  inline vfloat set1(float f) { vfloat r; STEVESCH_SIMD_LANES(r.v[i] = f); return r; }
+
+  inline vfloat operator+(vfloat a, vfloat b) { STEVESCH_SIMD_LANES(a.v[i] += b.v[i]); return a; }
+  inline vfloat operator-(vfloat a, vfloat b) { STEVESCH_SIMD_LANES(a.v[i] -= b.v[i]); return a; }
+  inline vfloat operator*(vfloat a, vfloat b) { STEVESCH_SIMD_LANES(a.v[i] *= b.v[i]); return a; }
+  inline vfloat operator/(vfloat a, vfloat b) { STEVESCH_SIMD_LANES(a.v[i] /= b.v[i]); return a; }
+  inline vfloat operator-(vfloat a) { STEVESCH_SIMD_LANES(a.v[i] = -a.v[i]); return a; }
+  inline vfloat madd(vfloat a, vfloat b, vfloat c) { STEVESCH_SIMD_LANES(a.v[i] = a.v[i] * b.v[i] + c.v[i]); return a; }
+  inline vfloat nmadd(vfloat a, vfloat b, vfloat c) { STEVESCH_SIMD_LANES(a.v[i] = c.v[i] - a.v[i] * b.v[i]); return a; }
+  inline vfloat vmin(vfloat a, vfloat b) { STEVESCH_SIMD_LANES(a.v[i] = (a.v[i] < b.v[i]) ? a.v[i] : b.v[i]); return a; }
+  inline vfloat vmax(vfloat a, vfloat b) { STEVESCH_SIMD_LANES(a.v[i] = (a.v[i] > b.v[i]) ? a.v[i] : b.v[i]); return a; }
+  inline vfloat vabs(vfloat a) { STEVESCH_SIMD_LANES(a.v[i] = fabsf(a.v[i])); return a; }
+  inline vfloat vsqrt(vfloat a) { STEVESCH_SIMD_LANES(a.v[i] = sqrtf(a.v[i])); return a; }
+  // 1/sqrt(a) estimate (bit trick), relative error < 3.5e-2
+  inline vfloat vrsqrtEstimate(vfloat a)
+  {
+    STEVESCH_SIMD_LANES(a.v[i] = bitsFloat(0x5f37642fU - (floatBits(a.v[i]) >> 1)));
+    return a;
+  }
+  // valid for |a| < 2^22
+  inline vfloat vround(vfloat a)
+  {
+    const float magic = 12582912.0f;  // 1.5 * 2^23
+    STEVESCH_SIMD_LANES(a.v[i] = (a.v[i] + magic) - magic);
+    return a;
+  }
+  inline vfloat vfloor(vfloat a) { STEVESCH_SIMD_LANES(a.v[i] = floorf(a.v[i])); return a; }
+
+  inline vmask operator<(vfloat a, vfloat b) { vmask m; STEVESCH_SIMD_LANES(m.v[i] = a.v[i] < b.v[i]); return m; }
+  inline vmask operator<=(vfloat a, vfloat b) { vmask m; STEVESCH_SIMD_LANES(m.v[i] = a.v[i] <= b.v[i]); return m; }
+  inline vmask operator>(vfloat a, vfloat b) { vmask m; STEVESCH_SIMD_LANES(m.v[i] = a.v[i] > b.v[i]); return m; }
+  inline vmask operator>=(vfloat a, vfloat b) { vmask m; STEVESCH_SIMD_LANES(m.v[i] = a.v[i] >= b.v[i]); return m; }
+  inline vmask operator&(vmask a, vmask b) { STEVESCH_SIMD_LANES(a.v[i] = a.v[i] && b.v[i]); return a; }
+  inline vmask operator|(vmask a, vmask b) { STEVESCH_SIMD_LANES(a.v[i] = a.v[i] || b.v[i]); return a; }
+  inline int bits(vmask m) { int r = 0; STEVESCH_SIMD_LANES(r |= (m.v[i] ? 1 : 0) << i); return r; }
+  inline vfloat select(vmask m, vfloat a, vfloat b) { STEVESCH_SIMD_LANES(a.v[i] = m.v[i] ? a.v[i] : b.v[i]); return a; }
+
+  inline vint loadInt(const int32_t* p) { vint r; STEVESCH_SIMD_LANES(r.v[i] = p[i]); return r; }
+  inline vint loadInt(const uint32_t* p) { vint r; STEVESCH_SIMD_LANES(r.v[i] = (int32_t)p[i]); return r; }
+  inline void storeInt(int32_t* p, vint a) { STEVESCH_SIMD_LANES(p[i] = a.v[i]); }
+  inline void storeInt(uint32_t* p, vint a) { STEVESCH_SIMD_LANES(p[i] = (uint32_t)a.v[i]); }
+  inline vint set1Int(int32_t x) { vint r; STEVESCH_SIMD_LANES(r.v[i] = x); return r; }
+  inline vint operator+(vint a, vint b) { STEVESCH_SIMD_LANES(a.v[i] = (int32_t)((uint32_t)a.v[i] + (uint32_t)b.v[i])); return a; }
+  inline vint operator-(vint a, vint b) { STEVESCH_SIMD_LANES(a.v[i] = (int32_t)((uint32_t)a.v[i] - (uint32_t)b.v[i])); return a; }
+  inline vint operator&(vint a, vint b) { STEVESCH_SIMD_LANES(a.v[i] &= b.v[i]); return a; }
+  inline vint operator|(vint a, vint b) { STEVESCH_SIMD_LANES(a.v[i] |= b.v[i]); return a; }
+  inline vint operator^(vint a, vint b) { STEVESCH_SIMD_LANES(a.v[i] ^= b.v[i]); return a; }
+  template <int N> inline vint shiftLeft(vint a) { STEVESCH_SIMD_LANES(a.v[i] = (int32_t)((uint32_t)a.v[i] << N)); return a; }
+  template <int N> inline vint shiftRight(vint a) { STEVESCH_SIMD_LANES(a.v[i] = (int32_t)((uint32_t)a.v[i] >> N)); return a; }
+  inline void mulWide(vint a, uint32_t b, vint& lo, vint& hi)
+  {
+    STEVESCH_SIMD_LANES(uint64_t p = (uint64_t)(uint32_t)a.v[i] * b; lo.v[i] = (int32_t)(uint32_t)p; hi.v[i] = (int32_t)(uint32_t)(p >> 32));
+  }
+
+  inline vint toInt(vfloat a) { vint r; STEVESCH_SIMD_LANES(r.v[i] = (int32_t)a.v[i]); return r; }
+  inline vfloat toFloat(vint a) { vfloat r; STEVESCH_SIMD_LANES(r.v[i] = (float)a.v[i]); return r; }
+  inline vint asInt(vfloat a) { vint r; STEVESCH_SIMD_LANES(r.v[i] = (int32_t)floatBits(a.v[i])); return r; }
+  inline vfloat asFloat(vint a) { vfloat r; STEVESCH_SIMD_LANES(r.v[i] = bitsFloat((uint32_t)a.v[i])); return r; }
+
+#undef STEVESCH_SIMD_LANES
+#endif
+
+  ////////////////////////////////////////////////////////////////////////
+  // common helpers
+
+  // sign of b applied to magnitude of a
+  inline vfloat copySign(vfloat a, vfloat b)
+  {
+    const vint signBit = set1Int((int32_t)0x80000000);
+    return asFloat((asInt(vabs(a))) | (asInt(b) & signBit));
+  }
+
+  // Cody-Waite split of 2*pi: c_2piHi has few enough significant bits that
+  // k*c_2piHi is exact for |k| < 2^16 (|x| < ~400000)
+  constexpr float c_inv2pi = 0.159154943091895335769f;  // 1/(2*pi)
+  constexpr float c_2piHi = 6.28125f;
+  constexpr float c_2piLo = 1.9353071795864769253e-03f;  // 2*pi - c_2piHi
+
+  // vector equivalent of stevesch::mod2pi(): reduce x to [-pi, pi] by
+  // subtracting the nearest multiple of 2*pi (no fmodf, no branches)
+  inline vfloat mod2pi(vfloat x)
+  {
+    vfloat k = vround(x * set1(c_inv2pi));
+    x = nmadd(k, set1(c_2piHi), x);
+    return nmadd(k, set1(c_2piLo), x);
+  }
+
+  // vector equivalent of stevesch::closeMod2pi() (x within 2*pi of [-pi, pi])
+  inline vfloat closeMod2pi(vfloat x)
+  {
+    const vfloat pi = set1(3.1415926535897932384626433832795029f);
+    const vfloat twoPi = set1(6.28318530717958647692f);
+    x = select(x > pi, x - twoPi, x);
+    return select(x < -pi, x + twoPi, x);
+  }
+
+  // out[i] = f(in[i]) for i in [0, n), kWidth elements at a time, where f
+  // maps vfloat to vfloat.  The tail is processed through a padded block so
+  // every element gets exactly the same arithmetic.  'in' and 'out' may be
+  // the same buffer.
+  template <typename F>
+  inline void transform(const float* in, float* out, size_t n, F f)
+  {
+    size_t i = 0;
+    for (; i + kWidth <= n; i += kWidth) {
+      store(out + i, f(load(in + i)));
+    }
+    if (i < n) {
+      float tmp[kWidth] = {0.0f};
+      memcpy(tmp, in + i, (n - i) * sizeof(float));
+      store(tmp, f(load(tmp)));
+      memcpy(out + i, tmp, (n - i) * sizeof(float));
+    }
+  }
+
+} // namespace simd
+} // namespace stevesch
+
+#endif
@@ -0,0 +1,153 @@
+#include "spline.h"
+#include "simd.h"
+
+namespace stevesch
+{
+	BezierBatch::BezierBatch( uint32_t dimensions, uint32_t count ) :
+		mDimensions(dimensions), mCount(0), mStride(0)
+	{
+		resize(count);
+	}
+
+	void BezierBatch::resize( uint32_t count )
+	{
+		// whole vectors per array, so evaluate never reads past one, plus
+		// a 64-byte line so that arrays of a power-of-two size do not all
+		// start on the same cache sets (evaluate reads 4*dimensions at once)
+		const uint32_t width = simd::kWidth;
+		uint32_t stride = (count + width - 1) / width * width + 16;
+		if (stride != mStride)
+		{
+			std::vector<float> data(4 * mDimensions * stride, 0.0f);
+			uint32_t keep = (count < mCount) ? count : mCount;
+			for (uint32_t k=0; k<4 * mDimensions && keep > 0; ++k)
+			{
+				memcpy(&data[k * stride], &mData[k * mStride], keep * sizeof(float));
+			}
+			mData.swap(data);
+			mStride = stride;
+		}
+		else if (count < mCount)
+		{
+			// keep the padding zero
+			for (uint32_t k=0; k<4 * mDimensions; ++k)
+			{
+				memset(&mData[k * mStride + count], 0, (mCount - count) * sizeof(float));
+			}
+		}
+		mCount = count;
+	}
+
+	void BezierBatch::setCurve( uint32_t i, const float* pP0, const float* pT0, const float* pP1, const float* pT1 )
+	{
+		for (uint32_t d=0; d<mDimensions; ++d)
+		{
+			p0(d)[i] = pP0[d];
+			t0(d)[i] = pT0[d];
+			p1(d)[i] = pP1[d];
+			t1(d)[i] = pT1[d];
+		}
+	}
+
+	namespace
+	{
+		// Bernstein weights of p0, p1, t0 and t1 at t, as in T_GetBezierPoint
+		template <typename V>
+		inline void bezierWeights(V t, V one, V three, V& w0, V& w1, V& wa, V& wb)
+		{
+			V u = one - t;
+			V tt = t * t;
+			V uu = u * u;
+			wa = three * t * uu;
+			wb = -(three * tt * u);
+			w0 = u * uu + wa;
+			w1 = t * tt - wb;
+		}
+
+		// store the first n (< kWidth) lanes of v, for the tail of an array
+		inline void storePartial(float* pOut, simd::vfloat v, size_t n)
+		{
+			float tmp[simd::kWidth];
+			simd::store(tmp, v);
+			memcpy(pOut, tmp, n * sizeof(float));
+		}
+	}
+
+	void BezierBatch::evaluate( float t, float* pOut ) const
+	{
+		using namespace simd;
+		float sw0, sw1, swa, swb;
+		bezierWeights(t, 1.0f, 3.0f, sw0, sw1, swa, swb);
+		const vfloat w0 = set1(sw0);
+		const vfloat w1 = set1(sw1);
+		const vfloat wa = set1(swa);
+		const vfloat wb = set1(swb);
+
+		const size_t count = mCount;
+		const size_t whole = count / kWidth * kWidth;
+		for (uint32_t d=0; d<mDimensions; ++d)
+		{
+			const float* a = p0(d);
+			const float* ta = t0(d);
+			const float* b = p1(d);
+			const float* tb = t1(d);
+			float* out = pOut + d * count;
+			auto point = [&](size_t i) {
+				return madd(load(tb + i), wb, madd(load(ta + i), wa, madd(load(b + i), w1, load(a + i) * w0)));
+			};
+			for (size_t i=0; i<whole; i += kWidth)
+			{
+				store(out + i, point(i));
+			}
+			if (whole < count)
+			{
+				storePartial(out + whole, point(whole), count - whole);
+			}
+		}
+	}
+
+	void BezierBatch::evaluate( const float* pT, float* pOut ) const
+	{
+		using namespace simd;
+		const vfloat one = set1(1.0f);
+		const vfloat three = set1(3.0f);
+		const size_t count = mCount;
+		const uint32_t dimensions = mDimensions;
+		const size_t stride = mStride;
+		const float* data = mData.data();
+
+		// kWidth curves at t: every component
+		auto points = [&](size_t i, vfloat t, float* out, size_t n) {
+			vfloat w0, w1, wa, wb;
+			bezierWeights(t, one, three, w0, w1, wa, wb);
+			const float* a = data + i;
+			for (uint32_t d=0; d<dimensions; ++d, a += stride, out += count)
+			{
+				const float* ta = a + dimensions * stride;
+				const float* b = ta + dimensions * stride;
+				const float* tb = b + dimensions * stride;
+				vfloat v = madd(load(tb), wb, madd(load(ta), wa, madd(load(b), w1, load(a) * w0)));
+				if (n == (size_t)kWidth)
+				{
+					store(out, v);
+				}
+				else
+				{
+					storePartial(out, v, n);
+				}
+			}
+		};
+
+		const size_t whole = count / kWidth * kWidth;
+		for (size_t i=0; i<whole; i += kWidth)
+		{
+			points(i, load(pT + i), pOut + i, kWidth);
+		}
+		if (whole < count)
+		{
+			float tmp[kWidth] = {0.0f};
+			memcpy(tmp, pT + whole, (count - whole) * sizeof(float));
+			points(whole, load(tmp), pOut + whole, count - whole);
+		}
+	}
+}
@@ -1,38 +1,52 @@
 #ifndef STEVESCH_MATH_INTERNAL_SPLINE_H_
 #define STEVESCH_MATH_INTERNAL_SPLINE_H_
 
+#include <vector>
+#include "scalar.h"
+#include "vecN.h"
+
 namespace stevesch
 {
+  // Helpers used by the T_ functions below, for float and VecN<N> points
+  // (other vector types can provide the same overloads):
+  //   set(out, v)                   out = v
+  //   addScaled(out, v1, s1, v2, s2)  out = s1*v1 + s2*v2
+  //   addScaled(out, v1, v2, s2)      out = v1 + s2*v2
+  //   sub(out, v1, v2)              out = v1 - v2
+  //   scale(out, v, s)              out = s*v
+  // 'out' may be one of the inputs.
+
+  inline void set(float& vout, float v) { vout = v; }
+  inline void addScaled(float& vout, float v1, float s1, float v2, float s2) { vout = s1 * v1 + s2 * v2; }
+  inline void addScaled(float& vout, float v1, float v2, float s2) { vout = v1 + s2 * v2; }
+  inline void sub(float& vout, float v1, float v2) { vout = v1 - v2; }
+  inline void scale(float& vout, float v, float s) { vout = s * v; }
+
   template <int N>
-  void set(float vout[N], const float v[N]) {
-    for (int i=0; i<N; ++i) { vout[i] = v[i]; }
+  void set(VecN<N>& vout, const VecN<N>& v) {
+    vout = v;
   }
 
   template <int N>
-  void addScaled(float vout[N], const float v1[N], float s1, const float v2[N], float s2) {
-    float tmp[3];
-    for (int i=0; i<N; ++i) {
-      tmp[i] = s1 * v1[i] + s2 * v2[i];
+  void addScaled(VecN<N>& vout, const VecN<N>& v1, float s1, const VecN<N>& v2, float s2) {
+    for (int i=0; i<VecN<N>::kStorage; ++i) {
+      vout.v[i] = s1 * v1.v[i] + s2 * v2.v[i];
     }
-    vout = tmp;
   }
 
   template <int N>
-  void sub(float vout[N], const float v1[N], const float v2[N]) {
-    float tmp[N];
-    for (int i=0; i<N; ++i) {
-      tmp[i] = v1[i] - v2[i];
-    }
-    vout = tmp;
+  void addScaled(VecN<N>& vout, const VecN<N>& v1, const VecN<N>& v2, float s2) {
+    vout = madd(v1, v2, s2);
   }
 
   template <int N>
-  void scale(float vout[N], const float v[N], float s) {
-    float tmp[N];
-    for (int i=0; i<N; ++i) {
-      tmp[i] = s * v[i];
-    }
-    vout = tmp;
+  void sub(VecN<N>& vout, const VecN<N>& v1, const VecN<N>& v2) {
+    vout = v1 - v2;
+  }
+
+  template <int N>
+  void scale(VecN<N>& vout, const VecN<N>& v, float s) {
+    vout = v * s;
   }
 
 	//-----------------------------------------------------------------------------
@@ -86,7 +100,7 @@ namespace stevesch
 								T_VECTOR* pvPoint,		// out
 								T_VECTOR* pvTangent=0 )	// out
 	{
-		int p0 = ( t > 1.0 ) ? (int)floorf(t)-1 : nNumSpinePts-1;
+		int p0 = ( t >= 1.0f ) ? (int)floorf(t)-1 : nNumSpinePts-1;
 		int p1 = ( p0 < nNumSpinePts-1 ) ? p0 + 1 : 0;
 		int p2 = ( p1 < nNumSpinePts-1 ) ? p1 + 1 : 0;
 		int p3 = ( p2 < nNumSpinePts-1 ) ? p2 + 1 : 0;
@@ -102,9 +116,9 @@ namespace stevesch
 		if( pvTangent )
 		{
 			T_VECTOR v0;
-      T_VECTOR v1;
-			sub( v0, pSpline[p2] - pSpline[p0] );
-			sub( v1, pSpline[p3] - pSpline[p1] );
+			T_VECTOR v1;
+			sub( v0, pSpline[p2], pSpline[p0] );
+			sub( v1, pSpline[p3], pSpline[p1] );
 			float hu = 0.5f*u;
 			addScaled( *pvTangent, v0, (0.5f - hu),
 											 v1, hu );
@@ -160,6 +174,685 @@ namespace stevesch
 		addScaled( vPoint, vPoint, rTan0, ca );
 		addScaled( vPoint, vPoint, rTan1, cb );
 	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	// PiecewiseCubic is a curve made of cubic segments, each stored as the
+	// coefficients of its polynomial, so that evaluation is a single Horner
+	// step.  CatmullRomSpline and BezierCurve fill in the segments from
+	// their control points.
+	//
+	// t in [k, k+1) is segment k.  A closed curve wraps t into
+	// [0, segmentCount()); an open one clamps t to [0, segmentCount()].
+	// There must be at least one segment.  version() changes whenever the
+	// curve does (see ArcLengthTable::isStale).
+	//
+	// T needs T + T, T - T and T * float (e.g. float or a vector type).
+	template <typename T>
+	class PiecewiseCubic
+	{
+	protected:
+		// f(u) = ((a*u + b)*u + c)*u + d, u in [0, 1]
+		struct Segment
+		{
+			T a;
+			T b;
+			T c;
+			T d;
+		};
+
+		std::vector<Segment>	mSegments;
+		bool					mbClosed;
+		uint32_t				mVersion;
+
+		PiecewiseCubic( bool bClosed ) : mbClosed(bClosed), mVersion(0) {}
+
+		const Segment& findSegment(float t, float& u) const;
+
+	public:
+		uint32_t segmentCount() const	{ return (uint32_t)mSegments.size(); }
+		bool isClosed() const			{ return mbClosed; }
+		// t at the end of the curve (the number of segments)
+		float getEndParameter() const	{ return (float)mSegments.size(); }
+		uint32_t version() const		{ return mVersion; }
+
+		// point at t
+		T evaluate( float t ) const;
+		// derivative of the point with respect to t
+		T evaluateTangent( float t ) const;
+
+		// 'count' points at evenly spaced t from tBegin to tEnd (inclusive),
+		// by forward differencing within each segment: three additions per
+		// point instead of a polynomial evaluation.  The differences are
+		// restarted at each segment and every 64 points, which keeps the
+		// result within a few parts per million (of the size of the control
+		// points) of the exact curve.
+		void sample( float tBegin, float tEnd, uint32_t count, T* pOut ) const;
+	};
+
+	template <typename T>
+	const typename PiecewiseCubic<T>::Segment& PiecewiseCubic<T>::findSegment(float t, float& u) const
+	{
+		float n = (float)mSegments.size();
+		if (mbClosed)
+		{
+			if (t < 0.0f || t >= n)
+			{
+				t -= n * floorf(t / n);
+			}
+		}
+		else
+		{
+			t = clampf(t, 0.0f, n);
+		}
+		uint32_t k = (uint32_t)t;
+		if (k >= mSegments.size())
+		{
+			k = (uint32_t)mSegments.size() - 1;	// t == n (open end, or rounding when wrapping)
+		}
+		u = t - (float)k;
+		return mSegments[k];
+	}
+
+	template <typename T>
+	T PiecewiseCubic<T>::evaluate( float t ) const
+	{
+		float u;
+		const Segment& s = findSegment(t, u);
+		return ((s.a * u + s.b) * u + s.c) * u + s.d;
+	}
+
+	template <typename T>
+	T PiecewiseCubic<T>::evaluateTangent( float t ) const
+	{
+		float u;
+		const Segment& s = findSegment(t, u);
+		return (s.a * (3.0f * u) + s.b * 2.0f) * u + s.c;
+	}
+
+	template <typename T>
+	void PiecewiseCubic<T>::sample( float tBegin, float tEnd, uint32_t count, T* pOut ) const
+	{
+		if (count == 0)
+		{
+			return;
+		}
+		if (count == 1)
+		{
+			pOut[0] = evaluate(tBegin);
+			return;
+		}
+
+		const float h = (tEnd - tBegin) / (float)(count - 1);
+		const float n = (float)mSegments.size();
+		uint32_t i = 0;
+		while (i < count)
+		{
+			float t = tBegin + (float)i * h;
+			if (!mbClosed && (t < 0.0f || t >= n))
+			{
+				pOut[i++] = evaluate(t);	// clamped to an end point
+				continue;
+			}
+
+			float u;
+			const Segment& s = findSegment(t, u);
+
+			// number of samples, starting with this one, that stay in this
+			// segment; long runs are split so that rounding cannot build up
+			const float kMaxRun = 64.0f;
+			uint32_t run = count - i;
+			float r = (h > 0.0f) ? ceilf((1.0f - u) / h) : ((h < 0.0f) ? (floorf(u / -h) + 1.0f) : (float)run);
+			r = (r < kMaxRun) ? r : kMaxRun;
+			if (r < (float)run)
+			{
+				run = (r > 1.0f) ? (uint32_t)r : 1;
+			}
+
+			// f and its first three forward differences at u, for step h
+			T f = ((s.a * u + s.b) * u + s.c) * u + s.d;
+			T d3 = s.a * (6.0f * h * h * h);
+			T d2 = (s.a * (3.0f * u + 3.0f * h) + s.b) * (2.0f * h * h);
+			T d1 = ((s.a * (3.0f * u * u + 3.0f * u * h + h * h)) + s.b * (2.0f * u + h) + s.c) * h;
+			pOut[i++] = f;
+			for (uint32_t j=1; j<run; ++j)
+			{
+				f = f + d1;
+				d1 = d1 + d2;
+				d2 = d2 + d3;
+				pOut[i++] = f;
+			}
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	// CatmullRomSpline holds the control points of a Catmull-Rom spline and
+	// caches the cubic coefficients of each segment, so that evaluation
+	// does not rebuild them from four control points on every call
+	// (T_EvaluateCatmullRom).  setPoint recomputes only the four segments
+	// that the moved point influences (index-2 .. index+1).
+	//
+	// The parameterization matches T_GetSplinePoint: t in [k, k+1) runs
+	// from point k to point k+1.  A closed spline of n points has n segments
+	// and wraps t into [0, n); an open one has n-1 segments, clamps t to
+	// [0, n-1] and repeats its end points as their own outer neighbours.
+	// An open spline needs at least two points, a closed one at least one.
+	template <typename T>
+	class CatmullRomSpline : public PiecewiseCubic<T>
+	{
+		typedef PiecewiseCubic<T> base_t;
+		typedef typename base_t::Segment Segment;
+
+		std::vector<T>	mPoints;
+
+		uint32_t pointIndex(int32_t i) const;
+		void updateSegment(uint32_t k);
+
+	public:
+		CatmullRomSpline( bool bClosed=true ) : base_t(bClosed) {}
+		CatmullRomSpline( const T* pPoints, uint32_t count, bool bClosed=true ) : base_t(bClosed)
+		{
+			setPoints(pPoints, count);
+		}
+
+		// replace all control points and rebuild every segment
+		void setPoints( const T* pPoints, uint32_t count );
+		// move one control point, updating the segments it influences
+		void setPoint( uint32_t index, const T& p );
+
+		const T& getPoint( uint32_t index ) const	{ return mPoints[index]; }
+		uint32_t pointCount() const		{ return (uint32_t)mPoints.size(); }
+	};
+
+	template <typename T>
+	uint32_t CatmullRomSpline<T>::pointIndex(int32_t i) const
+	{
+		int32_t n = (int32_t)mPoints.size();
+		if (this->mbClosed)
+		{
+			// i is in [-1, n+1] (segment neighbours)
+			i += (i < 0) ? n : 0;
+			while (i >= n)
+			{
+				i -= n;
+			}
+			return (uint32_t)i;
+		}
+		return (uint32_t)((i < 0) ? 0 : ((i >= n) ? (n - 1) : i));
+	}
+
+	template <typename T>
+	void CatmullRomSpline<T>::updateSegment(uint32_t k)
+	{
+		const T& p0 = mPoints[pointIndex((int32_t)k - 1)];
+		const T& p1 = mPoints[pointIndex((int32_t)k)];
+		const T& p2 = mPoints[pointIndex((int32_t)k + 1)];
+		const T& p3 = mPoints[pointIndex((int32_t)k + 2)];
+
+		// 0.5 * (-p0 + 3*p1 - 3*p2 + p3, 2*p0 - 5*p1 + 4*p2 - p3, -p0 + p2, 2*p1)
+		Segment& s = this->mSegments[k];
+		s.a = (p3 - p0) * 0.5f + (p1 - p2) * 1.5f;
+		s.b = p0 + p2 * 2.0f - (p1 * 5.0f + p3) * 0.5f;
+		s.c = (p2 - p0) * 0.5f;
+		s.d = p1;
+	}
+
+	template <typename T>
+	void CatmullRomSpline<T>::setPoints( const T* pPoints, uint32_t count )
+	{
+		mPoints.assign(pPoints, pPoints + count);
+		uint32_t segments = this->mbClosed ? count : ((count > 0) ? (count - 1) : 0);
+		this->mSegments.resize(segments);
+		for (uint32_t k=0; k<segments; ++k)
+		{
+			updateSegment(k);
+		}
+		++this->mVersion;
+	}
+
+	template <typename T>
+	void CatmullRomSpline<T>::setPoint( uint32_t index, const T& p )
+	{
+		mPoints[index] = p;
+		++this->mVersion;
+		int32_t segments = (int32_t)this->mSegments.size();
+		if (this->mbClosed && segments < 4)
+		{
+			for (int32_t k=0; k<segments; ++k)
+			{
+				updateSegment((uint32_t)k);
+			}
+			return;
+		}
+		// segment k depends on points k-1 .. k+2
+		for (int32_t k=(int32_t)index - 2; k<=(int32_t)index + 1; ++k)
+		{
+			if (this->mbClosed)
+			{
+				updateSegment((uint32_t)((k + segments) % segments));
+			}
+			else if (k >= 0 && k < segments)
+			{
+				updateSegment((uint32_t)k);
+			}
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	// BezierCurve is a chain of cubic Bezier segments through a list of
+	// knots, each a point and a tangent.  As in T_GetBezierPoint, segment k
+	// runs from point[k] to point[k+1] with inner control points
+	// point[k] + tangent[k] and point[k+1] - tangent[k+1], so the curve is
+	// C1 at the knots.  A closed curve of n knots has n segments (the last
+	// returns to knot 0), an open one n-1.  setKnot recomputes the two
+	// segments next to the knot (index-1 and index).
+	template <typename T>
+	class BezierCurve : public PiecewiseCubic<T>
+	{
+		typedef PiecewiseCubic<T> base_t;
+		typedef typename base_t::Segment Segment;
+
+		std::vector<T>	mPoints;
+		std::vector<T>	mTangents;
+
+		void updateSegment(uint32_t k);
+
+	public:
+		BezierCurve( bool bClosed=false ) : base_t(bClosed) {}
+		BezierCurve( const T* pPoints, const T* pTangents, uint32_t count, bool bClosed=false ) : base_t(bClosed)
+		{
+			setKnots(pPoints, pTangents, count);
+		}
+
+		// replace all knots and rebuild every segment
+		void setKnots( const T* pPoints, const T* pTangents, uint32_t count );
+		// move one knot, updating the segments next to it
+		void setKnot( uint32_t index, const T& point, const T& tangent );
+
+		const T& getPoint( uint32_t index ) const	{ return mPoints[index]; }
+		const T& getTangent( uint32_t index ) const	{ return mTangents[index]; }
+		uint32_t knotCount() const		{ return (uint32_t)mPoints.size(); }
+	};
+
+	template <typename T>
+	void BezierCurve<T>::updateSegment(uint32_t k)
+	{
+		uint32_t k1 = (k + 1 < mPoints.size()) ? (k + 1) : 0;
+		const T& p0 = mPoints[k];
+		const T& p1 = mPoints[k1];
+		const T& t0 = mTangents[k];
+		const T& t1 = mTangents[k1];
+
+		// Bernstein form with control points p0, p0 + t0, p1 - t1, p1:
+		// a = 2*(p0 - p1) + 3*(t0 + t1), b = 3*(p1 - p0) - 6*t0 - 3*t1, c = 3*t0
+		Segment& s = this->mSegments[k];
+		s.a = (p0 - p1) * 2.0f + (t0 + t1) * 3.0f;
+		s.b = (p1 - p0) * 3.0f - (t0 * 2.0f + t1) * 3.0f;
+		s.c = t0 * 3.0f;
+		s.d = p0;
+	}
+
+	template <typename T>
+	void BezierCurve<T>::setKnots( const T* pPoints, const T* pTangents, uint32_t count )
+	{
+		mPoints.assign(pPoints, pPoints + count);
+		mTangents.assign(pTangents, pTangents + count);
+		uint32_t segments = this->mbClosed ? count : ((count > 0) ? (count - 1) : 0);
+		this->mSegments.resize(segments);
+		for (uint32_t k=0; k<segments; ++k)
+		{
+			updateSegment(k);
+		}
+		++this->mVersion;
+	}
+
+	template <typename T>
+	void BezierCurve<T>::setKnot( uint32_t index, const T& point, const T& tangent )
+	{
+		mPoints[index] = point;
+		mTangents[index] = tangent;
+		++this->mVersion;
+		uint32_t segments = (uint32_t)this->mSegments.size();
+		if (index < segments)
+		{
+			updateSegment(index);
+		}
+		uint32_t prev = (index > 0) ? (index - 1) : (this->mbClosed ? (segments - 1) : segments);
+		if (prev < segments && prev != index)
+		{
+			updateSegment(prev);
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	// Default length of a curve derivative for ArcLengthTable: fabsf for
+	// float, otherwise length(v), found by argument-dependent lookup (i.e.
+	// declared next to the vector type).
+	struct ArcLengthNorm
+	{
+		float operator()(float v) const { return fabsf(v); }
+		template <typename T>
+		float operator()(const T& v) const { return length(v); }
+	};
+
+	// ArcLengthTable maps distance along a curve (e.g. a CatmullRomSpline or
+	// BezierCurve) to its parameter t and back, for motion at constant
+	// speed.  Each segment is split into 'subdivisions' equal steps of t
+	// whose lengths, Lw = integral of |w'(t)| dt, are found by 5-point
+	// Gauss-Legendre quadrature.  Between those points t(s) is interpolated
+	// by a monotone cubic using the speed |w'(t)| at both ends, and a bucket
+	// index over distance finds the step for a given s in O(1) (a couple of
+	// comparisons) rather than by binary search.
+	//
+	// Each step costs 16 bytes: its start distance, length, speed and
+	// bucket (the lengths let rebuildSegments re-sum distances from the
+	// first changed step without differencing rounded distances).  With the
+	// default 8 steps per segment, parameterAt(s) is typically within 1e-3
+	// (in t) of the exact inverse, and the error falls about 16x each time
+	// the subdivisions double; the form that also takes the curve refines
+	// the result by a Newton step.
+	//
+	// The table does not follow the curve: after the curve changes, call
+	// build again, or rebuildSegments for just the segments that changed
+	// (after CatmullRomSpline::setPoint(i), segments i-2 .. i+1; after
+	// BezierCurve::setKnot(i), segments i-1 .. i).  first may be negative or
+	// past the end: it is taken modulo the segment count, as on a closed curve.
+	// isStale tells whether the curve has changed since.
+	//
+	// Curve needs segmentCount(), evaluateTangent(t) and version().
+	template <typename Norm = ArcLengthNorm>
+	class ArcLengthTable
+	{
+		std::vector<float>		mLength;	// distance at the start of each step, plus the total
+		std::vector<float>		mStep;		// length of each step
+		std::vector<float>		mSpeed;		// |w'(t)| at the start of each step, plus at the end
+		std::vector<uint32_t>	mBucket;	// mBucket[j]: step containing distance j / mBucketScale
+		float		mBucketScale;
+		uint32_t	mSubdivisions;
+		uint32_t	mVersion;
+		Norm		mNorm;
+
+		template <typename Curve>
+		float integrate(const Curve& curve, float t0, float t1) const;
+		template <typename Curve>
+		void measureSegment(const Curve& curve, uint32_t k);
+		void accumulate(uint32_t first);
+
+	public:
+		ArcLengthTable( uint32_t subdivisions=8, Norm norm=Norm() ) : mBucketScale(0.0f),
+			mSubdivisions(subdivisions > 0 ? subdivisions : 1), mVersion(0), mNorm(norm)
+		{
+		}
+
+		template <typename Curve>
+		void build( const Curve& curve );
+		// re-measure segments [first, first + count) (modulo the segment count)
+		// after the curve changed there
+		template <typename Curve>
+		void rebuildSegments( const Curve& curve, int32_t first, uint32_t count );
+		template <typename Curve>
+		bool isStale( const Curve& curve ) const	{ return curve.version() != mVersion; }
+
+		float getLength() const		{ return mLength.empty() ? 0.0f : mLength.back(); }
+
+		// t at distance s from the start, s clamped to [0, getLength()]
+		float parameterAt( float s ) const;
+		// the same, refined by a Newton step that measures the curve itself
+		// (6 evaluations of its tangent): typically 30x more accurate
+		template <typename Curve>
+		float parameterAt( const Curve& curve, float s ) const;
+		// distance from the start to t, t clamped to [0, segment count]
+		float distanceAt( float t ) const;
+	};
+
+	// length of the curve from t0 to t1 (within one segment)
+	template <typename Norm>
+	template <typename Curve>
+	float ArcLengthTable<Norm>::integrate(const Curve& curve, float t0, float t1) const
+	{
+		// 5-point Gauss-Legendre nodes on [-1, 1] and weights
+		static const float kNode[5] = { -0.906179846f, -0.538469310f, 0.0f, 0.538469310f, 0.906179846f };
+		static const float kWeight[5] = { 0.236926885f, 0.478628670f, 0.568888889f, 0.478628670f, 0.236926885f };
+
+		float half = 0.5f * (t1 - t0);
+		float mid = t0 + half;
+		float sum = 0.0f;
+		for (int q=0; q<5; ++q)
+		{
+			sum += kWeight[q] * mNorm(curve.evaluateTangent(mid + half * kNode[q]));
+		}
+		return half * sum;
+	}
+
+	template <typename Norm>
+	template <typename Curve>
+	void ArcLengthTable<Norm>::measureSegment(const Curve& curve, uint32_t k)
+	{
+		const float h = 1.0f / (float)mSubdivisions;
+		for (uint32_t j=0; j<mSubdivisions; ++j)
+		{
+			uint32_t i = k * mSubdivisions + j;
+			float t0 = (float)k + (float)j * h;
+			mStep[i] = integrate(curve, t0, (j + 1 < mSubdivisions) ? (t0 + h) : (float)(k + 1));
+			mSpeed[i] = mNorm(curve.evaluateTangent(t0));
+		}
+	}
+
+	// sum the step lengths from step 'first' on, and re-index the buckets
+	template <typename Norm>
+	void ArcLengthTable<Norm>::accumulate(uint32_t first)
+	{
+		uint32_t steps = (uint32_t)mStep.size();
+		double s = (first > 0) ? (double)mLength[first] : 0.0;
+		for (uint32_t i=first; i<steps; ++i)
+		{
+			mLength[i] = (float)s;
+			s += mStep[i];
+		}
+		mLength[steps] = (float)s;
+
+		// one bucket per step; bucket j starts at distance j / mBucketScale.
+		// The step holding bucket j is the number of steps that end at or
+		// before it, so count where each step ends and take a prefix sum
+		// (no data-dependent branches, unlike walking both lists).
+		mBucketScale = (s > 0.0) ? (float)((double)steps / s) : 0.0f;
+		mBucket.assign(steps + 1, 0);
+		for (uint32_t i=0; i+1<steps; ++i)
+		{
+			// first bucket past the end of step i (floor + 1 is one late
+			// where they meet exactly; parameterAt steps forward there)
+			float end = mLength[i + 1] * mBucketScale + 1.0f;
+			++mBucket[(end < (float)steps) ? (uint32_t)end : steps];
+		}
+		for (uint32_t j=1; j<steps; ++j)
+		{
+			mBucket[j] += mBucket[j - 1];
+		}
+	}
+
+	template <typename Norm>
+	template <typename Curve>
+	void ArcLengthTable<Norm>::build( const Curve& curve )
+	{
+		uint32_t segments = curve.segmentCount();
+		uint32_t steps = segments * mSubdivisions;
+		mStep.resize(steps);
+		mLength.resize(steps + 1);
+		mSpeed.resize(steps + 1);
+		for (uint32_t k=0; k<segments; ++k)
+		{
+			measureSegment(curve, k);
+		}
+		mSpeed[steps] = mNorm(curve.evaluateTangent((float)segments));
+		accumulate(0);
+		mVersion = curve.version();
+	}
+
+	template <typename Norm>
+	template <typename Curve>
+	void ArcLengthTable<Norm>::rebuildSegments( const Curve& curve, int32_t first, uint32_t count )
+	{
+		uint32_t segments = curve.segmentCount();
+		if (mStep.size() != (size_t)segments * mSubdivisions)
+		{
+			build(curve);	// the number of segments changed
+			return;
+		}
+		if (count == 0 || segments == 0)
+		{
+			return;
+		}
+		int32_t start = first % (int32_t)segments;
+		uint32_t begin = (uint32_t)((start < 0) ? start + (int32_t)segments : start);
+		for (uint32_t c=0; c<count && c<segments; ++c)
+		{
+			measureSegment(curve, (begin + c) % segments);
+		}
+		mSpeed[segments * mSubdivisions] = mNorm(curve.evaluateTangent((float)segments));
+		// distances before the first changed segment still hold
+		bool bWrapped = (count >= segments) || (count > segments - begin);
+		accumulate(bWrapped ? 0 : begin * mSubdivisions);
+		mVersion = curve.version();
+	}
+
+	template <typename Norm>
+	float ArcLengthTable<Norm>::parameterAt( float s ) const
+	{
+		uint32_t steps = (uint32_t)mStep.size();
+		if (steps == 0 || s <= 0.0f)
+		{
+			return 0.0f;
+		}
+		const float h = 1.0f / (float)mSubdivisions;
+		if (s >= mLength[steps])
+		{
+			return (float)steps * h;
+		}
+
+		uint32_t j = (uint32_t)(s * mBucketScale);
+		uint32_t i = mBucket[(j < steps) ? j : (steps - 1)];
+		while (i > 0 && mLength[i] > s)
+		{
+			--i;	// j / mBucketScale rounded above s
+		}
+		while (i + 1 < steps && mLength[i + 1] <= s)
+		{
+			++i;
+		}
+
+		float ds = mStep[i];
+		float t0 = (float)i * h;
+		if (ds <= 0.0f)
+		{
+			return t0;
+		}
+		// cubic Hermite for t(s) over the step, in units of the step: slopes
+		// dt/ds = 1/speed, limited to 3 (Fritsch-Carlson) to stay monotone
+		float x = (s - mLength[i]) / ds;
+		float scale = ds / h;
+		float m0 = (mSpeed[i] * 3.0f > scale) ? (scale / mSpeed[i]) : 3.0f;
+		float m1 = (mSpeed[i + 1] * 3.0f > scale) ? (scale / mSpeed[i + 1]) : 3.0f;
+		float y = x + x * (1.0f - x) * ((m0 - 1.0f) * (1.0f - x) - (m1 - 1.0f) * x);
+		return t0 + y * h;
+	}
+
+	template <typename Norm>
+	template <typename Curve>
+	float ArcLengthTable<Norm>::parameterAt( const Curve& curve, float s ) const
+	{
+		float t = parameterAt(s);
+		uint32_t steps = (uint32_t)mStep.size();
+		if (steps == 0 || s <= 0.0f || s >= mLength[steps])
+		{
+			return t;
+		}
+		uint32_t i = (uint32_t)(t * (float)mSubdivisions);
+		i = (i < steps) ? i : (steps - 1);
+		float t0 = (float)i / (float)mSubdivisions;
+		float speed = mNorm(curve.evaluateTangent(t));
+		if (speed > 0.0f)
+		{
+			// Newton step on length(t) = s, measured from the start of t's step
+			t -= (mLength[i] + integrate(curve, t0, t) - s) / speed;
+		}
+		return t;
+	}
+
+	template <typename Norm>
+	float ArcLengthTable<Norm>::distanceAt( float t ) const
+	{
+		uint32_t steps = (uint32_t)mStep.size();
+		if (steps == 0 || t <= 0.0f)
+		{
+			return 0.0f;
+		}
+		float x = t * (float)mSubdivisions;
+		if (x >= (float)steps)
+		{
+			return mLength[steps];
+		}
+		uint32_t i = (uint32_t)x;
+		x -= (float)i;
+
+		// cubic Hermite for s(t) over the step, slopes ds/dt = speed
+		const float h = 1.0f / (float)mSubdivisions;
+		float ds = mStep[i];
+		float m0 = (ds > 0.0f) ? fminf(mSpeed[i] * h / ds, 3.0f) : 0.0f;
+		float m1 = (ds > 0.0f) ? fminf(mSpeed[i + 1] * h / ds, 3.0f) : 0.0f;
+		float y = x + x * (1.0f - x) * ((m0 - 1.0f) * (1.0f - x) - (m1 - 1.0f) * x);
+		return mLength[i] + y * ds;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	// BezierBatch holds many independent cubic Bezier curves (p0, t0, p1, t1
+	// as in T_GetBezierPoint) as structure-of-arrays: one array per
+	// component of each control, e.g. p0(0)[i] is x of p0 of curve i.  The
+	// evaluate functions work on kWidth curves at a time (4 or 8, see
+	// simd.h) and write the point of every curve, component by component:
+	// out[d*size() + i] is component d of curve i.
+	//
+	// For a shared t the four Bernstein weights are computed once, leaving
+	// three multiply-adds per component and curve.
+	class BezierBatch
+	{
+		std::vector<float>	mData;		// 4*dimensions arrays of mStride floats (zero padded)
+		uint32_t	mDimensions;
+		uint32_t	mCount;
+		uint32_t	mStride;
+
+		float* plane(uint32_t control, uint32_t d)	{ return &mData[(control * mDimensions + d) * mStride]; }
+		const float* plane(uint32_t control, uint32_t d) const	{ return &mData[(control * mDimensions + d) * mStride]; }
+
+	public:
+		explicit BezierBatch( uint32_t dimensions=3, uint32_t count=0 );
+
+		// change the number of curves, keeping the first min(count, size()) of them
+		void resize( uint32_t count );
+		uint32_t size() const			{ return mCount; }
+		uint32_t dimensions() const		{ return mDimensions; }
+
+		// component d of each control, size() floats
+		float* p0( uint32_t d )			{ return plane(0, d); }
+		float* t0( uint32_t d )			{ return plane(1, d); }
+		float* p1( uint32_t d )			{ return plane(2, d); }
+		float* t1( uint32_t d )			{ return plane(3, d); }
+		const float* p0( uint32_t d ) const	{ return plane(0, d); }
+		const float* t0( uint32_t d ) const	{ return plane(1, d); }
+		const float* p1( uint32_t d ) const	{ return plane(2, d); }
+		const float* t1( uint32_t d ) const	{ return plane(3, d); }
+
+		// set curve i from 'dimensions' floats per control (e.g. VecN<N>::v)
+		void setCurve( uint32_t i, const float* pP0, const float* pT0, const float* pP1, const float* pT1 );
+
+		// every curve at the same t; pOut holds dimensions()*size() floats
+		void evaluate( float t, float* pOut ) const;
+		// curve i at pT[i]
+		void evaluate( const float* pT, float* pOut ) const;
+	};
 }
 
 #endif
@@ -0,0 +1,536 @@
+#include "statistics.h"
+#include "simd.h"
+#include <float.h>
+
+namespace stevesch
+{
+	namespace
+	{
+		// values per block of the batch push functions
+		const size_t kBlock = 1024;
+
+		inline float sumLanes(simd::vfloat v)
+		{
+			float lanes[simd::kWidth];
+			simd::store(lanes, v);
+			float sum = 0.0f;
+			for (int i=0; i<simd::kWidth; ++i)
+			{
+				sum += lanes[i];
+			}
+			return sum;
+		}
+
+		// f(block) over p[0, n) a vector at a time; the last, partial vector
+		// is padded with 'pad'
+		template <typename F>
+		inline void forEachVector(const float* p, size_t n, float pad, F f)
+		{
+			using namespace simd;
+			size_t i = 0;
+			for (; i + kWidth <= n; i += kWidth)
+			{
+				f(load(p + i));
+			}
+			if (i < n)
+			{
+				float tmp[kWidth];
+				for (int k=0; k<kWidth; ++k)
+				{
+					tmp[k] = pad;
+				}
+				memcpy(tmp, p + i, (n - i) * sizeof(float));
+				f(load(tmp));
+			}
+		}
+
+		inline float blockMean(const float* p, size_t n)
+		{
+			using namespace simd;
+			vfloat sum = set1(0.0f);
+			forEachVector(p, n, 0.0f, [&](vfloat x) { sum = sum + x; });
+			return sumLanes(sum) / (float)n;
+		}
+	}
+
+	void MeanVariance::push( const float* p, size_t n )
+	{
+		using namespace simd;
+		for (size_t i=0; i<n; i += kBlock)
+		{
+			size_t m = (n - i < kBlock) ? (n - i) : kBlock;
+			const float* block = p + i;
+			float c = blockMean(block, m);
+
+			// sums of differences from c (the first corrects for rounding in c)
+			const vfloat vc = set1(c);
+			vfloat s1 = set1(0.0f);
+			vfloat s2 = set1(0.0f);
+			forEachVector(block, m, c, [&](vfloat x) {
+				vfloat d = x - vc;
+				s1 = s1 + d;
+				s2 = madd(d, d, s2);
+			});
+			float fm = (float)m;
+			float d1 = sumLanes(s1) / fm;
+
+			MeanVariance b;
+			b.mnCount = (uint32_t)m;
+			b.mfShift = c;
+			b.mfMean = d1;
+			b.mfM2 = fmaxf(sumLanes(s2) - fm * d1 * d1, 0.0f);
+			merge(b);
+		}
+	}
+
+	void MeanVariance::merge( const MeanVariance& other )
+	{
+		if (other.mnCount == 0)
+		{
+			return;
+		}
+		if (mnCount == 0)
+		{
+			*this = other;
+			return;
+		}
+		float na = (float)mnCount;
+		float nb = (float)other.mnCount;
+		float n = na + nb;
+		float d = (other.mfShift - mfShift) + (other.mfMean - mfMean);
+		mfMean += d * (nb / n);
+		mfM2 += other.mfM2 + d * d * (na * nb / n);
+		mnCount += other.mnCount;
+	}
+
+	void Moments::push( const float* p, size_t n )
+	{
+		using namespace simd;
+		for (size_t i=0; i<n; i += kBlock)
+		{
+			size_t m = (n - i < kBlock) ? (n - i) : kBlock;
+			const float* block = p + i;
+			float c = blockMean(block, m);
+
+			const vfloat vc = set1(c);
+			vfloat s1 = set1(0.0f);
+			vfloat s2 = set1(0.0f);
+			vfloat s3 = set1(0.0f);
+			vfloat s4 = set1(0.0f);
+			forEachVector(block, m, c, [&](vfloat x) {
+				vfloat d = x - vc;
+				vfloat d2 = d * d;
+				s1 = s1 + d;
+				s2 = s2 + d2;
+				s3 = madd(d2, d, s3);
+				s4 = madd(d2, d2, s4);
+			});
+
+			// moments about c, shifted to the block's mean c + e
+			float fm = (float)m;
+			float e = sumLanes(s1) / fm;
+			float t2 = sumLanes(s2);
+			float t3 = sumLanes(s3);
+			float t4 = sumLanes(s4);
+			float e2 = e * e;
+
+			Moments b;
+			b.mnCount = (uint32_t)m;
+			b.mfShift = c;
+			b.mfMean = e;
+			b.mfM2 = fmaxf(t2 - fm * e2, 0.0f);
+			b.mfM3 = t3 - 3.0f * e * t2 + 2.0f * fm * e2 * e;
+			b.mfM4 = fmaxf(t4 - 4.0f * e * t3 + 6.0f * e2 * t2 - 3.0f * fm * e2 * e2, 0.0f);
+			merge(b);
+		}
+	}
+
+	void Moments::merge( const Moments& other )
+	{
+		if (other.mnCount == 0)
+		{
+			return;
+		}
+		if (mnCount == 0)
+		{
+			*this = other;
+			return;
+		}
+		float na = (float)mnCount;
+		float nb = (float)other.mnCount;
+		float n = na + nb;
+		float d = (other.mfShift - mfShift) + (other.mfMean - mfMean);
+		float dn = d / n;
+		float dn2 = dn * dn;
+		float nanb = na * nb;
+
+		float m2 = mfM2 + other.mfM2 + d * dn * nanb;
+		float m3 = mfM3 + other.mfM3 + d * dn2 * nanb * (na - nb)
+			+ 3.0f * dn * (na * other.mfM2 - nb * mfM2);
+		float m4 = mfM4 + other.mfM4 + d * dn2 * dn * nanb * (na*na - nanb + nb*nb)
+			+ 6.0f * dn2 * (na*na * other.mfM2 + nb*nb * mfM2)
+			+ 4.0f * dn * (na * other.mfM3 - nb * mfM3);
+
+		mfMean += dn * nb;
+		mfM2 = m2;
+		mfM3 = m3;
+		mfM4 = m4;
+		mnCount += other.mnCount;
+	}
+
+	void MinMax::push( const float* p, size_t n )
+	{
+		using namespace simd;
+		if (n == 0)
+		{
+			return;
+		}
+		vfloat lo = set1(mfMin);
+		vfloat hi = set1(mfMax);
+		forEachVector(p, n, p[0], [&](vfloat x) {
+			lo = vmin(lo, x);
+			hi = vmax(hi, x);
+		});
+		float lanesLo[kWidth];
+		float lanesHi[kWidth];
+		store(lanesLo, lo);
+		store(lanesHi, hi);
+		for (int k=0; k<kWidth; ++k)
+		{
+			mfMin = (lanesLo[k] < mfMin) ? lanesLo[k] : mfMin;
+			mfMax = (lanesHi[k] > mfMax) ? lanesHi[k] : mfMax;
+		}
+		mnCount += (uint32_t)n;
+	}
+
+	void MinMax::merge( const MinMax& other )
+	{
+		mnCount += other.mnCount;
+		mfMin = (other.mfMin < mfMin) ? other.mfMin : mfMin;
+		mfMax = (other.mfMax > mfMax) ? other.mfMax : mfMax;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	namespace
+	{
+		// smallest magnitude given a bucket; below it values count as 0
+		const float kMinIndexable = 1.17549435e-38f;	// smallest normal float
+		const uint32_t kOneBits = 0x3f800000;			// bits of 1.0f
+	}
+
+	QuantileSketch::QuantileSketch( float relativeAccuracy, uint32_t maxBins ) :
+		mnZeroCount(0), mnPositiveInfinity(0), mnNegativeInfinity(0), mnCount(0), mfMin(0.0f), mfMax(0.0f),
+		mfRelativeAccuracy(relativeAccuracy), mnMaxBins(maxBins > 0 ? maxBins : 1)
+	{
+		// buckets span a factor gamma; within a binade the mapping's log2
+		// is linear in the mantissa, whose natural log grows at most 1:1
+		// with it, so a bucket of width 1/mMultiplier spans at most gamma
+		double gamma = (1.0 + relativeAccuracy) / (1.0 - relativeAccuracy);
+		mfMultiplier = (float)(1.0 / log(gamma));
+	}
+
+	void QuantileSketch::clear()
+	{
+		mPositive = Store();
+		mNegative = Store();
+		mnZeroCount = 0;
+		mnPositiveInfinity = 0;
+		mnNegativeInfinity = 0;
+		mnCount = 0;
+		mfMin = 0.0f;
+		mfMax = 0.0f;
+	}
+
+	// ceil(L * multiplier), L = exponent + (mantissa - 1), i.e. a log2
+	// that is exact at powers of two and linear in between
+	int32_t QuantileSketch::bucketIndex( float magnitude ) const
+	{
+		float l = (float)((int32_t)simd::floatBits(magnitude) - (int32_t)kOneBits) * (1.0f / 8388608.0f);
+		return (int32_t)ceilf(l * mfMultiplier);
+	}
+
+	// the value with the same relative distance to both bounds of the bucket;
+	// computed in double, as the upper bound of the top buckets is beyond
+	// the float range
+	float QuantileSketch::bucketValue( int32_t index ) const
+	{
+		double l = (double)(index - 1) / mfMultiplier;
+		double e = floor(l);
+		double lo = ldexp(1.0 + (l - e), (int)e);
+		l = (double)index / mfMultiplier;
+		e = floor(l);
+		double hi = ldexp(1.0 + (l - e), (int)e);
+		double value = 2.0 * lo * (hi / (lo + hi));
+		return (value < (double)FLT_MAX) ? (float)value : FLT_MAX;
+	}
+
+	int32_t QuantileSketch::Store::extend( int32_t lo, int32_t hi, uint32_t maxBins )
+	{
+		if (mCounts.empty())
+		{
+			if ((int64_t)hi - lo >= (int64_t)maxBins)
+			{
+				lo = hi - (int32_t)maxBins + 1;
+			}
+			mOffset = lo;
+			mCounts.assign((size_t)(hi - lo + 1), 0);
+			return mOffset;
+		}
+
+		int32_t end = mOffset + (int32_t)mCounts.size();	// one past the highest index
+		int32_t newLo = (lo < mOffset) ? lo : mOffset;
+		int32_t newEnd = (hi >= end) ? (hi + 1) : end;
+		if ((int64_t)newEnd - newLo > (int64_t)maxBins)
+		{
+			newLo = newEnd - (int32_t)maxBins;
+		}
+		if (newLo == mOffset && newEnd == end)
+		{
+			return mOffset;
+		}
+
+		std::vector<uint64_t> counts((size_t)(newEnd - newLo), 0);
+		for (size_t i=0; i<mCounts.size(); ++i)
+		{
+			// buckets below the new range are combined into its lowest
+			int32_t index = mOffset + (int32_t)i;
+			counts[(index < newLo) ? 0 : (size_t)(index - newLo)] += mCounts[i];
+		}
+		mCounts.swap(counts);
+		mOffset = newLo;
+		return mOffset;
+	}
+
+	void QuantileSketch::Store::add( int32_t index, uint64_t count, uint32_t maxBins )
+	{
+		int32_t lo = extend(index, index, maxBins);
+		mCounts[(index < lo) ? 0 : (size_t)(index - lo)] += count;
+	}
+
+	void QuantileSketch::add( float x )
+	{
+		mfMin = (mnCount == 0 || x < mfMin) ? x : mfMin;
+		mfMax = (mnCount == 0 || x > mfMax) ? x : mfMax;
+		++mnCount;
+
+		float magnitude = fabsf(x);
+		if (!(magnitude >= kMinIndexable))
+		{
+			++mnZeroCount;
+		}
+		else if (!(magnitude <= FLT_MAX))
+		{
+			++((x > 0.0f) ? mnPositiveInfinity : mnNegativeInfinity);
+		}
+		else if (x > 0.0f)
+		{
+			mPositive.add(bucketIndex(magnitude), 1, mnMaxBins);
+		}
+		else
+		{
+			mNegative.add(bucketIndex(magnitude), 1, mnMaxBins);
+		}
+	}
+
+	void QuantileSketch::add( const float* p, size_t n )
+	{
+		using namespace simd;
+		const vfloat multiplier = set1(mfMultiplier);
+		const vfloat scale = set1(1.0f / 8388608.0f);
+		const vint one = set1Int((int32_t)kOneBits);
+		const vint absMask = set1Int(0x7fffffff);
+
+		const size_t kChunk = 256;
+		int32_t index[kChunk];
+		for (size_t i=0; i<n; i += kChunk)
+		{
+			size_t m = (n - i < kChunk) ? (n - i) : kChunk;
+			const float* chunk = p + i;
+
+			// bucket indices of |x|, kWidth at a time (as bucketIndex);
+			// ceil(y) = -floor(-y)
+			size_t k = 0;
+			for (; k + kWidth <= m; k += kWidth)
+			{
+				vfloat l = toFloat((asInt(load(chunk + k)) & absMask) - one) * scale;
+				storeInt(index + k, toInt(-vfloor(-(l * multiplier))));
+			}
+			for (; k < m; ++k)
+			{
+				index[k] = bucketIndex(fabsf(chunk[k]));
+			}
+
+			// make room for the chunk's range once, then count
+			int32_t posLo = INT32_MAX, posHi = INT32_MIN;
+			int32_t negLo = INT32_MAX, negHi = INT32_MIN;
+			float lo = (mnCount == 0) ? chunk[0] : mfMin;
+			float hi = (mnCount == 0) ? chunk[0] : mfMax;
+			uint32_t nZero = 0;
+			uint32_t nPositiveInfinity = 0;
+			uint32_t nNegativeInfinity = 0;
+			for (k=0; k<m; ++k)
+			{
+				float x = chunk[k];
+				lo = (x < lo) ? x : lo;
+				hi = (x > hi) ? x : hi;
+				int32_t j = index[k];
+				if (!(fabsf(x) >= kMinIndexable))
+				{
+					++nZero;
+					index[k] = INT32_MIN;
+				}
+				else if (!(fabsf(x) <= FLT_MAX))
+				{
+					++((x > 0.0f) ? nPositiveInfinity : nNegativeInfinity);
+					index[k] = INT32_MIN;
+				}
+				else if (x > 0.0f)
+				{
+					posLo = (j < posLo) ? j : posLo;
+					posHi = (j > posHi) ? j : posHi;
+				}
+				else
+				{
+					negLo = (j < negLo) ? j : negLo;
+					negHi = (j > negHi) ? j : negHi;
+				}
+			}
+			int32_t posOffset = (posLo <= posHi) ? mPositive.extend(posLo, posHi, mnMaxBins) : 0;
+			int32_t negOffset = (negLo <= negHi) ? mNegative.extend(negLo, negHi, mnMaxBins) : 0;
+			for (k=0; k<m; ++k)
+			{
+				int32_t j = index[k];
+				if (j == INT32_MIN)
+				{
+					continue;
+				}
+				if (chunk[k] > 0.0f)
+				{
+					mPositive.mCounts[(j < posOffset) ? 0 : (size_t)(j - posOffset)] += 1;
+				}
+				else
+				{
+					mNegative.mCounts[(j < negOffset) ? 0 : (size_t)(j - negOffset)] += 1;
+				}
+			}
+
+			mfMin = lo;
+			mfMax = hi;
+			mnZeroCount += nZero;
+			mnPositiveInfinity += nPositiveInfinity;
+			mnNegativeInfinity += nNegativeInfinity;
+			mnCount += m;
+		}
+	}
+
+	// add the buckets of another sketch by value (different accuracy)
+	void QuantileSketch::addBuckets( const QuantileSketch& other, const Store& store, float sign )
+	{
+		for (size_t i=0; i<store.mCounts.size(); ++i)
+		{
+			if (store.mCounts[i] == 0)
+			{
+				continue;
+			}
+			float value = sign * other.bucketValue(store.mOffset + (int32_t)i);
+			Store& target = (sign > 0.0f) ? mPositive : mNegative;
+			target.add(bucketIndex(fabsf(value)), store.mCounts[i], mnMaxBins);
+		}
+	}
+
+	void QuantileSketch::merge( const QuantileSketch& other )
+	{
+		if (other.mnCount == 0)
+		{
+			return;
+		}
+		mfMin = (mnCount == 0 || other.mfMin < mfMin) ? other.mfMin : mfMin;
+		mfMax = (mnCount == 0 || other.mfMax > mfMax) ? other.mfMax : mfMax;
+		mnCount += other.mnCount;
+		mnZeroCount += other.mnZeroCount;
+		mnPositiveInfinity += other.mnPositiveInfinity;
+		mnNegativeInfinity += other.mnNegativeInfinity;
+
+		if (other.mfMultiplier != mfMultiplier)
+		{
+			addBuckets(other, other.mPositive, 1.0f);
+			addBuckets(other, other.mNegative, -1.0f);
+			return;
+		}
+		const Store* sources[2] = { &other.mPositive, &other.mNegative };
+		Store* targets[2] = { &mPositive, &mNegative };
+		for (int s=0; s<2; ++s)
+		{
+			const Store& source = *sources[s];
+			if (source.empty())
+			{
+				continue;
+			}
+			int32_t offset = targets[s]->extend(source.mOffset,
+				source.mOffset + (int32_t)source.mCounts.size() - 1, mnMaxBins);
+			std::vector<uint64_t>& counts = targets[s]->mCounts;
+			for (size_t i=0; i<source.mCounts.size(); ++i)
+			{
+				int32_t index = source.mOffset + (int32_t)i;
+				counts[(index < offset) ? 0 : (size_t)(index - offset)] += source.mCounts[i];
+			}
+		}
+	}
+
+	float QuantileSketch::quantile( float q ) const
+	{
+		if (mnCount == 0)
+		{
+			return 0.0f;
+		}
+		if (!(q > 0.0f))
+		{
+			return mfMin;
+		}
+		if (q >= 1.0f)
+		{
+			return mfMax;
+		}
+
+		// the value of rank q*(n - 1) (counting from 0), walking up from
+		// the most negative bucket
+		uint64_t rank = (uint64_t)((double)q * (double)(mnCount - 1));
+		uint64_t seen = mnNegativeInfinity;
+		float value = 0.0f;
+		bool bFound = (seen > rank);
+		if (bFound)
+		{
+			value = -INFINITY;
+		}
+		for (size_t i=mNegative.mCounts.size(); i-- > 0 && !bFound; )
+		{
+			seen += mNegative.mCounts[i];
+			if (seen > rank)
+			{
+				value = -bucketValue(mNegative.mOffset + (int32_t)i);
+				bFound = true;
+			}
+		}
+		if (!bFound)
+		{
+			seen += mnZeroCount;
+			bFound = (seen > rank);
+		}
+		for (size_t i=0; i<mPositive.mCounts.size() && !bFound; ++i)
+		{
+			seen += mPositive.mCounts[i];
+			if (seen > rank)
+			{
+				value = bucketValue(mPositive.mOffset + (int32_t)i);
+				bFound = true;
+			}
+		}
+		if (!bFound)
+		{
+			// only +infinity is left
+			return mfMax;
+		}
+		return (value < mfMin) ? mfMin : ((value > mfMax) ? mfMax : value);
+	}
+}
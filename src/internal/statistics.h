@@ -34,14 +34,285 @@ namespace stevesch
 		}
 	};
 
+	////////////////////////////////////////////////////////////////////////
+
+	// Single-pass accumulators for streams of samples.  Each one keeps O(1)
+	// state, takes one value at a time (push(x)) or an array (push(p, n),
+	// vectorized), and can merge() another accumulator of the same kind, so
+	// that partial results from different threads or cores combine into
+	// the result of the whole stream without rescanning the data.
+	//
+	// The mean is kept relative to the first sample, so that a stream with
+	// a large offset (e.g. a sensor reading 10000 +- 1) keeps the precision
+	// of its small variations.  push(p, n) processes the array in blocks:
+	// each block is reduced about its own mean (two passes over data
+	// already in cache) and then merged, which is both faster and more
+	// accurate than pushing the values one by one.
+
+	// Mean and variance (Welford's update; Chan et al.'s formula to merge).
+	class MeanVariance
+	{
+		uint32_t	mnCount;
+		float		mfShift;	// first sample
+		float		mfMean;		// mean - mfShift
+		float		mfM2;		// sum of squared differences from the mean
+
+	public:
+		MeanVariance() : mnCount(0), mfShift(0.0f), mfMean(0.0f), mfM2(0.0f) {}
+
+		void clear()	{ *this = MeanVariance(); }
+
+		void push( float x )
+		{
+			if (mnCount == 0)
+			{
+				mfShift = x;
+			}
+			x -= mfShift;
+			++mnCount;
+			float d = x - mfMean;
+			mfMean += d / (float)mnCount;
+			mfM2 += d * (x - mfMean);
+		}
+		void push( const float* p, size_t n );
+		void merge( const MeanVariance& other );
+
+		uint32_t count() const		{ return mnCount; }
+		float mean() const			{ return mfShift + mfMean; }
+		// population variance (divided by n); 0 for fewer than 2 samples
+		float variance() const		{ return (mnCount > 1) ? (mfM2 / (float)mnCount) : 0.0f; }
+		// unbiased sample variance (divided by n - 1)
+		float sampleVariance() const	{ return (mnCount > 1) ? (mfM2 / (float)(mnCount - 1)) : 0.0f; }
+		float stddev() const		{ return sqrtf(variance()); }
+		float sampleStddev() const	{ return sqrtf(sampleVariance()); }
+	};
+
+	// Mean, variance, skewness and kurtosis (Terriberry's update; Pebay's
+	// formulas to merge).
+	class Moments
+	{
+		uint32_t	mnCount;
+		float		mfShift;	// first sample
+		float		mfMean;		// mean - mfShift
+		float		mfM2;		// sums of powers of differences from the mean
+		float		mfM3;
+		float		mfM4;
+
+	public:
+		Moments() : mnCount(0), mfShift(0.0f), mfMean(0.0f), mfM2(0.0f), mfM3(0.0f), mfM4(0.0f) {}
+
+		void clear()	{ *this = Moments(); }
+
+		void push( float x )
+		{
+			if (mnCount == 0)
+			{
+				mfShift = x;
+			}
+			x -= mfShift;
+			float n1 = (float)mnCount;
+			float n = (float)(++mnCount);
+			float d = x - mfMean;
+			float dn = d / n;
+			float dn2 = dn * dn;
+			float term1 = d * dn * n1;
+			mfMean += dn;
+			mfM4 += term1 * dn2 * (n*n - 3.0f*n + 3.0f) + 6.0f * dn2 * mfM2 - 4.0f * dn * mfM3;
+			mfM3 += term1 * dn * (n - 2.0f) - 3.0f * dn * mfM2;
+			mfM2 += term1;
+		}
+		void push( const float* p, size_t n );
+		void merge( const Moments& other );
+
+		uint32_t count() const		{ return mnCount; }
+		float mean() const			{ return mfShift + mfMean; }
+		float variance() const		{ return (mnCount > 1) ? (mfM2 / (float)mnCount) : 0.0f; }
+		float sampleVariance() const	{ return (mnCount > 1) ? (mfM2 / (float)(mnCount - 1)) : 0.0f; }
+		float stddev() const		{ return sqrtf(variance()); }
+		// third standardized moment (0 for a symmetric distribution)
+		float skewness() const
+		{
+			return (mfM2 > 0.0f) ? (sqrtf((float)mnCount) * mfM3 / (mfM2 * sqrtf(mfM2))) : 0.0f;
+		}
+		// excess kurtosis: fourth standardized moment - 3 (0 for a normal distribution)
+		float kurtosis() const
+		{
+			return (mfM2 > 0.0f) ? ((float)mnCount * mfM4 / (mfM2 * mfM2) - 3.0f) : 0.0f;
+		}
+	};
+
+	// Smallest and largest value (NaN inputs give unspecified results).
+	class MinMax
+	{
+		uint32_t	mnCount;
+		float		mfMin;
+		float		mfMax;
+
+	public:
+		MinMax() : mnCount(0), mfMin(std::numeric_limits<float>::infinity()),
+			mfMax(-std::numeric_limits<float>::infinity()) {}
+
+		void clear()	{ *this = MinMax(); }
+
+		void push( float x )
+		{
+			++mnCount;
+			mfMin = (x < mfMin) ? x : mfMin;
+			mfMax = (x > mfMax) ? x : mfMax;
+		}
+		void push( const float* p, size_t n );
+		void merge( const MinMax& other );
+
+		uint32_t count() const	{ return mnCount; }
+		// meaningful only if count() > 0
+		float getMin() const	{ return mfMin; }
+		float getMax() const	{ return mfMax; }
+		float range() const		{ return mfMax - mfMin; }
+	};
+
+	// Exponentially weighted moving average and variance:
+	//   mean += alpha * (x - mean)
+	//   variance = (1 - alpha) * (variance + alpha * (x - mean)^2)
+	// The first sample initializes the mean.  Each update depends on the
+	// previous one, so push(p, n) is a plain loop, and there is no merge:
+	// the result depends on the order of the samples.
+	class Ewma
+	{
+		float		mfAlpha;
+		float		mfMean;
+		float		mfVariance;
+		uint32_t	mnCount;
+
+	public:
+		Ewma( float fAlpha=0.1f ) : mfAlpha(fAlpha), mfMean(0.0f), mfVariance(0.0f), mnCount(0) {}
+
+		// alpha for samples 'dt' apart that forgets with time constant 'tau'
+		// (the weight of a sample falls by 1/e after time tau)
+		static float alphaForTimeConstant( float dt, float tau )	{ return 1.0f - expf(-dt / tau); }
+
+		void setAlpha( float fAlpha )	{ mfAlpha = fAlpha; }
+		float getAlpha() const		{ return mfAlpha; }
+		void clear()				{ mfMean = 0.0f; mfVariance = 0.0f; mnCount = 0; }
+
+		void push( float x )
+		{
+			if (mnCount++ == 0)
+			{
+				mfMean = x;
+				return;
+			}
+			float d = x - mfMean;
+			float incr = mfAlpha * d;
+			mfMean += incr;
+			mfVariance = (1.0f - mfAlpha) * (mfVariance + d * incr);
+		}
+		void push( const float* p, size_t n )
+		{
+			for (size_t i=0; i<n; ++i)
+			{
+				push(p[i]);
+			}
+		}
+
+		uint32_t count() const	{ return mnCount; }
+		float mean() const		{ return mfMean; }
+		float variance() const	{ return mfVariance; }
+		float stddev() const	{ return sqrtf(mfVariance); }
+	};
+
+	// QuantileSketch estimates quantiles (median, p99, p999, ...) of an
+	// unbounded stream in bounded memory, with relative error: a DDSketch
+	// (Masson, Rim & Lee, 2019).  Values are counted in buckets whose
+	// bounds grow geometrically, so that any value in a bucket is within
+	// 'relativeAccuracy' of the bucket's representative value, and
+	// quantile(q) is within that relative error of the exact q-quantile of
+	// everything added (not just an approximation of its rank).
+	//
+	// The bucket of x is found from the bits of the float (exponent plus
+	// mantissa as a piecewise-linear log2), without calling log; this
+	// takes about 1.44x the buckets of an exact logarithmic mapping.  With
+	// the default 1% accuracy a decade of values needs ~170 buckets (8
+	// bytes each, 64-bit counts like the totals), so 1 us .. 10 s fits in ~1200.
+	//
+	// At most 'maxBins' buckets are kept for positive values (and as many
+	// for negative ones).  Beyond that the lowest buckets are combined,
+	// which loses accuracy only for the smallest values -- the quantiles
+	// of interest for latencies are the high ones.  Zero and values below
+	// ~1e-38 in magnitude are counted exactly as 0, and infinities apart
+	// from the buckets (a quantile that falls on them is +-infinity).
+	//
+	// Sketches with the same relativeAccuracy merge exactly, e.g. one per
+	// thread combined at the end.
+	class QuantileSketch
+	{
+		// counts of a contiguous range of bucket indices
+		struct Store
+		{
+			std::vector<uint64_t>	mCounts;
+			int32_t		mOffset;	// bucket index of mCounts[0]
+
+			Store() : mOffset(0) {}
+			bool empty() const	{ return mCounts.empty(); }
+			// make room for indices [lo, hi], keeping at most maxBins buckets;
+			// returns the lowest index kept
+			int32_t extend(int32_t lo, int32_t hi, uint32_t maxBins);
+			void add(int32_t index, uint64_t count, uint32_t maxBins);
+		};
+
+		Store		mPositive;
+		Store		mNegative;	// by bucket index of -x
+		uint64_t	mnZeroCount;
+		uint64_t	mnPositiveInfinity;
+		uint64_t	mnNegativeInfinity;
+		uint64_t	mnCount;
+		float		mfMin;
+		float		mfMax;
+		float		mfRelativeAccuracy;
+		float		mfMultiplier;	// buckets per unit of log2
+		uint32_t	mnMaxBins;
+
+		int32_t bucketIndex( float magnitude ) const;
+		float bucketValue( int32_t index ) const;
+		void addBuckets( const QuantileSketch& other, const Store& store, float sign );
+
+	public:
+		QuantileSketch( float relativeAccuracy=0.01f, uint32_t maxBins=2048 );
+
+		void clear();
+
+		void add( float x );
+		void add( const float* p, size_t n );
+		void merge( const QuantileSketch& other );
+
+		// q in [0, 1]: 0 gives getMin(), 1 getMax(); 0 if the sketch is empty
+		float quantile( float q ) const;
+
+		uint64_t count() const		{ return mnCount; }
+		float getMin() const		{ return mfMin; }
+		float getMax() const		{ return mfMax; }
+		float relativeAccuracy() const	{ return mfRelativeAccuracy; }
+		uint32_t binCount() const	{ return (uint32_t)(mPositive.mCounts.size() + mNegative.mCounts.size()); }
+		// bytes used by the buckets
+		size_t memoryBytes() const	{ return (mPositive.mCounts.capacity() + mNegative.mCounts.capacity()) * sizeof(uint64_t); }
+	};
+
 	////////////////////////////////////////////////////////////////////////
 	
+	// ProbabilityTable holds items with relative weights and picks among them
+	// with probability proportional to weight.
+	//
+	// insert() is O(1) (amortized) and get() is a binary search, O(log n).
+	// After the table has been filled, finalize() builds an alias table
+	// (Vose's method, O(n)) so that getRandom() takes constant time
+	// regardless of table size.  Inserting or clearing discards the alias
+	// table, and getRandom() falls back to the binary search until
+	// finalize() is called again.
 	template <typename T>
 	class ProbabilityTable
 	{
 		struct Weight
 		{
-			float	mfWeightAccum;	// sum of normalized weight and all previous normalized weights
+			float	mfWeightAccum;	// sum of this weight and all previous weights
 			float	mfWeight;
 			T		mData;
 
@@ -51,17 +322,40 @@ namespace stevesch
 			}
 		};
 
+		// alias method: slot i picks item i if a uniform 32-bit fraction is
+		// below mThreshold, and item mAlias otherwise
+		struct AliasEntry
+		{
+			uint32_t	mThreshold;
+			uint32_t	mAlias;
+		};
+
 		std::vector<Weight>	mTable;
+		std::vector<AliasEntry>	mAliasTable;	// empty unless finalized
+		float	mfWeightSum;
 
 	public:
 		// callbacks should return 'false' to terminate traversal
 		typedef bool (*TRAVERSAL_CALLBACK)(float fWeight, T& rData, void* pCallbackContext);
 
+		ProbabilityTable() : mfWeightSum(0.0f) {}
+
 		void insert( float fWeight, const T& crData );
+		// insert a range of (weight, data) pairs, e.g. std::pair<float, T>
+		template <typename Iterator>
+		void insert( Iterator first, Iterator last );
+
+		// Purpose: build the alias table used by getRandom.  Call after the last insert.
+		void finalize();
+		bool isFinalized() const	{ return !mAliasTable.empty(); }
+
 		const T* get( float fValue ) const;	// get data given a probability value in range [0.0, 1.0]
-		const T* getRandom( RandGen& r=S_RandGen ) const	{ return get( r.getFloat() ); }	// use uniform random distribution
+		const T* getAlias( uint32_t u ) const;	// get data given a uniform 32-bit value (requires finalize())
+		const T* getRandom( RandGen& r=defaultRandGen() ) const;	// use uniform random distribution
 		void clear();	// clear table
 
+		uint32_t size() const		{ return (uint32_t)mTable.size(); }
+
 		bool traverse(TRAVERSAL_CALLBACK pCallback, void* pCallbackContext);	// calls the specified callback for each
 																				// element currently in the table.
 																				// returns false if callback terminated
@@ -85,48 +379,121 @@ namespace stevesch
 	template <typename T>
 	void ProbabilityTable<T>::insert( float fWeight, const T& crData )
 	{
-		float fWeightSum = 0.0f;
-		float fWeightAccum = 0.0f;
-		float fInvWeightSum = 1.0f;
-		uint32_t i;
-
-    // mTable.push_back( Weight( fWeight, crData ) );
 		mTable.emplace_back( fWeight, crData );
-		
+		mfWeightSum += fWeight;
+		mTable.back().mfWeightAccum = mfWeightSum;
+		mAliasTable.clear();
+	}
+
+	template <typename T>
+	template <typename Iterator>
+	void ProbabilityTable<T>::insert( Iterator first, Iterator last )
+	{
+		for (; first != last; ++first)
+		{
+			mTable.emplace_back( first->first, first->second );
+			mfWeightSum += first->first;
+			mTable.back().mfWeightAccum = mfWeightSum;
+		}
+		mAliasTable.clear();
+	}
+
+	template <typename T>
+	void ProbabilityTable<T>::finalize()
+	{
 		const uint32_t cnTableSize = mTable.size();
+		mAliasTable.clear();
+		if ((cnTableSize == 0) || !(mfWeightSum > 0.0f))
+			return;
+
+		// weights scaled so that their average is 1; "small" entries (< 1) are
+		// topped up from "large" ones
+		std::vector<double> scaled(cnTableSize);
+		std::vector<uint32_t> small;
+		std::vector<uint32_t> large;
+		double fScale = (double)cnTableSize / (double)mfWeightSum;
+		uint32_t i;
 		for (i=0; i<cnTableSize; i++)
 		{
-			fWeightSum += mTable[i].mfWeight;
+			scaled[i] = mTable[i].mfWeight * fScale;
+			if (scaled[i] < 1.0)
+				small.push_back(i);
+			else
+				large.push_back(i);
+		}
+
+		mAliasTable.resize(cnTableSize);
+		while (!small.empty() && !large.empty())
+		{
+			uint32_t s = small.back();
+			uint32_t l = large.back();
+			small.pop_back();
+			double p = (scaled[s] > 0.0) ? scaled[s] : 0.0;
+			mAliasTable[s].mThreshold = (uint32_t)(p * 4294967296.0);
+			mAliasTable[s].mAlias = l;
+			scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+			if (scaled[l] < 1.0)
+			{
+				large.pop_back();
+				small.push_back(l);
+			}
 		}
-		
-		if (fWeightSum > 0.0f)
+		// whatever is left is 1 up to rounding error
+		for (i=0; i<small.size(); i++)
 		{
-			fInvWeightSum = recipf( fWeightSum );
+			mAliasTable[small[i]].mThreshold = 0xffffffffU;
+			mAliasTable[small[i]].mAlias = small[i];
 		}
-
-		for (i=0; i<cnTableSize; i++)
+		for (i=0; i<large.size(); i++)
 		{
-			fWeightAccum += mTable[i].mfWeight * fInvWeightSum;
-			mTable[i].mfWeightAccum = fWeightAccum;
+			mAliasTable[large[i]].mThreshold = 0xffffffffU;
+			mAliasTable[large[i]].mAlias = large[i];
 		}
-
-		// overkill (push past 1.0 to guarantee floating-point error doesn't interfere)
-		mTable[cnTableSize-1].mfWeightAccum = 1.0e+6f;
 	}
 
 	// get data given a probability value in range [0.0, 1.0]
 	template <typename T>
 	const T* ProbabilityTable<T>::get( float fValue ) const
 	{
-		const uint32_t cnTableSize = mTable.size();
-		uint32_t i;
-		for (i=0; i<cnTableSize; i++)
+		if (mTable.empty())
+			return NULL;	// fail (table is empty)
+
+		// first entry whose accumulated weight is >= fValue*sum; written so the
+		// compiler can use conditional moves rather than unpredictable branches
+		float fTarget = fValue * mfWeightSum;
+		uint32_t base = 0;
+		uint32_t len = mTable.size();
+		while (len > 1)
 		{
-			if ( fValue <= mTable[i].mfWeightAccum )
-				return &mTable[i].mData;
+			uint32_t half = len >> 1;
+			base = (mTable[base + half - 1].mfWeightAccum < fTarget) ? (base + half) : base;
+			len -= half;
 		}
+		uint32_t lo = base;
+		return &mTable[lo].mData;
+	}
 
-		return NULL;	// fail (table is empty or fValue is out of range [0.0, 1.0]
+	template <typename T>
+	const T* ProbabilityTable<T>::getAlias( uint32_t u ) const
+	{
+		if (mAliasTable.empty())
+			return NULL;	// fail (not finalized)
+
+		// high word of u*n picks the slot; the low word is a uniform fraction within it
+		uint64_t m = (uint64_t)u * mAliasTable.size();
+		uint32_t i = (uint32_t)(m >> 32);
+		const AliasEntry& e = mAliasTable[i];
+		if ((uint32_t)m >= e.mThreshold)
+			i = e.mAlias;
+		return &mTable[i].mData;
+	}
+
+	template <typename T>
+	const T* ProbabilityTable<T>::getRandom( RandGen& r ) const
+	{
+		if (mAliasTable.empty())
+			return get( r.getFloat() );
+		return getAlias( r.getU() );
 	}
 
 
@@ -135,6 +502,199 @@ namespace stevesch
 	void ProbabilityTable<T>::clear()
 	{
 		mTable.clear();
+		mAliasTable.clear();
+		mfWeightSum = 0.0f;
+	}
+
+	////////////////////////////////////////////////////////////////////////
+
+	// DynamicProbabilityTable is a ProbabilityTable whose weights may change
+	// after insertion.  Weights are kept in a Fenwick (binary indexed) tree of
+	// partial sums, so insert, updateWeight, remove and sampling are all
+	// O(log n) -- there is no per-change renormalization.
+	//
+	// insert() returns a handle that stays valid until the entry is removed;
+	// handles of removed entries are reused by later inserts.
+	template <typename T>
+	class DynamicProbabilityTable
+	{
+	public:
+		typedef uint32_t handle_t;
+		static const handle_t kInvalidHandle = 0xffffffffU;
+
+		DynamicProbabilityTable() : mfWeightSum(0.0), mnCount(0), mnChanges(0) {}
+
+		handle_t insert( float fWeight, const T& crData );
+		void updateWeight( handle_t h, float fWeight );
+		void remove( handle_t h );
+		void clear();	// clear table
+
+		float getWeight( handle_t h ) const		{ return mWeight[h]; }
+		T& getData( handle_t h )				{ return mData[h]; }
+		const T& getData( handle_t h ) const	{ return mData[h]; }
+		double getWeightSum() const				{ return mfWeightSum; }
+		uint32_t size() const					{ return mnCount; }	// number of (non-removed) entries
+
+		// Purpose: pick an entry given a probability value in range [0.0, 1.0].
+		// Returns kInvalidHandle if the table is empty or all weights are zero.
+		handle_t find( double fValue ) const;
+		handle_t sample( RandGen& r=defaultRandGen() ) const	{ return find( r.getU() * (1.0 / 4294967296.0) ); }
+
+		const T* get( float fValue ) const			{ return dataAt( find( fValue ) ); }	// get data given a probability value in range [0.0, 1.0]
+		const T* getRandom( RandGen& r=defaultRandGen() ) const	{ return dataAt( sample( r ) ); }	// use uniform random distribution
+
+	private:
+		const T* dataAt( handle_t h ) const	{ return (h == kInvalidHandle) ? NULL : &mData[h]; }
+
+		static inline uint32_t lowBit( uint32_t i )	{ return i & (0U - i); }
+
+		void addToTree( uint32_t i, double fDelta );	// i is 0-based
+		void rebuild();
+
+		std::vector<double>	mTree;		// 1-based Fenwick tree over a power-of-two capacity; mTree[0] unused
+		std::vector<float>	mWeight;	// 0 for removed entries
+		std::vector<T>		mData;
+		std::vector<uint8_t>	mLive;
+		std::vector<handle_t>	mFree;		// removed handles, reused by insert
+		double	mfWeightSum;
+		uint32_t	mnCount;
+		uint32_t	mnChanges;	// weight changes since the tree was last rebuilt
+	};
+
+
+	template <typename T>
+	typename DynamicProbabilityTable<T>::handle_t DynamicProbabilityTable<T>::insert( float fWeight, const T& crData )
+	{
+		++mnCount;
+		if (!mFree.empty())
+		{
+			handle_t h = mFree.back();
+			mFree.pop_back();
+			mData[h] = crData;
+			mLive[h] = 1;
+			updateWeight( h, fWeight );
+			return h;
+		}
+
+		const handle_t h = mWeight.size();
+		mWeight.push_back( 0.0f );
+		mData.push_back( crData );
+		mLive.push_back( 1 );
+		if (mWeight.size() + 1 >= mTree.size())
+		{
+			// grow the tree to the next power of two (keeping at least one
+			// unused entry, so a search past the end is detectable)
+			uint32_t nCapacity = (mTree.size() > 1) ? 2 * (mTree.size() - 1) : 16;
+			mTree.resize( nCapacity + 1 );
+			rebuild();
+		}
+		updateWeight( h, fWeight );
+		return h;
+	}
+
+	template <typename T>
+	void DynamicProbabilityTable<T>::updateWeight( handle_t h, float fWeight )
+	{
+		double fDelta = (double)fWeight - (double)mWeight[h];
+		mWeight[h] = fWeight;
+		mfWeightSum += fDelta;
+
+		// each change adds rounding error to the partial sums; refresh them
+		// once the changes outnumber the entries (amortized O(1) per change)
+		if (++mnChanges > mWeight.size() + 64)
+			rebuild();
+		else
+			addToTree( h, fDelta );
+	}
+
+	template <typename T>
+	void DynamicProbabilityTable<T>::remove( handle_t h )
+	{
+		if (!mLive[h])
+			return;
+		updateWeight( h, 0.0f );
+		mLive[h] = 0;
+		mFree.push_back( h );
+		--mnCount;
+	}
+
+	template <typename T>
+	void DynamicProbabilityTable<T>::clear()
+	{
+		mTree.clear();
+		mWeight.clear();
+		mData.clear();
+		mLive.clear();
+		mFree.clear();
+		mfWeightSum = 0.0;
+		mnCount = 0;
+		mnChanges = 0;
+	}
+
+	template <typename T>
+	typename DynamicProbabilityTable<T>::handle_t DynamicProbabilityTable<T>::find( double fValue ) const
+	{
+		const uint32_t n = mWeight.size();
+		if ((n == 0) || !(mfWeightSum > 0.0))
+			return kInvalidHandle;
+
+		// descend to the last position whose prefix sum is <= the target;
+		// the entry just past it is the first with a larger cumulative weight
+		// (so zero-weight entries are never picked)
+		double fTarget = fValue * mfWeightSum;
+		// (the tree size is a power of two, and unused entries have weight 0,
+		// so every step stays in bounds; select rather than branch as the
+		// direction is unpredictable)
+		uint32_t pos = 0;
+		for (uint32_t step=(mTree.size() - 1) >> 1; step != 0; step >>= 1)
+		{
+			double fNode = mTree[pos + step];
+			bool bTake = (fNode <= fTarget);
+			pos = bTake ? (pos + step) : pos;
+			fTarget -= bTake ? fNode : 0.0;
+		}
+
+		if (pos >= n)
+		{
+			// fValue >= 1.0 (or rounding error): take the last entry with weight
+			pos = n;
+			while ((pos > 0) && !(mWeight[pos - 1] > 0.0f))
+				--pos;
+			return (pos > 0) ? (pos - 1) : kInvalidHandle;
+		}
+		return pos;
+	}
+
+	template <typename T>
+	void DynamicProbabilityTable<T>::addToTree( uint32_t i, double fDelta )
+	{
+		const uint32_t nCapacity = mTree.size() - 1;
+		for (uint32_t k=i + 1; k<=nCapacity; k+=lowBit(k))
+		{
+			mTree[k] += fDelta;
+		}
+	}
+
+	template <typename T>
+	void DynamicProbabilityTable<T>::rebuild()
+	{
+		const uint32_t n = mWeight.size();
+		const uint32_t nCapacity = mTree.size() - 1;
+		double fSum = 0.0;
+		uint32_t i;
+		for (i=1; i<=nCapacity; i++)
+		{
+			mTree[i] = (i <= n) ? mWeight[i - 1] : 0.0;
+			fSum += mTree[i];
+		}
+		for (i=1; i<=nCapacity; i++)
+		{
+			uint32_t parent = i + lowBit(i);
+			if (parent <= nCapacity)
+				mTree[parent] += mTree[i];
+		}
+		mfWeightSum = fSum;
+		mnChanges = 0;
 	}
 
 	////////////////////////////////////////////////////////////////////////
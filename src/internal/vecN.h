@@ -0,0 +1,173 @@
+#ifndef STEVESCH_MATHBASE_INTERNAL_VECN_H_
+#define STEVESCH_MATHBASE_INTERNAL_VECN_H_
+// Fixed-size float vectors, e.g. for spline control points
+//
+// VecN<N> is a plain value type of N floats.  Every operator is a short
+// loop over a compile-time count, so after inlining a chain such as
+// ((a*u + b)*u + c)*u + d stays in registers and is emitted as a few
+// vector instructions; madd() spells out a fused a + b*s for code that
+// wants to be explicit about it.
+//
+// On targets with vector instructions (see simd.h) the storage is padded
+// to a whole number of 4-float registers and aligned to 16 bytes, so a
+// VecN<3> is operated on as one 4-lane register; the padding lanes are
+// kept at zero and never affect results.  Elsewhere (e.g. AVR, ESP32) a
+// VecN<N> is exactly N floats.
+
+#include <math.h>
+
+#include "simd.h"
+
+namespace stevesch
+{
+  namespace vecn
+  {
+#if defined(STEVESCH_SIMD_PORTABLE)
+    constexpr int storage(int n) { return n; }
+    constexpr int alignment(int) { return (int)sizeof(float); }
+#else
+    constexpr int storage(int n) { return (n >= 3) ? ((n + 3) & ~3) : n; }
+    constexpr int alignment(int n) { return (storage(n) % 4 == 0) ? 16 : (int)sizeof(float) * storage(n); }
+#endif
+  } // namespace vecn
+
+  template <int N>
+  struct alignas(vecn::alignment(N)) VecN
+  {
+    static_assert(N > 0, "VecN needs at least one component");
+    static constexpr int kSize = N;
+    static constexpr int kStorage = vecn::storage(N);
+
+    float v[kStorage];
+
+    VecN() : v{} {}
+    explicit VecN(float s) : v{}
+    {
+      for (int i=0; i<N; ++i) {
+        v[i] = s;
+      }
+    }
+    // one value per component, e.g. VecN<3>(x, y, z)
+    template <typename... Rest>
+    VecN(float x, float y, Rest... rest) : v{x, y, (float)rest...}
+    {
+      static_assert(2 + sizeof...(Rest) == N, "VecN needs exactly N components");
+    }
+
+    // N floats from p
+    static VecN load(const float* p)
+    {
+      VecN r;
+      for (int i=0; i<N; ++i) {
+        r.v[i] = p[i];
+      }
+      return r;
+    }
+    void store(float* p) const
+    {
+      for (int i=0; i<N; ++i) {
+        p[i] = v[i];
+      }
+    }
+
+    float& operator[](int i) { return v[i]; }
+    const float& operator[](int i) const { return v[i]; }
+
+    VecN& operator+=(const VecN& a)
+    {
+      for (int i=0; i<kStorage; ++i) {
+        v[i] += a.v[i];
+      }
+      return *this;
+    }
+    VecN& operator-=(const VecN& a)
+    {
+      for (int i=0; i<kStorage; ++i) {
+        v[i] -= a.v[i];
+      }
+      return *this;
+    }
+    VecN& operator*=(float s)
+    {
+      for (int i=0; i<kStorage; ++i) {
+        v[i] *= s;
+      }
+      return *this;
+    }
+    VecN& operator/=(float s) { return *this *= (1.0f / s); }
+  };
+
+  template <int N>
+  inline VecN<N> operator+(VecN<N> a, const VecN<N>& b) { return a += b; }
+  template <int N>
+  inline VecN<N> operator-(VecN<N> a, const VecN<N>& b) { return a -= b; }
+  template <int N>
+  inline VecN<N> operator*(VecN<N> a, float s) { return a *= s; }
+  template <int N>
+  inline VecN<N> operator*(float s, VecN<N> a) { return a *= s; }
+  template <int N>
+  inline VecN<N> operator/(VecN<N> a, float s) { return a /= s; }
+  template <int N>
+  inline VecN<N> operator-(const VecN<N>& a)
+  {
+    VecN<N> r;
+    for (int i=0; i<VecN<N>::kStorage; ++i) {
+      r.v[i] = -a.v[i];
+    }
+    return r;
+  }
+
+  template <int N>
+  inline bool operator==(const VecN<N>& a, const VecN<N>& b)
+  {
+    for (int i=0; i<N; ++i) {
+      if (a.v[i] != b.v[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+  template <int N>
+  inline bool operator!=(const VecN<N>& a, const VecN<N>& b) { return !(a == b); }
+
+  // a + b*s
+  template <int N>
+  inline VecN<N> madd(const VecN<N>& a, const VecN<N>& b, float s)
+  {
+    VecN<N> r;
+    for (int i=0; i<VecN<N>::kStorage; ++i) {
+      r.v[i] = a.v[i] + b.v[i] * s;
+    }
+    return r;
+  }
+
+  // component-wise product
+  template <int N>
+  inline VecN<N> mul(const VecN<N>& a, const VecN<N>& b)
+  {
+    VecN<N> r;
+    for (int i=0; i<VecN<N>::kStorage; ++i) {
+      r.v[i] = a.v[i] * b.v[i];
+    }
+    return r;
+  }
+
+  template <int N>
+  inline float dot(const VecN<N>& a, const VecN<N>& b)
+  {
+    float sum = 0.0f;
+    for (int i=0; i<N; ++i) {
+      sum += a.v[i] * b.v[i];
+    }
+    return sum;
+  }
+
+  template <int N>
+  inline float lengthSquared(const VecN<N>& a) { return dot(a, a); }
+  // (also what ArcLengthTable measures a VecN tangent with)
+  template <int N>
+  inline float length(const VecN<N>& a) { return sqrtf(dot(a, a)); }
+
+} // namespace stevesch
+
+#endif
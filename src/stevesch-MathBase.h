@@ -4,9 +4,15 @@
 #include "internal/mathBase.h"
 #include "internal/scalar.h"
 #include "internal/mathApprox.h"
+#include "internal/polyApprox.h"
 #include "internal/pid.h"
+#include "internal/pidBank.h"
+#include "internal/vecN.h"
 #include "internal/spline.h"
 #include "internal/statistics.h"
 #include "internal/histogram.h"
+#include "internal/concurrentHistogram.h"
+#include "internal/logHistogram.h"
+#include "internal/histogramND.h"
 
 #endif